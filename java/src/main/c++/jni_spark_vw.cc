@@ -6,6 +6,8 @@
 #include "learner.h"
 #include <algorithm>
 #include <exception>
+#include <sstream>
+#include <vector>
 
 jobject getJavaPrediction(JNIEnv* env, vw* all, example* ex);
 
@@ -669,6 +671,188 @@ JNIEXPORT jstring JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitExample_toStri
   }
 }
 
+// VW Batch
+JNIEXPORT jlong JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_initialize(JNIEnv* env, jclass, jlong vwPtr)
+{
+  auto* all = reinterpret_cast<vw*>(vwPtr);
+
+  try
+  {
+    example* ex = VW::alloc_examples(0, 1);
+    ex->interactions = &all->interactions;
+    all->p->lp.default_label(&ex->l);
+
+    return reinterpret_cast<jlong>(new VowpalWabbitExampleWrapper(all, ex));
+  }
+  catch (...)
+  {
+    rethrow_cpp_exception_as_java_exception(env);
+    return 0;
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_finish(JNIEnv* env, jobject batchObj)
+{
+  auto exWrapper = reinterpret_cast<VowpalWabbitExampleWrapper*>(get_native_pointer(env, batchObj));
+
+  try
+  {
+    VW::dealloc_example(exWrapper->_all->p->lp.delete_label, *exWrapper->_example);
+    ::free_it(exWrapper->_example);
+    delete exWrapper;
+  }
+  catch (...)
+  {
+    rethrow_cpp_exception_as_java_exception(env);
+  }
+}
+
+// the address of a direct buffer holding at least count elements of type T, nullptr after throwing otherwise
+template <typename T>
+T* getDirectBuffer(JNIEnv* env, jobject buffer, size_t count, const char* name)
+{
+  void* data = env->GetDirectBufferAddress(buffer);
+  jlong capacity = env->GetDirectBufferCapacity(buffer);
+  if (data == nullptr || capacity < 0 || static_cast<size_t>(capacity) / sizeof(T) < count)
+  {
+    std::ostringstream ostr;
+    ostr << name << " must be a direct buffer of at least " << count * sizeof(T) << " bytes";
+    throw_java_exception(env, "java/lang/IllegalArgumentException", ostr.str().c_str());
+    return nullptr;
+  }
+  return static_cast<T*>(data);
+}
+
+// Fills the example with each row in turn and learns from it or predicts for it, labels is nullptr to predict.
+void processBatch(JNIEnv* env, jobject batchObj, jint numRows, jcharArray namespaces, jobject offsets,
+    jobject indices, jobject values, jobject labels, jobject weights, jobject predictions)
+{
+  auto exWrapper = reinterpret_cast<VowpalWabbitExampleWrapper*>(get_native_pointer(env, batchObj));
+  vw* all = exWrapper->_all;
+  example* ex = exWrapper->_example;
+
+  if (all->l->pred_type != prediction_type_t::scalar || memcmp(&all->p->lp, &simple_label, sizeof(label_parser)))
+  {
+    throw_java_exception(env, "java/lang/UnsupportedOperationException",
+        "batches require simple labels and scalar predictions");
+    return;
+  }
+  if (numRows < 0)
+  {
+    throw_java_exception(env, "java/lang/IllegalArgumentException", "numRows must not be negative");
+    return;
+  }
+
+  // the namespaces are few, copying them keeps the buffers usable while learning
+  std::vector<jchar> ns(env->GetArrayLength(namespaces));
+  env->GetCharArrayRegion(namespaces, 0, (jsize)ns.size(), ns.data());
+  CHECK_JNI_EXCEPTION();
+
+  const size_t rows = (size_t)numRows;
+  auto* offsets0 = getDirectBuffer<jint>(env, offsets, rows * ns.size() + 1, "offsets");
+  CHECK_JNI_EXCEPTION();
+  const size_t numFeatures = (size_t)std::max(offsets0[rows * ns.size()], 0);
+  auto* indices0 = getDirectBuffer<jint>(env, indices, numFeatures, "indices");
+  CHECK_JNI_EXCEPTION();
+  auto* values0 = getDirectBuffer<jfloat>(env, values, numFeatures, "values");
+  CHECK_JNI_EXCEPTION();
+  auto* predictions0 = getDirectBuffer<jfloat>(env, predictions, rows, "predictions");
+  CHECK_JNI_EXCEPTION();
+  jfloat* labels0 = nullptr;
+  jfloat* weights0 = nullptr;
+  if (labels != nullptr)
+  {
+    labels0 = getDirectBuffer<jfloat>(env, labels, rows, "labels");
+    CHECK_JNI_EXCEPTION();
+    if (weights != nullptr)
+    {
+      weights0 = getDirectBuffer<jfloat>(env, weights, rows, "weights");
+      CHECK_JNI_EXCEPTION();
+    }
+  }
+
+  // check all offsets before learning, so that a bad batch leaves the model untouched
+  for (size_t i = 0; i < rows * ns.size(); i++)
+  {
+    if (offsets0[i] < 0 || offsets0[i] > offsets0[i + 1])
+    {
+      std::ostringstream ostr;
+      ostr << "offsets of row " << i / ns.size() << " must not be negative or decrease";
+      throw_java_exception(env, "java/lang/IllegalArgumentException", ostr.str().c_str());
+      return;
+    }
+  }
+
+  int mask = (1 << all->num_bits) - 1;
+
+  try
+  {
+    const jint* offset = offsets0;
+    for (size_t row = 0; row < rows; row++)
+    {
+      VW::empty_example(*all, *ex);
+
+      for (jchar n : ns)
+      {
+        const jint begin = *offset++;
+        const jint end = *offset;
+        if (begin == end)
+          continue;
+
+        addNamespaceIfNotExists(all, ex, n);
+        features& fs = ex->feature_space[(unsigned char)n];
+        for (jint i = begin; i < end; i++)
+          if (values0[i] != 0)
+            fs.push_back(values0[i], indices0[i] & mask);
+      }
+
+      all->p->lp.default_label(&ex->l);
+      if (labels0 != nullptr)
+      {
+        label_data* ld = (label_data*)&ex->l;
+        ld->label = labels0[row];
+        ld->weight = weights0 != nullptr ? weights0[row] : 1.f;
+
+        count_label(all->sd, ld->label);
+      }
+
+      VW::setup_example(*all, ex);
+
+      if (labels0 != nullptr)
+        all->learn(*ex);
+      else
+        all->predict(*ex);
+
+      // as this is not a ring-based example it is not free'd
+      VW::LEARNER::as_singleline(all->l)->finish_example(*all, *ex);
+
+      predictions0[row] = VW::get_prediction(ex);
+    }
+  }
+  catch (...)
+  {
+    rethrow_cpp_exception_as_java_exception(env);
+  }
+}
+
+JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_learnBatch(JNIEnv* env, jobject batchObj,
+    jint numRows, jcharArray namespaces, jobject offsets, jobject indices, jobject values, jobject labels,
+    jobject weights, jobject predictions)
+{
+  if (labels == nullptr)
+  {
+    throw_java_exception(env, "java/lang/IllegalArgumentException", "labels are required to learn");
+    return;
+  }
+  processBatch(env, batchObj, numRows, namespaces, offsets, indices, values, labels, weights, predictions);
+}
+
+JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_predictBatch(JNIEnv* env, jobject batchObj,
+    jint numRows, jcharArray namespaces, jobject offsets, jobject indices, jobject values, jobject predictions)
+{
+  processBatch(env, batchObj, numRows, namespaces, offsets, indices, values, nullptr, nullptr, predictions);
+}
+
 // re-use prediction conversation methods
 jobject multilabel_predictor(example* vec, JNIEnv* env);
 jfloatArray scalars_predictor(example* vec, JNIEnv* env);
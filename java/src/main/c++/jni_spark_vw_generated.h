@@ -178,6 +178,49 @@ extern "C"
    */
   JNIEXPORT jobject JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitExample_predict(JNIEnv *, jobject);
 
+#ifdef __cplusplus
+}
+#endif
+#endif
+/* Header for class org_vowpalwabbit_spark_VowpalWabbitBatch */
+
+#ifndef _Included_org_vowpalwabbit_spark_VowpalWabbitBatch
+#define _Included_org_vowpalwabbit_spark_VowpalWabbitBatch
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  /*
+   * Class:     org_vowpalwabbit_spark_VowpalWabbitBatch
+   * Method:    initialize
+   * Signature: (J)J
+   */
+  JNIEXPORT jlong JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_initialize(JNIEnv *, jclass, jlong);
+
+  /*
+   * Class:     org_vowpalwabbit_spark_VowpalWabbitBatch
+   * Method:    finish
+   * Signature: ()V
+   */
+  JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_finish(JNIEnv *, jobject);
+
+  /*
+   * Class:     org_vowpalwabbit_spark_VowpalWabbitBatch
+   * Method:    learnBatch
+   * Signature:
+   * (I[CLjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V
+   */
+  JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_learnBatch(
+      JNIEnv *, jobject, jint, jcharArray, jobject, jobject, jobject, jobject, jobject, jobject);
+
+  /*
+   * Class:     org_vowpalwabbit_spark_VowpalWabbitBatch
+   * Method:    predictBatch
+   * Signature: (I[CLjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V
+   */
+  JNIEXPORT void JNICALL Java_org_vowpalwabbit_spark_VowpalWabbitBatch_predictBatch(
+      JNIEnv *, jobject, jint, jcharArray, jobject, jobject, jobject, jobject);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,125 @@
+package org.vowpalwabbit.spark;
+
+import java.io.Closeable;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Learns from or predicts for many single line examples with simple labels in
+ * one call to the native code.
+ *
+ * <p>
+ * The examples are passed as columns in direct buffers of native byte order,
+ * which are read in place from their start regardless of their position:
+ * </p>
+ * <ul>
+ * <li>{@code namespaces}: the first character of each of the k namespaces of
+ * the rows.</li>
+ * <li>{@code offsets}: numRows * k + 1 ints. The features of namespace j of row
+ * r are those from {@code offsets[r * k + j]} up to
+ * {@code offsets[r * k + j + 1]}.</li>
+ * <li>{@code indices} and {@code values}: the int index and float value of each
+ * feature, pre-hashed as for
+ * {@link VowpalWabbitExample#addToNamespaceSparse}.</li>
+ * <li>{@code labels} and {@code weights}: a float per row. Without weights
+ * every row has a weight of 1.</li>
+ * <li>{@code predictions}: receives the float prediction of each row.</li>
+ * </ul>
+ *
+ * <p>
+ * A single native example is reused for every row, so the buffers can be
+ * reused across batches as well.
+ * </p>
+ */
+public class VowpalWabbitBatch implements Closeable {
+    /**
+     * Initializes the native example reused for the rows.
+     *
+     * @param vwNativePointer the associated VW instance.
+     * @return pointer to the native VowpalWabbitExampleWrapper data structure.
+     */
+    private static native long initialize(long vwNativePointer);
+
+    /**
+     * Frees the native resources.
+     */
+    private native void finish();
+
+    private native void learnBatch(int numRows, char[] namespaces, ByteBuffer offsets, ByteBuffer indices,
+            ByteBuffer values, ByteBuffer labels, ByteBuffer weights, ByteBuffer predictions);
+
+    private native void predictBatch(int numRows, char[] namespaces, ByteBuffer offsets, ByteBuffer indices,
+            ByteBuffer values, ByteBuffer predictions);
+
+    /**
+     * Pointer to the native VowpalWabbitExampleWrapper data structure.
+     */
+    private long nativePointer;
+
+    VowpalWabbitBatch(long vwNativePointer) {
+        this.nativePointer = initialize(vwNativePointer);
+    }
+
+    /**
+     * Updates the associated VW model using each row in turn.
+     *
+     * @param numRows     the number of rows.
+     * @param namespaces  the namespaces of the rows.
+     * @param offsets     where the features of each namespace of each row start.
+     * @param indices     the feature indices.
+     * @param values      the feature values.
+     * @param labels      the label of each row.
+     * @param weights     the weight of each row, or null.
+     * @param predictions receives the one-step ahead prediction of each row.
+     */
+    public void learn(int numRows, char[] namespaces, ByteBuffer offsets, ByteBuffer indices, ByteBuffer values,
+            ByteBuffer labels, ByteBuffer weights, ByteBuffer predictions) {
+        checkBuffer("offsets", offsets);
+        checkBuffer("indices", indices);
+        checkBuffer("values", values);
+        checkBuffer("labels", labels);
+        if (weights != null)
+            checkBuffer("weights", weights);
+        checkBuffer("predictions", predictions);
+
+        learnBatch(numRows, namespaces, offsets, indices, values, labels, weights, predictions);
+    }
+
+    /**
+     * Predicts for each row.
+     *
+     * @param numRows     the number of rows.
+     * @param namespaces  the namespaces of the rows.
+     * @param offsets     where the features of each namespace of each row start.
+     * @param indices     the feature indices.
+     * @param values      the feature values.
+     * @param predictions receives the prediction of each row.
+     */
+    public void predict(int numRows, char[] namespaces, ByteBuffer offsets, ByteBuffer indices, ByteBuffer values,
+            ByteBuffer predictions) {
+        checkBuffer("offsets", offsets);
+        checkBuffer("indices", indices);
+        checkBuffer("values", values);
+        checkBuffer("predictions", predictions);
+
+        predictBatch(numRows, namespaces, offsets, indices, values, predictions);
+    }
+
+    private static void checkBuffer(String name, ByteBuffer buffer) {
+        if (buffer == null || !buffer.isDirect())
+            throw new IllegalArgumentException(name + " must be a direct buffer");
+        if (buffer.order() != ByteOrder.nativeOrder())
+            throw new IllegalArgumentException(name + " must use the native byte order");
+    }
+
+    /**
+     * Frees the native resources.
+     */
+    @Override
+    final public void close() {
+        if (this.nativePointer != 0) {
+            finish();
+            this.nativePointer = 0;
+        }
+    }
+}
@@ -126,6 +126,16 @@ public class VowpalWabbitNative implements Closeable {
         return new VowpalWabbitExample(this.nativePointer, false);
     }
 
+    /**
+     * Creates a batch to learn from or predict for many examples at once,
+     * associated with this instance.
+     * 
+     * @return new {@code VowpalWabbitBatch} object.
+     */
+    public VowpalWabbitBatch createBatch() {
+        return new VowpalWabbitBatch(this.nativePointer);
+    }
+
     /**
      * Creates a new empty VW example associated with this this instance. This is
      * used to mark the end of a multiline example.
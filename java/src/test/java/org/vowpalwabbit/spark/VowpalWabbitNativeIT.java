@@ -3,6 +3,8 @@ package org.vowpalwabbit.spark;
 import org.junit.Test;
 import static org.junit.Assert.*;
 import java.io.*;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.file.*;
 import java.nio.charset.Charset;
 import java.nio.charset.StandardCharsets;
@@ -230,4 +232,70 @@ public class VowpalWabbitNativeIT {
                 vw.close();
         }
     }
+
+    private static ByteBuffer directBuffer(int elements) {
+        return ByteBuffer.allocateDirect(elements * 4).order(ByteOrder.nativeOrder());
+    }
+
+    @Test
+    public void testBatch() throws Exception {
+        int numRows = 100;
+        char[] namespaces = new char[] { 'a', 'b' };
+        int baseIndex = VowpalWabbitMurmur.hash("a", 0);
+
+        // row i: |a base:1 base+1:i |b base+2:0.5 for even rows
+        ByteBuffer offsets = directBuffer(numRows * namespaces.length + 1);
+        ByteBuffer indices = directBuffer(3 * numRows);
+        ByteBuffer values = directBuffer(3 * numRows);
+        ByteBuffer labels = directBuffer(numRows);
+        ByteBuffer predictions = directBuffer(numRows);
+
+        int numFeatures = 0;
+        offsets.putInt(0, 0);
+        for (int i = 0; i < numRows; i++) {
+            indices.putInt(numFeatures * 4, baseIndex);
+            values.putFloat(numFeatures++ * 4, 1f);
+            indices.putInt(numFeatures * 4, baseIndex + 1);
+            values.putFloat(numFeatures++ * 4, i);
+            offsets.putInt((2 * i + 1) * 4, numFeatures);
+
+            if (i % 2 == 0) {
+                indices.putInt(numFeatures * 4, baseIndex + 2);
+                values.putFloat(numFeatures++ * 4, 0.5f);
+            }
+            offsets.putInt((2 * i + 2) * 4, numFeatures);
+
+            labels.putFloat(i * 4, i % 2);
+        }
+
+        try (VowpalWabbitNative vw = new VowpalWabbitNative("--quiet");
+                VowpalWabbitNative vwRef = new VowpalWabbitNative("--quiet");
+                VowpalWabbitBatch batch = vw.createBatch();
+                VowpalWabbitExample ex = vwRef.createExample()) {
+            batch.learn(numRows, namespaces, offsets, indices, values, labels, null, predictions);
+
+            // the same rows one at a time
+            for (int i = 0; i < numRows; i++) {
+                ex.addToNamespaceSparse('a', new int[] { baseIndex, baseIndex + 1 }, new double[] { 1.0, i });
+                if (i % 2 == 0)
+                    ex.addToNamespaceSparse('b', new int[] { baseIndex + 2 }, new double[] { 0.5 });
+                ex.setLabel(i % 2);
+                ex.learn();
+
+                ScalarPrediction pred = (ScalarPrediction) ex.getPrediction();
+                assertEquals(pred.getValue(), predictions.getFloat(i * 4), 1e-6);
+
+                ex.clear();
+            }
+
+            batch.predict(numRows, namespaces, offsets, indices, values, predictions);
+            assertTrue(predictions.getFloat(4) > 0);
+
+            try {
+                batch.predict(numRows, namespaces, offsets, indices, values, ByteBuffer.allocate(4 * numRows));
+                fail("heap buffers are not supported");
+            } catch (IllegalArgumentException e) {
+            }
+        }
+    }
 }
\ No newline at end of file
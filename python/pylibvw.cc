@@ -11,6 +11,7 @@
 #include "search_hooktask.h"
 #include "parse_example.h"
 #include "gd.h"
+#include "best_constant.h"
 #include "options_serializer_boost_po.h"
 #include "future_compat.h"
 #include "slates_label.h"
@@ -272,6 +273,145 @@ void my_learn_multi_ex(vw_ptr& all, py::list& ec)
 void my_predict_multi_ex(vw_ptr& all, py::list& ec)
 { predict_or_learn<false>(all, ec); }
 
+// A one dimensional, C contiguous buffer of T exported by a Python object such as a NumPy array. formats lists the
+// struct codes accepted for T, whatever the byte order prefix.
+template <typename T>
+class buffer_view
+{ Py_buffer _view;
+
+public:
+  buffer_view(py::object& obj, const char* name, const char* formats, bool writable = false)
+  { int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj.ptr(), &_view, flags) != 0)
+    { PyErr_Clear();
+      THROW(name << " must be a contiguous" << (writable ? " and writable" : "") << " array");
+    }
+    const char* format = _view.format;
+    while (*format != 0 && strchr("@=<>!", *format)) format++;
+    if (_view.ndim != 1 || _view.itemsize != sizeof(T) || strlen(format) != 1 || !strchr(formats, *format))
+    { PyBuffer_Release(&_view);
+      THROW(name << " must be a one dimensional array of " << sizeof(T) << " byte '" << formats << "' items");
+    }
+  }
+  ~buffer_view() { PyBuffer_Release(&_view); }
+  buffer_view(const buffer_view&) = delete;
+  buffer_view& operator=(const buffer_view&) = delete;
+
+  T* data() { return static_cast<T*>(_view.buf); }
+  size_t size() const { return _view.len / sizeof(T); }
+};
+
+// Lets other Python threads run for the lifetime of the instance, which must not touch Python objects.
+class gil_release
+{ PyThreadState* _state;
+
+public:
+  gil_release() : _state(PyEval_SaveThread()) {}
+  ~gil_release() { PyEval_RestoreThread(_state); }
+  gil_release(const gil_release&) = delete;
+  gil_release& operator=(const gil_release&) = delete;
+};
+
+// Learns from the rows of a CSR matrix if labels is not None, or else predicts them, and sets predictions to the
+// prediction of each row. Column c of a row is the feature "c" of namespace namespaces[c] as in text input, where
+// namespaces holds a namespace per column or a single one for all of them. Zero values are left out.
+void my_learn_or_predict_csr(vw_ptr all, py::object indptr_obj, py::object indices_obj, py::object values_obj,
+                             py::object namespaces_obj, py::object labels_obj, py::object weights_obj, py::object predictions_obj)
+{ if (all->l->is_multiline || all->l->pred_type != prediction_type_t::scalar
+      || all->p->lp.parse_label != simple_label.parse_label)
+    THROW("batches require simple labels and scalar predictions");
+
+  buffer_view<int64_t> indptr(indptr_obj, "indptr", "lq");
+  buffer_view<int64_t> indices(indices_obj, "indices", "lq");
+  buffer_view<float> values(values_obj, "values", "f");
+  buffer_view<unsigned char> namespaces(namespaces_obj, "namespaces", "B");
+  buffer_view<float> predictions(predictions_obj, "predictions", "f", true);
+  const bool learn = !labels_obj.is_none();
+  std::unique_ptr<buffer_view<float>> labels, weights;
+  if (learn)
+  { labels.reset(new buffer_view<float>(labels_obj, "labels", "f"));
+    if (!weights_obj.is_none())
+      weights.reset(new buffer_view<float>(weights_obj, "weights", "f"));
+  }
+
+  if (indptr.size() == 0)
+    THROW("indptr must hold at least one offset");
+  if (namespaces.size() == 0)
+    THROW("namespaces must hold at least one namespace");
+  const size_t rows = indptr.size() - 1;
+  const int64_t* offsets = indptr.data();
+  if (indices.size() != values.size())
+    THROW("indices and values must have the same length");
+  if (predictions.size() != rows || (labels && labels->size() != rows) || (weights && weights->size() != rows))
+    THROW("predictions, labels and weights must have one item per row");
+  if (offsets[0] < 0 || (uint64_t)offsets[rows] > indices.size())
+    THROW("indptr must lie within indices");
+  for (size_t r = 0; r < rows; r++)
+    if (offsets[r] > offsets[r + 1])
+      THROW("indptr must not decrease, it does after row " << r);
+  // check the columns while holding the GIL, as nothing may throw once learning has started
+  const int64_t* columns = indices.data();
+  const float* column_values = values.data();
+  for (size_t r = 0; r < rows; r++)
+    for (int64_t i = offsets[r]; i < offsets[r + 1]; i++)
+      if (column_values[i] != 0.f && (columns[i] < 0 || (namespaces.size() != 1 && (uint64_t)columns[i] >= namespaces.size())))
+        THROW("column " << columns[i] << " of row " << r << " has no namespace");
+
+  // the hashes text input seeds the features of each namespace with
+  uint64_t channel_hash[256];
+  bool hashed[256] = {};
+  channel_hash[(unsigned char)' '] = all->hash_seed == 0 ? 0 : uniform_hash("", 0, all->hash_seed);
+  hashed[(unsigned char)' '] = true;
+  for (size_t c = 0; c < namespaces.size(); c++)
+  { const unsigned char ns = namespaces.data()[c];
+    if (!hashed[ns])
+    { channel_hash[ns] = VW::hash_space(*all, std::string(1, (char)ns));
+      hashed[ns] = true;
+    }
+  }
+
+  example_ptr ec = my_empty_example(all, lDEFAULT);
+
+  gil_release unlocked;
+  for (size_t r = 0; r < rows; r++)
+  { VW::empty_example(*all, *ec);
+    for (int64_t i = offsets[r]; i < offsets[r + 1]; i++)
+    { if (column_values[i] == 0.f)
+        continue;
+      const int64_t c = columns[i];
+      const unsigned char ns = namespaces.data()[namespaces.size() == 1 ? 0 : c];
+      features& fs = ec->feature_space[ns];
+      if (!fs.nonempty())
+        ec->indices.push_back(ns);
+      // hash the column as its decimal name, so that every --hash gives the feature of the text input
+      char name[20];
+      char* begin = name + sizeof(name);
+      uint64_t rest = (uint64_t)c;
+      do
+      { *--begin = (char)('0' + rest % 10);
+        rest /= 10;
+      } while (rest != 0);
+      const size_t length = name + sizeof(name) - begin;
+      fs.push_back(column_values[i], all->p->hash_token(begin, length, channel_hash[ns]) & all->parse_mask);
+    }
+
+    all->p->lp.default_label(&ec->l);
+    if (learn)
+    { ec->l.simple.label = labels->data()[r];
+      ec->l.simple.weight = weights ? weights->data()[r] : 1.f;
+      count_label(all->sd, ec->l.simple.label);
+    }
+    VW::setup_example(*all, ec.get());
+
+    if (learn)
+      all->learn(*ec);
+    else
+      as_singleline(all->l)->predict(*ec);
+    predictions.data()[r] = ec->pred.scalar;
+    as_singleline(all->l)->finish_example(*all, *ec);
+  }
+}
+
 std::string varray_char_to_string(v_array<char> &a)
 { std::string ret = "";
   for (auto c : a)
@@ -811,6 +951,7 @@ BOOST_PYTHON_MODULE(pylibvw)
 
   .def("learn_multi", &my_learn_multi_ex, "given a list pyvw examples, learn (and predict) on those examples")
   .def("predict_multi", &my_predict_multi_ex, "given a list of pyvw examples, predict on that example")
+  .def("_learn_or_predict_csr", &my_learn_or_predict_csr, "learn from or predict the rows of a CSR matrix given as buffers, releasing the GIL")
   .def("_parse", &my_parse, "Parse a string into a collection of VW examples")
   .def("_is_multiline", &my_is_multiline, "true if the base reduction is multiline")
 
@@ -353,6 +353,38 @@ def test_example_features():
     assert ex.pop_namespace()
 
 
+def test_learn_predict_batch():
+    np = pytest.importorskip("numpy")
+    sparse = pytest.importorskip("scipy.sparse")
+    X = sparse.csr_matrix(np.array([[1, 0, 2], [0, 0.5, 0], [3, 1, 0]], dtype=np.float32))
+    y = [1, -1, 0.5]
+    lines = ["1 |a 0:1 |b 2:2", "-1 |a 1:0.5", "0.5 |a 0:3 1:1"]
+
+    for hash in ["strings", "all"]:
+        model = vw(quiet=True, q="ab", hash=hash)
+        batch_model = vw(quiet=True, q="ab", hash=hash)
+        expected = []
+        for line in lines:
+            ex = model.example(line)
+            model.learn(ex)
+            expected.append(ex.get_simplelabel_prediction())
+        predictions = batch_model.learn_batch(X, y, namespaces="aab")
+        assert predictions.dtype == np.float32
+        assert np.allclose(predictions, expected)
+
+        expected = [model.predict(line.split(" ", 1)[1]) for line in lines]
+        predictions = batch_model.predict_batch(
+            (X.indptr, X.indices, X.data), namespaces=[ord("a"), ord("a"), ord("b")]
+        )
+        assert np.allclose(predictions, expected)
+        assert len(batch_model.predict_batch(X[:0])) == 0
+
+    # a column without a namespace is found before any row is learned from
+    check_error_raises(RuntimeError, lambda: batch_model.learn_batch(X, y, namespaces="ab"))
+    assert np.allclose(batch_model.predict_batch(X, namespaces="aab"), expected)
+    check_error_raises(RuntimeError, lambda: vw(quiet=True, oaa=3).predict_batch(X))
+
+
 def check_error_raises(type, argument):
     """
     This function is used to check whether the exception is raised or not.
@@ -473,6 +473,87 @@ class vw(pylibvw.vw):
 
         return prediction
 
+    def learn_batch(self, X, y, sample_weight=None, namespaces=None):
+        """Perform an online update on each row of a sparse matrix, in order
+
+        The examples are built and learned from in C++ without holding the
+        GIL. Column j of a row is the feature ``j`` of its namespace, as in
+        the text input ``|ns j:value``. Zero values are left out.
+        Requires simple labels and scalar predictions.
+
+        Parameters
+        ----------
+
+        X : scipy.sparse matrix or tuple of (indptr, indices, values)
+            rows to learn from, in CSR form
+        y : array-like, shape (n_rows,)
+            label of each row
+        sample_weight : array-like, shape (n_rows,), optional
+            importance weight of each row, 1 by default
+        namespaces : str or array-like of uint8, optional
+            namespace of each column, or a single one for all of them. By
+            default the columns are in the default namespace.
+
+        Returns
+        -------
+
+        predictions : numpy.ndarray of float32, shape (n_rows,)
+            prediction for each row before learning from it
+        """
+        return self._learn_or_predict_batch(X, y, sample_weight, namespaces)
+
+    def predict_batch(self, X, namespaces=None):
+        """Make a prediction on each row of a sparse matrix, see learn_batch
+
+        Parameters
+        ----------
+
+        X : scipy.sparse matrix or tuple of (indptr, indices, values)
+            rows to predict, in CSR form
+        namespaces : str or array-like of uint8, optional
+            namespace of each column, or a single one for all of them. By
+            default the columns are in the default namespace.
+
+        Returns
+        -------
+
+        predictions : numpy.ndarray of float32, shape (n_rows,)
+            prediction for each row
+        """
+        return self._learn_or_predict_batch(X, None, None, namespaces)
+
+    def _learn_or_predict_batch(self, X, y, sample_weight, namespaces):
+        import numpy as np
+
+        if isinstance(X, tuple):
+            indptr, indices, values = X
+        else:
+            X = X.tocsr()
+            indptr, indices, values = X.indptr, X.indices, X.data
+
+        if namespaces is None:
+            namespaces = " "
+        if isinstance(namespaces, str):
+            namespaces = np.frombuffer(namespaces.encode("latin-1"), dtype=np.uint8)
+
+        indptr = np.ascontiguousarray(indptr, dtype=np.int64)
+        if y is not None:
+            y = np.ascontiguousarray(y, dtype=np.float32)
+        if sample_weight is not None:
+            sample_weight = np.ascontiguousarray(sample_weight, dtype=np.float32)
+        predictions = np.empty(max(len(indptr) - 1, 0), dtype=np.float32)
+        pylibvw.vw._learn_or_predict_csr(
+            self,
+            indptr,
+            np.ascontiguousarray(indices, dtype=np.int64),
+            np.ascontiguousarray(values, dtype=np.float32),
+            np.ascontiguousarray(namespaces, dtype=np.uint8),
+            y,
+            sample_weight,
+            predictions,
+        )
+        return predictions
+
     def save(self, filename):
         """save model to disk"""
         pylibvw.vw.save(self, filename)
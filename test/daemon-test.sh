@@ -13,6 +13,7 @@ PREDREF=$NAME.predref
 PREDOUT=$NAME.predict
 NETCAT_STATUS=$NAME.netcat-status
 PORT=54248
+DaemonMode="--num_children 1"
 
 while [ $# -gt 0 ]
 do
@@ -23,6 +24,12 @@ do
         --json)
             JSON="$1"
             ;;    
+        --threads)
+            DaemonMode="--daemon_threads 2"
+            ;;
+        --batch)
+            DaemonBatch="--daemon_batch_size 8 --daemon_batch_wait 1000"
+            ;;
         *)
             echo "$NAME: unknown argument $1"
             exit 1
@@ -34,6 +41,12 @@ do
             --json)
                 JSON="$2"
                 ;;
+            --threads)
+                DaemonMode="--daemon_threads 2"
+                ;;
+            --batch)
+                DaemonBatch="--daemon_batch_size 8 --daemon_batch_wait 1000"
+                ;;
             *)
                 echo "$NAME: unknown argument $2"
                 exit 1
@@ -75,7 +88,7 @@ else
 fi
 
 # A command (+pattern) that is unlikely to match anything but our own test
-DaemonCmd="$VW -t -i $MODEL --daemon $Foreground --num_children 1 --quiet --port $PORT $JSON"
+DaemonCmd="$VW -t -i $MODEL --daemon $Foreground $DaemonMode $DaemonBatch --quiet --port $PORT $JSON"
 # libtool may wrap vw with '.libs/lt-vw' so we need to be flexible
 # on the exact process pattern we try to kill.
 DaemonPat=`echo $DaemonCmd | sed 's/^[^ ]*vw /.*vw /'`
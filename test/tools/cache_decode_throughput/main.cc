@@ -0,0 +1,152 @@
+#include <iostream>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "cache.h"
+#include "io/io_adapter.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+const char* to_string(VW::cache_decoder decoder)
+{
+  switch (decoder)
+  {
+    case VW::cache_decoder::scalar:
+      return "scalar";
+    case VW::cache_decoder::swar:
+      return "swar";
+    case VW::cache_decoder::bmi2:
+      return "bmi2";
+  }
+  return "unknown";
+}
+
+bool same_features(features& a, features& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (a.indicies[i] != b.indicies[i] || a.values[i] != b.values[i])
+      return false;
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_features;
+  size_t num_namespaces;
+  size_t repetitions;
+  uint32_t bits;
+  float float_fraction;
+
+  // clang-format off
+  po::options_description desc("Cache decode throughput tool - compare the decoders for cached features");
+  desc.add_options()
+    ("help,h", "Produce help message")
+    ("features,f", po::value<size_t>(&num_features)->default_value(64), "Features per namespace")
+    ("namespaces,n", po::value<size_t>(&num_namespaces)->default_value(10000), "Namespaces to decode per repetition")
+    ("repetitions,r", po::value<size_t>(&repetitions)->default_value(20), "Times to decode all namespaces")
+    ("bits,b", po::value<uint32_t>(&bits)->default_value(18), "Feature indices are drawn from [0, 2^bits)")
+    ("float_fraction", po::value<float>(&float_fraction)->default_value(0.f),
+        "Fraction of features with a value other than 1, chosen at random");
+  // clang-format on
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 1;
+  }
+
+  // Encode random namespaces with sorted indices, as in a cache written with sorted features.
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<uint64_t> index_dist(0, (UINT64_C(1) << bits) - 1);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  auto encoded = std::make_shared<std::vector<char>>();
+  std::vector<size_t> starts{0};
+  {
+    io_buf cache;
+    cache.add_file(VW::io::create_vector_writer(encoded));
+    features fs;
+    std::vector<uint64_t> indices(num_features);
+    for (size_t n = 0; n < num_namespaces; n++)
+    {
+      for (auto& index : indices) index = index_dist(rng);
+      std::sort(indices.begin(), indices.end());
+      fs.clear();
+      for (auto index : indices)
+      {
+        const float value = unit(rng) < float_fraction ? unit(rng) : 1.f;
+        fs.push_back(value, index);
+      }
+      output_features(cache, ' ', fs, UINT64_MAX);
+      cache.flush();
+      starts.push_back(encoded->size());
+    }
+  }
+
+  // Skip the namespace index and the size preceding every namespace.
+  const size_t prefix = sizeof(unsigned char) + sizeof(size_t);
+  const size_t bytes = encoded->size() - num_namespaces * prefix;
+
+  std::cout << "fastest decoder on this CPU: " << to_string(VW::fastest_cache_decoder()) << "\n";
+  std::vector<features> expected(num_namespaces);
+  const VW::cache_decoder decoders[] = {VW::cache_decoder::scalar, VW::cache_decoder::swar, VW::cache_decoder::bmi2};
+  for (auto decoder : decoders)
+  {
+    if (!VW::cache_decoder_supported(decoder))
+    {
+      std::cout << to_string(decoder) << ": not supported\n";
+      continue;
+    }
+
+    auto decode = VW::get_cached_features_decoder(decoder);
+    features fs;
+    bool sorted = true;
+    bool correct = true;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t r = 0; r < repetitions; r++)
+    {
+      for (size_t n = 0; n < num_namespaces; n++)
+      {
+        fs.clear();
+        decode(encoded->data() + starts[n] + prefix, encoded->data() + starts[n + 1], fs, sorted);
+        if (r == 0)
+        {
+          if (decoder == VW::cache_decoder::scalar)
+            expected[n].deep_copy_from(fs);
+          else
+            correct = correct && same_features(fs, expected[n]);
+        }
+      }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const auto time_in_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    const auto total_features = static_cast<double>(num_features) * num_namespaces * repetitions;
+    std::cout << to_string(decoder) << ": " << (bytes * repetitions / static_cast<double>(time_in_microseconds))
+              << "MB/s, " << (time_in_microseconds * 1e3 / total_features) << "ns/feature"
+              << (correct ? "" : ", MISMATCH against scalar") << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <exception>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "array_parameters_dense.h"
+#include "dense_dot.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+const char* to_string(VW::dense_dot_kernel kernel)
+{
+  switch (kernel)
+  {
+    case VW::dense_dot_kernel::scalar:
+      return "scalar";
+    case VW::dense_dot_kernel::avx2:
+      return "avx2";
+    case VW::dense_dot_kernel::avx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_features;
+  size_t num_namespaces;
+  size_t repetitions;
+  uint32_t bits;
+  uint32_t stride_shift;
+  bool huge_pages;
+
+  // clang-format off
+  po::options_description desc("Dense dot throughput tool - compare the kernels for linear predictions with dense weights");
+  desc.add_options()
+    ("help,h", "Produce help message")
+    ("features,f", po::value<size_t>(&num_features)->default_value(200), "Features per namespace")
+    ("namespaces,n", po::value<size_t>(&num_namespaces)->default_value(1000), "Distinct namespaces")
+    ("repetitions,r", po::value<size_t>(&repetitions)->default_value(100), "Times to process all namespaces")
+    ("bits,b", po::value<uint32_t>(&bits)->default_value(24), "Number of weight bits")
+    ("stride_shift", po::value<uint32_t>(&stride_shift)->default_value(2),
+        "Weights per feature as a power of 2, 2 as for adaptive and normalized updates")
+    ("huge_pages", po::bool_switch(&huge_pages), "Back the weights with transparent huge pages, see --huge_pages of vw");
+  // clang-format on
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 1;
+  }
+
+  VW::weight_memory_options memory_options;
+  if (huge_pages)
+    memory_options.huge_pages = VW::huge_page_mode::transparent;
+  dense_parameters weights(UINT64_C(1) << bits, stride_shift, memory_options);
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<float> unit(-1.f, 1.f);
+  for (auto& w : weights) w = unit(rng);
+
+  // Hashed feature indices are spread over the whole weight space, as after hashing feature names.
+  std::vector<features> namespaces(num_namespaces);
+  for (auto& fs : namespaces)
+    for (size_t f = 0; f < num_features; f++) fs.push_back(unit(rng), rng() << stride_shift);
+
+  std::cout << "fastest kernel on this CPU: " << to_string(VW::fastest_dense_dot_kernel()) << "\n";
+  double expected = 0.;
+  const VW::dense_dot_kernel kernels[] = {
+      VW::dense_dot_kernel::scalar, VW::dense_dot_kernel::avx2, VW::dense_dot_kernel::avx512};
+  for (auto kernel : kernels)
+  {
+    if (!VW::dense_dot_kernel_supported(kernel))
+    {
+      std::cout << to_string(kernel) << ": not supported\n";
+      continue;
+    }
+
+    auto dot = VW::get_dense_dot(kernel);
+    double checksum = 0.;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t r = 0; r < repetitions; r++)
+      for (size_t n = 0; n < num_namespaces; n++) checksum += dot(weights.first(), weights.mask(), namespaces[n], 0);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    if (kernel == VW::dense_dot_kernel::scalar)
+      expected = checksum;
+    const auto time_in_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    const auto total_features = static_cast<double>(num_features) * num_namespaces * repetitions;
+    // The kernels add up in different orders, so the checksums only agree up to rounding.
+    const bool correct = std::fabs(checksum - expected) <= 1e-4 * (1. + std::fabs(expected));
+    std::cout << to_string(kernel) << ": " << (time_in_nanoseconds / total_features) << "ns/feature, checksum "
+              << checksum << (correct ? "" : ", MISMATCH against scalar") << std::endl;
+  }
+
+  return 0;
+}
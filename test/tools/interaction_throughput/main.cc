@@ -0,0 +1,171 @@
+#include <iostream>
+#include <exception>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "array_parameters.h"
+#include "example_predict.h"
+#include "gd_predict.h"
+
+namespace po = boost::program_options;
+
+// Same weights as dense_parameters, but prefetched distance features ahead in the interaction kernel.
+template <size_t distance>
+class prefetched_weights
+{
+  dense_parameters& _weights;
+
+ public:
+  explicit prefetched_weights(dense_parameters& weights) : _weights(weights) {}
+  weight& operator[](size_t i) { return _weights[i]; }
+  const weight& operator[](size_t i) const { return _weights[i]; }
+};
+
+namespace INTERACTIONS
+{
+template <size_t distance>
+struct weight_prefetch_distance<prefetched_weights<distance>> : std::integral_constant<size_t, distance>
+{
+};
+}  // namespace INTERACTIONS
+
+namespace
+{
+inline void update_weight(float& rate, const float x, float& w) { w += rate * x; }
+
+struct workload
+{
+  std::vector<example_predict> examples;
+  std::vector<std::vector<namespace_index>> interactions;
+  std::array<bool, NUM_NAMESPACES> ignore_linear;
+  size_t features_per_example;
+  size_t repetitions;
+};
+
+template <class W>
+void run(const std::string& name, dense_parameters& dense, W& weights, workload& work)
+{
+  for (size_t i = 0; i < dense.stride(); i++) dense.set_zero(i);
+
+  float sum = 0.f;
+  float rate = 1e-6f;
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (size_t r = 0; r < work.repetitions; r++)
+  {
+    for (auto& ex : work.examples)
+    {
+      sum += GD::inline_predict<W>(weights, false, work.ignore_linear, work.interactions, false, ex);
+      GD::foreach_feature<float, float&, update_weight, W>(
+          weights, false, work.ignore_linear, work.interactions, false, ex, rate);
+    }
+  }
+  const auto end = std::chrono::high_resolution_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  // Both passes visit every feature.
+  const double features = 2. * work.repetitions * work.examples.size() * work.features_per_example;
+  std::cout << name << ": " << seconds * 1e9 / features << "ns/feature (checksum " << sum << ")\n";
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_features;
+  size_t num_examples;
+  workload work;
+  uint32_t bits;
+  uint32_t stride_shift;
+  std::vector<std::string> interactions;
+
+  // clang-format off
+  po::options_description desc("Interaction throughput tool - measure weight prefetching in the interaction kernel");
+  desc.add_options()
+    ("help,h", "Produce help message")
+    ("features,f", po::value<size_t>(&num_features)->default_value(30), "Features per namespace")
+    ("examples,e", po::value<size_t>(&num_examples)->default_value(2000), "Distinct examples")
+    ("repetitions,r", po::value<size_t>(&work.repetitions)->default_value(10), "Times to process all examples")
+    ("bits,b", po::value<uint32_t>(&bits)->default_value(26), "Number of weight bits")
+    ("stride_shift", po::value<uint32_t>(&stride_shift)->default_value(2),
+        "Weights per feature as a power of 2, 2 as for adaptive and normalized updates")
+    ("interactions,q", po::value<std::vector<std::string>>(&interactions)->composing(),
+        "Interactions between namespaces a, b, c, ..., as with -q and --cubic. Defaults to -q ab")
+    ("huge_pages", "Back the weights with transparent huge pages, see --huge_pages of vw");
+  // clang-format on
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 1;
+  }
+  if (interactions.empty())
+    interactions.push_back("ab");
+
+  work.ignore_linear.fill(false);
+  namespace_index last_namespace = 'a';
+  for (auto& interaction : interactions)
+  {
+    work.interactions.emplace_back(interaction.begin(), interaction.end());
+    for (auto ns : interaction) last_namespace = std::max<namespace_index>(last_namespace, ns);
+  }
+
+  // Feature indices are hashes, so they are uniformly distributed over the weights.
+  std::mt19937_64 rng(0);
+  work.features_per_example = 0;
+  for (size_t e = 0; e < num_examples; e++)
+  {
+    work.examples.emplace_back();
+    auto& ex = work.examples.back();
+    ex.ft_offset = 0;
+    for (namespace_index ns = 'a'; ns <= last_namespace; ns++)
+    {
+      ex.indices.push_back(ns);
+      for (size_t f = 0; f < num_features; f++) ex.feature_space[ns].push_back(1.f, rng() << stride_shift);
+    }
+  }
+  for (auto& interaction : work.interactions)
+  {
+    size_t count = 1;
+    for (size_t i = 0; i < interaction.size(); i++) count *= num_features;
+    work.features_per_example += count;
+  }
+  work.features_per_example += num_features * (last_namespace - 'a' + 1);
+
+  VW::weight_memory_options memory_options;
+  if (vm.count("huge_pages"))
+    memory_options.huge_pages = VW::huge_page_mode::transparent;
+  dense_parameters weights(UINT64_C(1) << bits, stride_shift, memory_options);
+  std::cout << work.features_per_example << " features per example, "
+            << ((UINT64_C(1) << (bits + stride_shift)) * sizeof(weight) >> 20) << "MB of weights in "
+            << weights.memory_description() << "\n";
+
+  prefetched_weights<4> distance_4(weights);
+  prefetched_weights<8> distance_8(weights);
+  prefetched_weights<16> distance_16(weights);
+  prefetched_weights<32> distance_32(weights);
+  // Every variant runs twice, so that warm up effects show in the first round. Checksums match if the results do.
+  for (size_t round = 0; round < 2; round++)
+  {
+    run("dense_parameters (distance " + std::to_string(VW_DENSE_WEIGHT_PREFETCH_DISTANCE) + ")", weights, weights,
+        work);
+    run("distance 4", weights, distance_4, work);
+    run("distance 8", weights, distance_8, work);
+    run("distance 16", weights, distance_16, work);
+    run("distance 32", weights, distance_32, work);
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <exception>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "queue.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+struct result
+{
+  double nanoseconds_per_item;
+  uint64_t checksum;
+};
+
+// Moves num_items pointers from the producers to the consumers through a queue of the given capacity. Each producer
+// pushes its share of items, the queue is marked done once all of them are through and the consumers pop until it is
+// drained. The checksum adds up the values of the items popped.
+template <typename TQueue>
+result run(size_t num_producers, size_t num_consumers, size_t num_items, size_t capacity)
+{
+  std::vector<uint64_t> values(num_items);
+  for (size_t i = 0; i < num_items; i++) values[i] = i;
+
+  TQueue queue(capacity);
+  std::vector<uint64_t> sums(num_consumers, 0);
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (size_t c = 0; c < num_consumers; c++)
+  {
+    consumers.emplace_back([&queue, &sums, c] {
+      uint64_t sum = 0;
+      while (uint64_t* item = queue.pop()) sum += *item;
+      sums[c] = sum;
+    });
+  }
+  for (size_t p = 0; p < num_producers; p++)
+  {
+    producers.emplace_back([&queue, &values, p, num_producers, num_items] {
+      for (size_t i = p; i < num_items; i += num_producers) queue.push(&values[i]);
+    });
+  }
+  for (auto& t : producers) t.join();
+  queue.set_done();
+  for (auto& t : consumers) t.join();
+  const auto end = std::chrono::high_resolution_clock::now();
+
+  uint64_t checksum = 0;
+  for (auto sum : sums) checksum += sum;
+  const auto time_in_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  return {static_cast<double>(time_in_nanoseconds) / num_items, checksum};
+}
+
+void report(const char* setup, size_t num_producers, size_t num_consumers, size_t num_items, size_t capacity)
+{
+  const uint64_t expected = static_cast<uint64_t>(num_items) * (num_items - 1) / 2;
+  const auto locked = run<VW::ptr_queue<uint64_t>>(num_producers, num_consumers, num_items, capacity);
+  const auto lock_free = run<VW::lock_free_ptr_queue<uint64_t>>(num_producers, num_consumers, num_items, capacity);
+  std::cout << setup << " (" << num_producers << " producers, " << num_consumers << " consumers)\n"
+            << "  ptr_queue:           " << locked.nanoseconds_per_item << "ns/item"
+            << (locked.checksum == expected ? "" : ", WRONG CHECKSUM") << "\n"
+            << "  lock_free_ptr_queue: " << lock_free.nanoseconds_per_item << "ns/item"
+            << (lock_free.checksum == expected ? "" : ", WRONG CHECKSUM") << "\n"
+            << "  speedup: " << (locked.nanoseconds_per_item / lock_free.nanoseconds_per_item) << "x" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_items;
+  size_t num_threads;
+  size_t capacity;
+
+  // clang-format off
+  po::options_description desc("Queue throughput tool - compare ptr_queue and lock_free_ptr_queue");
+  desc.add_options()
+    ("help,h", "Produce help message")
+    ("items,n", po::value<size_t>(&num_items)->default_value(1000000), "Items to pass through the queue per run")
+    ("threads,t", po::value<size_t>(&num_threads)->default_value(4),
+        "Consumers of the 1 to N run and producers of the N to 1 run")
+    ("capacity,c", po::value<size_t>(&capacity)->default_value(256), "Capacity of the queue");
+  // clang-format on
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << "\n";
+    return 1;
+  }
+
+  if (vm.count("help"))
+  {
+    std::cout << desc << "\n";
+    return 1;
+  }
+
+  if (num_threads == 0 || capacity == 0)
+  {
+    std::cerr << "error: threads and capacity must be positive\n";
+    return 1;
+  }
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+  // One reading thread handing out work to parse threads, as --parse_threads does.
+  report("1 to N", 1, num_threads, num_items, capacity);
+  // Several threads feeding a single learner.
+  report("N to 1", num_threads, 1, num_items, capacity);
+  report("1 to 1", 1, 1, num_items, capacity);
+  return 0;
+}
@@ -0,0 +1,181 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "accumulate.h"
+#include "allreduce.h"
+#include "vw.h"
+#include "vw_allreduce.h"
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t NODES = 4;
+
+void add(float& sum, const float& value) { sum += value; }
+
+// NODES instances syncing through threads, as a cluster of nodes would.
+struct cluster
+{
+  std::vector<vw*> nodes;
+
+  explicit cluster(const std::string& args, int bits = 8)
+  {
+    for (size_t node = 0; node < NODES; node++)
+    {
+      vw* all = VW::initialize(args + " --quiet -b " + std::to_string(bits), nullptr, false, nullptr, nullptr);
+      all->all_reduce_type = AllReduceType::Thread;
+      all->all_reduce = node == 0 ? new AllReduceThreads(NODES, 0)
+                                  : new AllReduceThreads((AllReduceThreads*)nodes[0]->all_reduce, NODES, node);
+      nodes.push_back(all);
+    }
+  }
+
+  ~cluster()
+  {
+    // The first node owns the synchronization of the others.
+    for (size_t node = NODES; node-- > 0;) VW::finish(*nodes[node]);
+  }
+
+  float& weight(size_t node, uint64_t i)
+  {
+    auto& weights = nodes[node]->weights.dense_weights;
+    return weights[i << weights.stride_shift()];
+  }
+
+  void run(std::function<void(vw&)> f)
+  {
+    std::vector<std::thread> threads;
+    for (vw* all : nodes) threads.emplace_back([all, &f]() { f(*all); });
+    for (auto& thread : threads) thread.join();
+  }
+
+  void average()
+  {
+    run([](vw& all) { accumulate_avg(all, all.weights, 0); });
+  }
+};
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(accumulate_avg_sparse_sync_test)
+{
+  cluster c("--sparse_sync");
+  for (size_t node = 0; node < NODES; node++)
+    for (uint64_t i = 0; i < 256; i++) c.weight(node, i) = 0.25f * i + node;
+  c.average();
+  for (size_t node = 0; node < NODES; node++)
+    for (uint64_t i = 0; i < 256; i++) BOOST_CHECK_EQUAL(c.weight(node, i), 0.25f * i + 1.5f);
+
+  // Only these changes are shipped now.
+  for (size_t node = 0; node < NODES; node++) c.weight(node, 3 * node) += 4.f * (node + 1);
+  c.average();
+  BOOST_CHECK(c.nodes[0]->weight_sync->words.size() < 256);
+  for (size_t node = 0; node < NODES; node++)
+    for (uint64_t i = 0; i < 256; i++)
+    {
+      float expected = 0.25f * i + 1.5f;
+      if (i % 3 == 0 && i / 3 < NODES)
+        expected += i / 3 + 1;
+      BOOST_CHECK_EQUAL(c.weight(node, i), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(accumulate_avg_sync_top_k_test)
+{
+  // One change per node and sync.
+  cluster c("--sparse_sync --sync_top_k 0.004 --sync_precision fp16");
+  c.average();
+  for (size_t node = 0; node < NODES; node++)
+  {
+    c.weight(node, 1) += 1.f / 3;
+    c.weight(node, 2) += 8.f;
+  }
+  c.average();
+  for (size_t node = 0; node < NODES; node++)
+  {
+    BOOST_CHECK_EQUAL(c.weight(node, 1), 0.f);
+    BOOST_CHECK_EQUAL(c.weight(node, 2), 8.f);
+  }
+
+  // What was left over goes next, and the rounding error of fp16 after that.
+  c.average();
+  const float rounded = c.weight(0, 1);
+  BOOST_CHECK_NE(rounded, 1.f / 3);
+  BOOST_CHECK_CLOSE(rounded, 1.f / 3, 0.1);
+  c.average();
+  for (size_t node = 0; node < NODES; node++)
+  {
+    BOOST_CHECK_LT(std::fabs(c.weight(node, 1) - 1.f / 3), std::fabs(rounded - 1.f / 3));
+    BOOST_CHECK_EQUAL(c.weight(node, 1), c.weight(0, 1));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(accumulate_sparse_sync_test)
+{
+  cluster c("--sparse_sync");
+  for (size_t node = 0; node < NODES; node++) c.weight(node, node + 10) = 1.f + node;
+  c.run([](vw& all) { accumulate(all, all.weights, 0); });
+  BOOST_CHECK(!c.nodes[0]->weight_sync->words.empty());
+  for (size_t node = 0; node < NODES; node++)
+    for (uint64_t i = 0; i < 256; i++)
+      BOOST_CHECK_EQUAL(c.weight(node, i), i >= 10 && i < 10 + NODES ? 1.f + (i - 10) : 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(accumulate_in_chunks_test)
+{
+  // Large enough to be summed in several chunks.
+  const uint64_t length = 1 << 20;
+  cluster c("", 20);
+  for (size_t node = 0; node < NODES; node++)
+    for (uint64_t i = 0; i < length; i++) c.weight(node, i) = static_cast<float>(i % 1000 + node);
+
+  std::vector<std::vector<std::pair<uint64_t, uint64_t>>> chunks(NODES);
+  // Not vector<bool>, whose elements share bytes and cannot be written by the nodes at the same time.
+  std::vector<char> summed(NODES, 1);
+  c.run([&](vw& all) {
+    const size_t node = all.all_reduce->node;
+    auto& weights = all.weights.dense_weights;
+    accumulate(all, all.weights, 0, [&](uint64_t begin, uint64_t end) {
+      chunks[node].emplace_back(begin, end);
+      for (uint64_t i = begin; i < end; i++)
+        if (weights[i << weights.stride_shift()] != static_cast<float>(NODES * (i % 1000) + 6))
+          summed[node] = 0;
+    });
+  });
+
+  for (size_t node = 0; node < NODES; node++)
+  {
+    BOOST_CHECK(summed[node]);
+    BOOST_CHECK_GT(chunks[node].size(), 1);
+    uint64_t next = 0;
+    for (const auto& chunk : chunks[node])
+    {
+      BOOST_CHECK_EQUAL(chunk.first, next);
+      next = chunk.second;
+    }
+    BOOST_CHECK_EQUAL(next, length);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(all_reduce_async_test)
+{
+  cluster c("");
+  std::vector<std::vector<float>> buffers(NODES);
+  c.run([&](vw& all) {
+    const size_t node = all.all_reduce->node;
+    buffers[node].assign(1000, static_cast<float>(node));
+    std::future<void> reduced = VW::all_reduce_async<float, add>(all, buffers[node].data(), buffers[node].size());
+    reduced.get();
+  });
+
+  for (size_t node = 0; node < NODES; node++)
+    for (float sum : buffers[node]) BOOST_CHECK_EQUAL(sum, 6.f);
+}
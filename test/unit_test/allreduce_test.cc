@@ -0,0 +1,84 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "allreduce.h"
+#include "spanning_tree.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void add(float& a, const float& b) { a += b; }
+
+// Every node sums vectors of several sizes with every algorithm and reports the first mismatch, if any.
+std::string run_node(uint16_t port, size_t unique_id, size_t total, size_t node)
+{
+  try
+  {
+    AllReduceSockets all_reduce("localhost", port, unique_id, total, node, true);
+    for (auto algorithm : {AllReduceAlgorithm::Tree, AllReduceAlgorithm::Ring, AllReduceAlgorithm::HalvingDoubling,
+             AllReduceAlgorithm::Automatic})
+    {
+      all_reduce.algorithm = algorithm;
+      for (size_t n : {1, 3, 1000, 70001, 1 << 21})
+      {
+        std::vector<float> values(n);
+        for (size_t i = 0; i < n; i++) values[i] = static_cast<float>((node + 1) * (i % 7));
+        all_reduce.all_reduce<float, add>(values.data(), n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+          const float expected = static_cast<float>(total * (total + 1) / 2 * (i % 7));
+          if (values[i] != expected)
+            return "algorithm " + std::to_string(static_cast<int>(algorithm)) + " size " + std::to_string(n) +
+                " element " + std::to_string(i) + ": " + std::to_string(values[i]) +
+                " != " + std::to_string(expected);
+        }
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    return e.what();
+  }
+  return "";
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(allreduce_sockets_algorithms_agree_test)
+{
+  VW::SpanningTree spanning_tree(0, true);
+  spanning_tree.Start();
+
+  for (size_t total : {2, 3, 4, 5, 8})
+  {
+    std::vector<std::string> errors(total);
+    std::vector<std::thread> nodes;
+    for (size_t node = 0; node < total; node++)
+      nodes.emplace_back([&, node]() { errors[node] = run_node(spanning_tree.BoundPort(), total, total, node); });
+    for (auto& thread : nodes) thread.join();
+
+    for (size_t node = 0; node < total; node++) BOOST_CHECK_MESSAGE(errors[node].empty(), errors[node]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(allreduce_sockets_algorithm_by_size_test)
+{
+  AllReduceSockets five("localhost", 0, 0, 5, 0, true);
+  BOOST_CHECK(five.algorithm_for(4) == AllReduceAlgorithm::Tree);
+  BOOST_CHECK(five.algorithm_for(ar_tree_max_bytes) == AllReduceAlgorithm::HalvingDoubling);
+  BOOST_CHECK(five.algorithm_for(ar_ring_min_bytes) == AllReduceAlgorithm::Ring);
+
+  five.algorithm = AllReduceAlgorithm::Tree;
+  BOOST_CHECK(five.algorithm_for(ar_ring_min_bytes) == AllReduceAlgorithm::Tree);
+
+  AllReduceSockets one("localhost", 0, 0, 1, 0, true);
+  one.algorithm = AllReduceAlgorithm::Ring;
+  BOOST_CHECK(one.algorithm_for(ar_ring_min_bytes) == AllReduceAlgorithm::Tree);
+}
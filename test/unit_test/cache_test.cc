@@ -0,0 +1,160 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "cache.h"
+#include "parser.h"
+#include "vw.h"
+#include "io/io_adapter.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+uint64_t write_cache_header(io_buf& output, uint32_t num_bits)
+{
+  const std::string version = VW::version.to_string();
+  size_t v_length = version.length() + 1;
+  output.bin_write_fixed(reinterpret_cast<const char*>(&v_length), sizeof(v_length));
+  output.bin_write_fixed(version.c_str(), v_length);
+  output.bin_write_fixed(&VW::BLOCK_CACHE_MARKER, 1);
+  output.bin_write_fixed(reinterpret_cast<const char*>(&num_bits), sizeof(num_bits));
+  return sizeof(v_length) + v_length + 1 + sizeof(num_bits);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(block_cache_round_trip_test)
+{
+  auto& vw = *VW::initialize("--quiet", nullptr, false, nullptr, nullptr);
+  const std::string file_name = "block_cache_round_trip.tmp";
+  // Enough examples to fill more than one block.
+  const size_t num_examples = 20000;
+
+  for (bool compress : {false, true})
+  {
+    uint64_t header_size;
+    {
+      io_buf output;
+      output.add_file(VW::io::open_file_writer(file_name));
+      header_size = write_cache_header(output, vw.num_bits);
+      VW::cache_block_writer writer(output, header_size, compress);
+      for (size_t i = 0; i < num_examples; i++)
+      {
+        auto* ex = VW::read_example(vw, (i % 2 == 0 ? "1 | a b f" : "-1 | a b f") + std::to_string(i));
+        vw.p->lp.cache_label(&ex->l, writer.example_buf());
+        cache_features(writer.example_buf(), ex, vw.parse_mask);
+        writer.end_example();
+        VW::finish_example(vw, *ex);
+      }
+      writer.finish();
+    }
+
+    std::vector<VW::cache_index_entry> blocks;
+    BOOST_CHECK(VW::read_cache_index(file_name, blocks));
+    BOOST_CHECK_GT(blocks.size(), 1);
+    BOOST_CHECK_EQUAL(blocks[0].offset, header_size);
+    uint64_t indexed_examples = 0;
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+      if (b > 0)
+        BOOST_CHECK_GT(blocks[b].offset, blocks[b - 1].offset);
+      indexed_examples += blocks[b].num_examples;
+    }
+    BOOST_CHECK_EQUAL(indexed_examples, num_examples);
+
+    io_buf input;
+    input.add_file(VW::io::open_mmap_file_reader(file_name));
+    char* header;
+    BOOST_CHECK_EQUAL(input.buf_read(header, header_size), header_size);
+
+    VW::cache_block_reader reader;
+    size_t read_examples = 0;
+    while (true)
+    {
+      auto& ex = VW::get_unused_example(&vw);
+      const bool more = reader.read_example(vw, input, &ex) > 0;
+      if (more)
+      {
+        BOOST_CHECK_EQUAL(ex.l.simple.label, read_examples % 2 == 0 ? 1.f : -1.f);
+        BOOST_CHECK_EQUAL(ex.feature_space[' '].size(), 3);
+        read_examples++;
+      }
+      VW::clean_example(vw, ex, true);
+      if (!more)
+        break;
+    }
+    BOOST_CHECK_EQUAL(read_examples, num_examples);
+  }
+
+  std::remove(file_name.c_str());
+  VW::finish(vw);
+}
+
+BOOST_AUTO_TEST_CASE(block_cache_index_missing_test)
+{
+  // A cache that is still being written has no index yet.
+  const std::string file_name = "block_cache_index_missing.tmp";
+  {
+    io_buf output;
+    output.add_file(VW::io::open_file_writer(file_name));
+    write_cache_header(output, 18);
+    output.flush();
+  }
+
+  std::vector<VW::cache_index_entry> blocks;
+  BOOST_CHECK(!VW::read_cache_index(file_name, blocks));
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(cache_decoders_agree_test)
+{
+  // Mixes varints of every length, including some longer than 8 bytes, with all three kinds of values. The format keeps
+  // 61 bits of each index difference.
+  features fs;
+  uint64_t index = 0;
+  for (size_t i = 0; i < 300; i++)
+  {
+    index += (i % 7 == 0) ? (UINT64_C(1) << (i % 58)) : i;
+    const float value = i % 3 == 0 ? 1.f : i % 3 == 1 ? -1.f : 0.25f * i;
+    fs.push_back(value, i % 11 == 0 ? index / 2 : index);
+  }
+
+  auto encoded = std::make_shared<std::vector<char>>();
+  io_buf output;
+  output.add_file(VW::io::create_vector_writer(encoded));
+  output_features(output, 'a', fs, static_cast<uint64_t>(-1));
+  output.flush();
+  char* begin = encoded->data() + sizeof(unsigned char) + sizeof(size_t);
+  char* end = encoded->data() + encoded->size();
+
+  features expected;
+  bool expected_sorted = true;
+  VW::get_cached_features_decoder(VW::cache_decoder::scalar)(begin, end, expected, expected_sorted);
+  BOOST_CHECK_EQUAL(expected.size(), fs.size());
+  BOOST_CHECK_EQUAL(expected_sorted, false);
+  for (size_t i = 0; i < fs.size(); i++)
+  {
+    BOOST_CHECK_EQUAL(expected.values[i], fs.values[i]);
+    BOOST_CHECK_EQUAL(expected.indicies[i], fs.indicies[i]);
+  }
+
+  for (auto decoder : {VW::cache_decoder::swar, VW::cache_decoder::bmi2})
+  {
+    if (!VW::cache_decoder_supported(decoder))
+      continue;
+    features actual;
+    bool sorted = true;
+    VW::get_cached_features_decoder(decoder)(begin, end, actual, sorted);
+    BOOST_CHECK_EQUAL(sorted, expected_sorted);
+    BOOST_CHECK_EQUAL(actual.sum_feat_sq, expected.sum_feat_sq);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        actual.values.begin(), actual.values.end(), expected.values.begin(), expected.values.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        actual.indicies.begin(), actual.indicies.end(), expected.indicies.begin(), expected.indicies.end());
+  }
+}
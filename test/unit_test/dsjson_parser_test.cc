@@ -696,3 +696,45 @@ BOOST_AUTO_TEST_CASE(parse_dsjson_slates_dom_parser)
   VW::finish_example(*ccb_vw, ccb_examples);
   VW::finish(*ccb_vw);
 }
+
+void finish_examples(vw& all, v_array<example*>& examples)
+{
+  multi_ex finished(examples.begin(), examples.end());
+  VW::finish_example(all, finished);
+  examples.clear();
+}
+
+BOOST_AUTO_TEST_CASE(parse_dsjson_threaded_reuses_parser)
+{
+  std::string labeled =
+      R"({"_label_cost":-1,"_label_probability":0.5,"_label_Action":2,"_labelIndex":1,"a":[2,1],)"
+      R"("c":{"shared_ns":{"shared_feature":0},"_multi":[{"ns1":{"f1":1}},{"ns1":{"f2":1}}]},"p":[0.5,0.5]})";
+  std::string unlabeled = R"({"a":[1,2],"c":{"_multi":[{"ns1":{"f1":1}},{"ns1":{"f2":1}}]},"p":[0.5,0.5]})";
+  std::string checkpoint = R"([{"RewardValue":1}])";
+
+  auto vw = VW::initialize("--dsjson --cb_adf --no_stdin --quiet", nullptr, false, nullptr, nullptr);
+  json_parser<false> parser;
+  std::vector<VW::string_view> words;
+  std::mutex label_lock;
+  auto examples = v_init<example*>();
+
+  parse_line_json_threaded<false>(vw, &labeled[0], labeled.size(), examples, parser, words, &label_lock);
+  // The shared example, the actions and the empty example ending the multiline example.
+  BOOST_CHECK_EQUAL(examples.size(), 4);
+  BOOST_CHECK_EQUAL(examples[1]->l.cb.costs.size(), 0);
+  BOOST_CHECK_EQUAL(examples[2]->l.cb.costs.size(), 1);
+  finish_examples(*vw, examples);
+
+  // Nothing of the label of the previous line is left in the parser.
+  parse_line_json_threaded<false>(vw, &unlabeled[0], unlabeled.size(), examples, parser, words, &label_lock);
+  BOOST_CHECK_EQUAL(examples.size(), 4);
+  for (auto* ex : examples) BOOST_CHECK_EQUAL(ex->l.cb.costs.size(), ex == examples[0] ? 1u : 0u);
+  finish_examples(*vw, examples);
+
+  // Lines that do not hold an interaction leave no examples.
+  parse_line_json_threaded<false>(vw, &checkpoint[0], checkpoint.size(), examples, parser, words, &label_lock);
+  BOOST_CHECK_EQUAL(examples.size(), 0);
+
+  examples.delete_v();
+  VW::finish(*vw);
+}
@@ -0,0 +1,100 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "hash_cache.h"
+#include "hashstring.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+uint64_t hash_string(const std::string& s, uint64_t seed) { return hashstring(s.data(), s.size(), seed); }
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(hash_cache_matches_hasher_and_counts_hits)
+{
+  VW::hash_cache cache(1024, hashstring);
+  const std::vector<std::string> tokens{"a", "price", "12345", " padded ", "", "a_somewhat_longer_feature_name"};
+
+  for (const auto& token : tokens)
+    BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), 7), hash_string(token, 7));
+  auto stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.hits, 0);
+  BOOST_CHECK_EQUAL(stats.lookups(), tokens.size());
+
+  for (const auto& token : tokens)
+    BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), 7), hash_string(token, 7));
+  stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.lookups(), 2 * tokens.size());
+  BOOST_CHECK_EQUAL(stats.hits + stats.misses, stats.lookups());
+  BOOST_CHECK_GE(stats.hits, 1);
+}
+
+BOOST_AUTO_TEST_CASE(hash_cache_keys_on_seed)
+{
+  VW::hash_cache cache(1024, hashstring);
+  const std::string token = "feature";
+  for (uint64_t seed = 0; seed < 100; seed++)
+  {
+    BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), seed), hash_string(token, seed));
+    BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), seed), hash_string(token, seed));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hash_cache_bypasses_long_tokens)
+{
+  VW::hash_cache cache(16, hashall);
+  const std::string token(VW::hash_cache::MAX_TOKEN_LENGTH + 1, 'x');
+  BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), 3), hashall(token.data(), token.size(), 3));
+  BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), 3), hashall(token.data(), token.size(), 3));
+  const auto stats = cache.stats();
+  BOOST_CHECK_EQUAL(stats.bypasses, 2);
+  BOOST_CHECK_EQUAL(stats.hits, 0);
+}
+
+BOOST_AUTO_TEST_CASE(hash_cache_evicts_when_full)
+{
+  VW::hash_cache cache(10, hashstring);
+  BOOST_CHECK_EQUAL(cache.capacity(), 16);
+
+  // Many more tokens than entries, including prefixes of one another which only differ in length.
+  std::string token;
+  for (int round = 0; round < 3; round++)
+  {
+    token.clear();
+    for (int i = 0; i < 40; i++)
+    {
+      token.push_back(static_cast<char>('a' + i % 26));
+      BOOST_CHECK_EQUAL(cache.hash(token.data(), token.size(), round), hash_string(token, round));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hash_cache_is_shared_by_threads)
+{
+  VW::hash_cache cache(256, hashstring);
+  std::vector<std::string> tokens;
+  for (int i = 0; i < 500; i++) tokens.push_back("token" + std::to_string(i % 100));
+
+  std::vector<int> mismatches(4, 0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < mismatches.size(); t++)
+  {
+    threads.emplace_back([&, t] {
+      for (int pass = 0; pass < 20; pass++)
+        for (const auto& token : tokens)
+          if (cache.hash(token.data(), token.size(), t % 2) != hash_string(token, t % 2))
+            mismatches[t]++;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int count : mismatches) BOOST_CHECK_EQUAL(count, 0);
+  BOOST_CHECK_EQUAL(cache.stats().lookups(), 4 * 20 * tokens.size());
+}
@@ -5,10 +5,19 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_tools.hpp>
 
-#include <memory>
+#include <algorithm>
 #include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 #include "io/io_adapter.h"
+#include "io_buf.h"
 
 BOOST_AUTO_TEST_CASE(io_adapter_vector_writer)
 {
@@ -58,3 +67,122 @@ BOOST_AUTO_TEST_CASE(io_adapter_buffer_view)
     BOOST_CHECK_EQUAL(std::strncmp(read_buffer3, "test another", 13), 0);
   }
 }
+
+BOOST_AUTO_TEST_CASE(io_adapter_mmap_file_reader)
+{
+  const std::string file_name = "io_adapter_mmap_file_reader.tmp";
+  {
+    auto writer = VW::io::open_file_writer(file_name);
+    BOOST_CHECK_EQUAL(writer->write("header mapped contents", 22), 22);
+  }
+
+  {
+    auto reader = VW::io::open_mmap_file_reader(file_name);
+    BOOST_CHECK_EQUAL(reader->is_resettable(), true);
+
+    char read_buffer[7];
+    BOOST_CHECK_EQUAL(reader->read(read_buffer, 7), 7);
+    BOOST_CHECK_EQUAL(std::strncmp(read_buffer, "header ", 7), 0);
+
+    const char* data;
+    size_t len;
+    BOOST_CHECK(reader->take_remaining(data, len));
+    BOOST_CHECK_EQUAL(len, 15);
+    BOOST_CHECK_EQUAL(std::strncmp(data, "mapped contents", 15), 0);
+    BOOST_CHECK(reader->take_remaining(data, len));
+    BOOST_CHECK_EQUAL(len, 0);
+    BOOST_CHECK_EQUAL(reader->read(read_buffer, 7), 0);
+
+    reader->reset();
+    BOOST_CHECK_EQUAL(reader->read(read_buffer, 7), 7);
+    BOOST_CHECK_EQUAL(std::strncmp(read_buffer, "header ", 7), 0);
+  }
+
+  {
+    // io_buf reads straight from the mapping and carries over to the next file when the mapping runs out.
+    constexpr std::array<const char, 5> tail = {"tail"};
+    io_buf buf;
+    buf.add_file(VW::io::open_mmap_file_reader(file_name));
+    buf.add_file(VW::io::create_buffer_view(tail.data(), tail.size()));
+
+    char* p;
+    BOOST_CHECK_EQUAL(buf.buf_read(p, 7), 7);
+    BOOST_CHECK_EQUAL(std::strncmp(p, "header ", 7), 0);
+    BOOST_CHECK_EQUAL(buf.buf_read(p, 13), 13);
+    BOOST_CHECK_EQUAL(std::strncmp(p, "mapped conten", 13), 0);
+    BOOST_CHECK_EQUAL(buf.buf_read(p, 6), 6);
+    BOOST_CHECK_EQUAL(std::strncmp(p, "tstail", 6), 0);
+
+    buf.current = 0;
+    buf.reset_file(buf.input_files[0].get());
+    BOOST_CHECK_EQUAL(buf.buf_read(p, 6), 6);
+    BOOST_CHECK_EQUAL(std::strncmp(p, "header", 6), 0);
+  }
+
+  std::remove(file_name.c_str());
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(io_buf_map_private)
+{
+  const std::string file_name = "io_buf_map_private.tmp";
+  const size_t page = 1 << 16;
+  std::vector<char> padding(page - 6, 0);
+  std::vector<float> image(page / sizeof(float));
+  for (size_t i = 0; i < image.size(); i++) image[i] = static_cast<float>(i);
+  {
+    io_buf buf;
+    buf.add_file(VW::io::open_file_writer(file_name));
+    buf.bin_write_fixed("header", 6);
+    BOOST_CHECK_EQUAL(buf.file_position(), 6);
+    buf.bin_write_fixed(padding.data(), padding.size());
+    buf.bin_write_fixed((char*)image.data(), page);
+    buf.bin_write_fixed("tail", 4);
+    BOOST_CHECK_EQUAL(buf.file_position(), 2 * page + 4);
+    buf.flush();
+    buf.close_files();
+  }
+
+  {
+    io_buf buf;
+    buf.add_file(VW::io::open_file_reader(file_name));
+    char header[6];
+    BOOST_CHECK_EQUAL(buf.bin_read_fixed(header, 6, ""), 6);
+    BOOST_CHECK_EQUAL(std::strncmp(header, "header", 6), 0);
+    BOOST_CHECK_EQUAL(buf.file_position(), 6);
+    BOOST_CHECK_EQUAL(buf.bin_read_fixed(padding.data(), padding.size(), ""), padding.size());
+    BOOST_CHECK_EQUAL(buf.file_position(), page);
+
+    auto* mapped = static_cast<float*>(buf.map_private(page));
+    BOOST_REQUIRE(mapped != nullptr);
+    BOOST_CHECK(std::equal(image.begin(), image.end(), mapped));
+    // The mapping is private, writing to it leaves the file as it is.
+    mapped[0] = 42.f;
+    munmap(mapped, page);
+
+    char tail[4];
+    BOOST_CHECK_EQUAL(buf.bin_read_fixed(tail, 4, ""), 4);
+    BOOST_CHECK_EQUAL(std::strncmp(tail, "tail", 4), 0);
+  }
+
+  {
+    // The file is as written.
+    io_buf buf;
+    buf.add_file(VW::io::open_file_reader(file_name));
+    std::vector<char> skipped(page);
+    BOOST_CHECK_EQUAL(buf.bin_read_fixed(skipped.data(), page, ""), page);
+    float first;
+    BOOST_CHECK_EQUAL(buf.bin_read_fixed((char*)&first, sizeof(first), ""), sizeof(first));
+    BOOST_CHECK_EQUAL(first, 0.f);
+  }
+
+  {
+    // Other readers are read.
+    io_buf buf;
+    buf.add_file(VW::io::create_buffer_view((char*)image.data(), page));
+    BOOST_CHECK(buf.map_private(page) == nullptr);
+  }
+
+  std::remove(file_name.c_str());
+}
+#endif
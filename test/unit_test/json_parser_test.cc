@@ -377,3 +377,53 @@ BOOST_AUTO_TEST_CASE(parse_json_slates_dom_parser)
   VW::finish_example(*slates_vw, examples);
   VW::finish(*slates_vw);
 }
+
+// Reaches the states the other cases do not: label objects, text, skipped keys, booleans and arrays.
+BOOST_AUTO_TEST_CASE(parse_json_label_object_text_and_arrays)
+{
+  std::string json_text = R"(
+    {
+      "_label": {"Label": -1, "Weight": 2.5},
+      "_tag": "t1",
+      "_text": "a b:c",
+      "_unknown": {"x": [1, {"y": "}"}]},
+      "ns": {"f": 1.5, "s": "v w", "on": true, "off": false, "arr": [2, 3.5, null]}
+    })";
+
+  auto vw = VW::initialize("--json --no_stdin --quiet", nullptr, false, nullptr, nullptr);
+  auto examples = parse_json(*vw, json_text);
+  BOOST_CHECK_EQUAL(examples.size(), 1);
+
+  BOOST_CHECK_CLOSE(examples[0]->l.simple.label, -1.f, FLOAT_TOL);
+  BOOST_CHECK_CLOSE(examples[0]->l.simple.weight, 2.5f, FLOAT_TOL);
+  BOOST_CHECK_EQUAL(std::string(examples[0]->tag.begin(), examples[0]->tag.end()), "t1");
+
+  std::vector<std::string> text_features = {"a", "b_c"};
+  auto& text_names = examples[0]->feature_space[' '].space_names;
+  BOOST_CHECK_EQUAL(text_features.size(), text_names.size());
+  for (size_t i = 0; i < text_names.size(); i++) { BOOST_CHECK_EQUAL(text_names[i]->second, text_features[i]); }
+
+  std::vector<std::string> ns_features = {"f", "sv_w", "on"};
+  std::vector<float> ns_values = {1.5f, 1.f, 1.f};
+  auto& ns = examples[0]->feature_space['n'];
+  BOOST_CHECK_EQUAL(ns_features.size(), ns.space_names.size());
+  for (size_t i = 0; i < ns.space_names.size(); i++)
+  {
+    BOOST_CHECK_EQUAL(ns.space_names[i]->second, ns_features[i]);
+    BOOST_CHECK_CLOSE(ns.values[i], ns_values[i], FLOAT_TOL);
+  }
+
+  // Arrays are namespaces of their own, named after their key.
+  std::vector<std::string> array_features = {"[0]", "[1]"};
+  std::vector<float> array_values = {2.f, 3.5f};
+  auto& array = examples[0]->feature_space['a'];
+  BOOST_CHECK_EQUAL(array_features.size(), array.space_names.size());
+  for (size_t i = 0; i < array.space_names.size(); i++)
+  {
+    BOOST_CHECK_EQUAL(array.space_names[i]->second, array_features[i]);
+    BOOST_CHECK_CLOSE(array.values[i], array_values[i], FLOAT_TOL);
+  }
+
+  VW::finish_example(*vw, examples);
+  VW::finish(*vw);
+}
@@ -7,6 +7,8 @@
 
 #include "object_pool.h"
 
+#include <set>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -67,3 +69,79 @@ BOOST_AUTO_TEST_CASE(object_pool_test)
 
   pool.return_object(o2);
 }
+
+BOOST_AUTO_TEST_CASE(lock_free_object_pool_test)
+{
+  VW::lock_free_object_pool<obj, obj_initializer> pool{0, obj_initializer{}, 2};
+  BOOST_CHECK_EQUAL(pool.size(), 0);
+  BOOST_CHECK_EQUAL(pool.empty(), true);
+
+  // Chunks grow geometrically once the first one is used up.
+  std::set<obj*> objects;
+  for (size_t i = 0; i < 5; i++) objects.insert(pool.get_object());
+  BOOST_CHECK_EQUAL(objects.size(), 5);
+  BOOST_CHECK_EQUAL(pool.size(), 8);
+  BOOST_CHECK_EQUAL(pool.empty(), false);
+
+  obj other_obj;
+  for (auto* o : objects) BOOST_CHECK_EQUAL(pool.is_from_pool(o), true);
+  BOOST_CHECK_EQUAL(pool.is_from_pool(&other_obj), false);
+
+  for (auto* o : objects) pool.return_object(o);
+  BOOST_CHECK_EQUAL(pool.size(), 8);
+
+  // Returned objects are reused before the pool grows again.
+  std::set<obj*> reused;
+  for (size_t i = 0; i < 8; i++) reused.insert(pool.get_object());
+  BOOST_CHECK_EQUAL(reused.size(), 8);
+  BOOST_CHECK_EQUAL(pool.size(), 8);
+  BOOST_CHECK_EQUAL(pool.empty(), true);
+  for (auto* o : reused) pool.return_object(o);
+}
+
+BOOST_AUTO_TEST_CASE(lock_free_object_pool_concurrent_test)
+{
+  const size_t num_threads = 4;
+  const size_t iterations = 20000;
+  VW::lock_free_object_pool<obj, obj_initializer> pool{4, obj_initializer{}, 4};
+
+  // Every thread holds a few objects at a time and marks them, two threads holding the same object shows up as a
+  // mismatch.
+  std::vector<std::thread> threads;
+  std::vector<size_t> errors(num_threads, 0);
+  for (size_t t = 0; t < num_threads; t++)
+  {
+    threads.emplace_back([&, t] {
+      obj* held[3];
+      for (size_t i = 0; i < iterations; i++)
+      {
+        for (size_t j = 0; j < 3; j++)
+        {
+          held[j] = pool.get_object();
+          held[j]->i = static_cast<int>(t * 3 + j);
+        }
+        std::this_thread::yield();
+        for (size_t j = 0; j < 3; j++)
+        {
+          if (held[j]->i != static_cast<int>(t * 3 + j))
+            errors[t]++;
+          pool.return_object(held[j]);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (auto error_count : errors) BOOST_CHECK_EQUAL(error_count, 0);
+  BOOST_CHECK_LE(pool.size(), num_threads * 3 * 2);
+
+  size_t num_free = 0;
+  std::vector<obj*> drained;
+  while (!pool.empty())
+  {
+    drained.push_back(pool.get_object());
+    num_free++;
+  }
+  BOOST_CHECK_EQUAL(num_free, pool.size());
+  for (auto* o : drained) pool.return_object(o);
+}
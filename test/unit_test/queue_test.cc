@@ -0,0 +1,88 @@
+#ifndef STATIC_LINK_VW
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/test_tools.hpp>
+
+#include "queue.h"
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(lock_free_ptr_queue_order_test)
+{
+  std::vector<int> values{0, 1, 2, 3, 4, 5};
+  VW::lock_free_ptr_queue<int> queue{4};
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+
+  queue.push(&values[0]);
+  queue.push(&values[1]);
+  BOOST_CHECK_EQUAL(queue.size(), 2);
+  BOOST_CHECK_EQUAL(queue.pop(), &values[0]);
+
+  int* batch[] = {&values[2], &values[3], &values[4]};
+  queue.push(batch, 3);
+  BOOST_CHECK_EQUAL(queue.size(), 4);
+
+  int* popped[8];
+  BOOST_CHECK_EQUAL(queue.pop(popped, 8), 4);
+  BOOST_CHECK_EQUAL(popped[0], &values[1]);
+  BOOST_CHECK_EQUAL(popped[1], &values[2]);
+  BOOST_CHECK_EQUAL(popped[2], &values[3]);
+  BOOST_CHECK_EQUAL(popped[3], &values[4]);
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+
+  queue.push(&values[5]);
+  queue.set_done();
+  BOOST_CHECK_EQUAL(queue.pop(), &values[5]);
+  BOOST_CHECK(queue.pop() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(lock_free_ptr_queue_done_wakes_consumer_test)
+{
+  VW::lock_free_ptr_queue<int> queue{2};
+  int* result = reinterpret_cast<int*>(1);
+  std::thread consumer([&] { result = queue.pop(); });
+  queue.set_done();
+  consumer.join();
+  BOOST_CHECK(result == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(lock_free_ptr_queue_concurrent_test)
+{
+  // A small ring forces both producers and consumers to park.
+  const size_t num_producers = 3;
+  const size_t num_consumers = 2;
+  const size_t items_per_producer = 20000;
+  std::vector<int> values(num_producers * items_per_producer, 0);
+  VW::lock_free_ptr_queue<int> queue{7};
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < num_producers; p++)
+  {
+    producers.emplace_back([&, p] {
+      for (size_t i = 0; i < items_per_producer; i++) queue.push(&values[p * items_per_producer + i]);
+    });
+  }
+
+  std::vector<std::thread> consumers;
+  for (size_t c = 0; c < num_consumers; c++)
+  {
+    consumers.emplace_back([&] {
+      int* batch[5];
+      size_t count;
+      while ((count = queue.pop(batch, 5)) > 0)
+        for (size_t i = 0; i < count; i++) (*batch[i])++;
+    });
+  }
+
+  for (auto& producer : producers) producer.join();
+  queue.set_done();
+  for (auto& consumer : consumers) consumer.join();
+
+  size_t seen_once = 0;
+  for (auto value : values) seen_once += value == 1 ? 1 : 0;
+  BOOST_CHECK_EQUAL(seen_once, values.size());
+  BOOST_CHECK_EQUAL(queue.size(), 0);
+}
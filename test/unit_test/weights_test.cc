@@ -7,8 +7,18 @@
 
 #include "array_parameters.h"
 #include "array_parameters_dense.h"
+#include "dense_dot.h"
 
 #include "test_common.h"
+#include "vw_exception.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 constexpr auto LENGTH = 16;
 constexpr auto STRIDE_SHIFT = 2;
@@ -26,3 +36,143 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_default_function_weight_initialization_stride
   }
 }
 
+
+BOOST_AUTO_TEST_CASE(sparse_parameters_growth_test)
+{
+  // Enough weights to grow the table several times, looked up again while the previous table is being migrated.
+  const size_t num_weights = 20000;
+  sparse_parameters w(1 << 28, STRIDE_SHIFT);
+  size_t default_calls = 0;
+  w.set_default([&default_calls](weight* weights, uint64_t index) {
+    default_calls++;
+    weights[0] = 1.f * index;
+  });
+
+  std::vector<weight*> blocks;
+  for (size_t i = 0; i < num_weights; i++)
+  {
+    blocks.push_back(&w.strided_index(i * 7919));
+    blocks.back()[1] = 2.f;
+    BOOST_CHECK_EQUAL(&w.strided_index((i / 2) * 7919), blocks[i / 2]);
+  }
+  BOOST_CHECK_EQUAL(default_calls, num_weights);
+
+  // Weights never move as the table grows.
+  for (size_t i = 0; i < num_weights; i++)
+  {
+    BOOST_CHECK_EQUAL(&w.strided_index(i * 7919), blocks[i]);
+    BOOST_CHECK_CLOSE(blocks[i][0], 1.f * ((i * 7919) << STRIDE_SHIFT), FLOAT_TOL);
+  }
+  BOOST_CHECK_EQUAL(default_calls, num_weights);
+
+  size_t visited = 0;
+  for (auto iter = w.begin(); iter != w.end(); ++iter)
+  {
+    BOOST_CHECK_EQUAL(&(*iter), &w[iter.index()]);
+    visited++;
+  }
+  BOOST_CHECK_EQUAL(visited, num_weights);
+
+  w.set_zero(1);
+  for (auto* block : blocks) BOOST_CHECK_EQUAL(block[1], 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(dense_parameters_memory_options_test)
+{
+  // Whatever the system provides, the weights are usable and zeroed and the placement is reported.
+  VW::weight_memory_options options;
+  options.huge_pages = VW::huge_page_mode::transparent;
+  options.numa = VW::numa_mode::interleave;
+  dense_parameters w(1 << 16, STRIDE_SHIFT, options);
+  BOOST_CHECK(!w.memory_description().empty());
+  BOOST_CHECK(w.not_null());
+
+  size_t count = 0;
+  for (auto iter = w.begin(); iter != w.end(); ++iter, ++count) BOOST_CHECK_EQUAL(*iter, 0.f);
+  BOOST_CHECK_EQUAL(count, 1 << 16);
+  w.strided_index(12345) = 1.f;
+  BOOST_CHECK_EQUAL(w[12345 << STRIDE_SHIFT], 1.f);
+}
+
+BOOST_AUTO_TEST_CASE(dense_dot_kernels_agree_test)
+{
+  dense_parameters w(1 << 10, STRIDE_SHIFT);
+  for (uint64_t i = 0; i < (1 << 10); i++) w.strided_index(i) = static_cast<float>(i % 7) - 3.f;
+  auto scalar = VW::get_dense_dot(VW::dense_dot_kernel::scalar);
+
+  // Counts around the vector widths exercise the remainder handling, indices past the mask wrap around.
+  for (size_t count = 0; count < 40; count++)
+  {
+    features fs;
+    for (size_t i = 0; i < count; i++) fs.push_back(0.5f + i, ((i * 37) << STRIDE_SHIFT) + (i % 3 == 0 ? 1 << 20 : 0));
+    const uint64_t offset = count % 2 == 0 ? 0 : 1;
+    const float expected = scalar(w.first(), w.mask(), fs, offset);
+
+    const VW::dense_dot_kernel kernels[] = {VW::dense_dot_kernel::avx2, VW::dense_dot_kernel::avx512};
+    for (auto kernel : kernels)
+    {
+      if (!VW::dense_dot_kernel_supported(kernel))
+        continue;
+      const float actual = VW::get_dense_dot(kernel)(w.first(), w.mask(), fs, offset);
+      BOOST_CHECK_SMALL(actual - expected, 1e-4f * (1.f + std::fabs(expected)));
+    }
+  }
+
+  BOOST_CHECK(VW::preferred_dense_dot_kernel(VW::GATHER_WEIGHT_BYTES * 2, false) == VW::dense_dot_kernel::scalar);
+  BOOST_CHECK(VW::preferred_dense_dot_kernel(VW::GATHER_WEIGHT_BYTES * 2, true) == VW::fastest_dense_dot_kernel());
+  BOOST_CHECK(VW::preferred_dense_dot_kernel(VW::GATHER_WEIGHT_BYTES, false) == VW::fastest_dense_dot_kernel());
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(dense_parameters_shared_weights_test)
+{
+  std::vector<std::string> names = {"shared_weights_test_" + std::to_string(getpid())};
+#ifdef __linux__
+  names.push_back("/vw_shared_weights_test_" + std::to_string(getpid()));
+#endif
+  for (const auto& name : names)
+  {
+    dense_parameters none;
+    none.stride_shift(STRIDE_SHIFT);
+    BOOST_CHECK(!none.map_shared(name, LENGTH));
+
+    dense_parameters w(LENGTH, STRIDE_SHIFT);
+    for (size_t i = 0; i < LENGTH; i++) w.strided_index(i) = 1.f * i;
+    BOOST_CHECK_EQUAL(VW::publish_shared_weights(name, w.first(), LENGTH, STRIDE_SHIFT, STRIDE_SHIFT), 1);
+
+    dense_parameters first;
+    first.stride_shift(STRIDE_SHIFT);
+    BOOST_CHECK(first.map_shared(name, LENGTH));
+    BOOST_CHECK(first.shared());
+    for (size_t i = 0; i < LENGTH; i++) BOOST_CHECK_EQUAL(first.strided_index(i), 1.f * i);
+
+    // What a process writes stays its own.
+    first.strided_index(0) = -1.f;
+    dense_parameters second;
+    second.stride_shift(STRIDE_SHIFT);
+    BOOST_CHECK(second.map_shared(name, LENGTH));
+    BOOST_CHECK_EQUAL(second.strided_index(0), 0.f);
+
+    // A new publication is seen by those mapping it afterwards only.
+    w.strided_index(1) = 42.f;
+    BOOST_CHECK_EQUAL(VW::publish_shared_weights(name, w.first(), LENGTH, STRIDE_SHIFT, STRIDE_SHIFT), 2);
+    dense_parameters third;
+    third.stride_shift(STRIDE_SHIFT);
+    BOOST_CHECK(third.map_shared(name, LENGTH));
+    BOOST_CHECK_EQUAL(third.strided_index(1), 42.f);
+    BOOST_CHECK_EQUAL(second.strided_index(1), 1.f);
+
+    // Only the first float of each weight, as published by training.
+    dense_parameters unstrided;
+    BOOST_CHECK(!unstrided.map_shared(name, LENGTH));
+    BOOST_CHECK_EQUAL(VW::publish_shared_weights(name, w.first(), LENGTH, STRIDE_SHIFT, 0), 3);
+    BOOST_CHECK(unstrided.map_shared(name, LENGTH));
+    for (size_t i = 0; i < LENGTH; i++) BOOST_CHECK_EQUAL(unstrided[i], w.strided_index(i));
+
+    dense_parameters longer;
+    BOOST_CHECK_THROW(longer.map_shared(name, 2 * LENGTH), VW::vw_exception);
+
+    name[0] == '/' ? shm_unlink(name.c_str()) : unlink(name.c_str());
+  }
+}
+#endif
@@ -8,67 +8,398 @@ Alekh Agarwal and John Langford, with help Olivier Chapelle.
 */
 
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include "accumulate.h"
 #include "global_data.h"
 #include "vw_allreduce.h"
 
 void add_float(float& c1, const float& c2) { c1 += c2; }
 
-void accumulate(vw& all, parameters& weights, size_t offset)
+namespace
 {
-  uint64_t length = UINT64_ONE << all.num_bits;  // This is size of gradient
-  float* local_grad = new float[length];
+void add_count(uint64_t& c1, const uint64_t& c2) { c1 += c2; }
 
-  if (weights.sparse)
-    for (uint64_t i = 0; i < length; i++)
-      local_grad[i] = (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset];
-  else
-    for (uint64_t i = 0; i < length; i++)
-      local_grad[i] = (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset];
+// Every node fills its own part of a shared buffer and leaves the rest zero.
+void merge_words(uint32_t& w1, const uint32_t& w2) { w1 |= w2; }
 
-  all_reduce<float, add_float>(all, local_grad, length);  // TODO: modify to not use first()
+uint16_t to_fp16(float value)
+{
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t float_exponent = (x >> 23) & 0xff;
+  uint32_t mantissa = x & 0x7fffff;
+  if (float_exponent == 0xff)
+    return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
 
-  if (weights.sparse)
-    for (uint64_t i = 0; i < length; i++)
-      (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset] = local_grad[i];
+  const int exponent = static_cast<int>(float_exponent) - 127 + 15;
+  if (exponent >= 31)
+    return static_cast<uint16_t>(sign | 0x7c00);
+  if (exponent <= 0)
+  {
+    // Subnormal, rounded to nearest even.
+    if (exponent < -10)
+      return static_cast<uint16_t>(sign);
+    mantissa |= 0x800000;
+    const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+    uint32_t half = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1)))
+      half++;
+    return static_cast<uint16_t>(sign | half);
+  }
+
+  // A carry out of the mantissa rounds up to the next exponent, or to infinity.
+  uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+  const uint32_t rest = mantissa & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    half++;
+  return static_cast<uint16_t>(sign | half);
+}
+
+float from_fp16(uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t x;
+  if (exponent == 0x1f)
+    x = sign | 0x7f800000 | (mantissa << 13);
+  else if (exponent != 0)
+    x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  else if (mantissa == 0)
+    x = sign;
   else
+  {
+    exponent = 127 - 14;
+    while ((mantissa & 0x400) == 0)
+    {
+      mantissa <<= 1;
+      exponent--;
+    }
+    x = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+  float value;
+  memcpy(&value, &x, sizeof(value));
+  return value;
+}
+
+uint16_t to_bf16(float value)
+{
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+  if ((x & 0x7fffffff) > 0x7f800000)
+    return static_cast<uint16_t>((x >> 16) | 0x40);
+  return static_cast<uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+float from_bf16(uint16_t half)
+{
+  const uint32_t x = static_cast<uint32_t>(half) << 16;
+  float value;
+  memcpy(&value, &x, sizeof(value));
+  return value;
+}
+
+uint16_t encode(float value, VW::sync_precision precision)
+{
+  return precision == VW::sync_precision::fp16 ? to_fp16(value) : to_bf16(value);
+}
+
+float decode(uint16_t half, VW::sync_precision precision)
+{
+  return precision == VW::sync_precision::fp16 ? from_fp16(half) : from_bf16(half);
+}
+
+// The words taken by the values of count entries.
+uint64_t value_words(uint64_t count, VW::sync_precision precision)
+{
+  return precision == VW::sync_precision::fp32 ? count : (count + 1) / 2;
+}
+
+// Ships the first count entries of sync.indices and sync.values to every node and receives those of the others into
+// sync.words: the indices of all nodes, in node order, followed by their values. Ships nothing and returns false
+// when that would be no less than a dense vector of length floats, which all nodes find at once.
+bool share_entries(vw& all, VW::weight_sync& sync, uint64_t count, uint64_t length, VW::sync_precision precision)
+{
+  const size_t nodes = all.all_reduce->total;
+  const size_t node = all.all_reduce->node;
+  sync.counts.assign(nodes, 0);
+  sync.counts[node] = count;
+  all_reduce<uint64_t, add_count>(all, sync.counts.data(), nodes);
+
+  uint64_t entries = 0;
+  uint64_t words = 0;
+  uint64_t index_offset = 0;
+  uint64_t value_offset = 0;
+  for (size_t i = 0; i < nodes; i++)
+  {
+    if (i == node)
+    {
+      index_offset = entries;
+      value_offset = words;
+    }
+    entries += sync.counts[i];
+    words += value_words(sync.counts[i], precision);
+  }
+  words += entries;
+  if (words >= length)
+    return false;
+
+  sync.words.assign(words, 0);
+  uint32_t* indices = sync.words.data() + index_offset;
+  uint32_t* values = sync.words.data() + entries + value_offset;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    indices[i] = sync.indices[i];
+    if (precision == VW::sync_precision::fp32)
+      memcpy(values + i, &sync.values[i], sizeof(float));
+    else
+      values[i / 2] |= static_cast<uint32_t>(encode(sync.values[i], precision)) << (16 * (i % 2));
+  }
+  all_reduce<uint32_t, merge_words>(all, sync.words.data(), words);
+  return true;
+}
+
+// Calls f(index, value) for every entry shared by share_entries, in the same order on every node.
+template <class F>
+void for_each_entry(vw& all, const VW::weight_sync& sync, VW::sync_precision precision, F f)
+{
+  uint64_t entries = 0;
+  for (uint64_t count : sync.counts) entries += count;
+  const uint32_t* indices = sync.words.data();
+  const uint32_t* values = sync.words.data() + entries;
+  for (size_t node = 0; node < all.all_reduce->total; node++)
+  {
+    const uint64_t count = sync.counts[node];
+    for (uint64_t i = 0; i < count; i++)
+    {
+      float value;
+      if (precision == VW::sync_precision::fp32)
+        memcpy(&value, values + i, sizeof(float));
+      else
+        value = decode(static_cast<uint16_t>(values[i / 2] >> (16 * (i % 2))), precision);
+      f(indices[i], value);
+    }
+    indices += count;
+    values += value_words(count, precision);
+  }
+}
+
+VW::weight_sync& get_sync(vw& all)
+{
+  if (all.weight_sync == nullptr)
+    all.weight_sync = new VW::weight_sync();
+  return *all.weight_sync;
+}
+
+template <class T>
+inline float& weight_at(T& weights, uint64_t i, size_t offset)
+{
+  return (&(weights[i << weights.stride_shift()]))[offset];
+}
+
+// Larger vectors are summed in chunks of this many floats.
+constexpr uint64_t PIPELINE_CHUNK = 1 << 18;
+
+// Sums the weights at offset across nodes in buffer, and calls store(begin, end) once the sums from begin to end are
+// in. While a chunk is being summed, this thread copies out the next one and then stores the sums of the chunk before.
+template <class T, class F>
+void pipelined_all_reduce(vw& all, float* buffer, uint64_t length, T& weights, size_t offset, F store)
+{
+  auto load = [&](uint64_t begin, uint64_t end) {
+    for (uint64_t i = begin; i < end; i++) buffer[i] = weight_at(weights, i, offset);
+  };
+
+  if (length <= PIPELINE_CHUNK)
+  {
+    load(0, length);
+    all_reduce<float, add_float>(all, buffer, length);
+    store(0, length);
+    return;
+  }
+
+  VW::chunked_all_reduce<float, add_float> reduce(all, buffer, length, PIPELINE_CHUNK);
+  load(0, PIPELINE_CHUNK);
+  reduce.loaded(PIPELINE_CHUNK);
+  for (uint64_t begin = 0; begin < length; begin += PIPELINE_CHUNK)
+  {
+    const uint64_t end = std::min(begin + PIPELINE_CHUNK, length);
+    if (end < length)
+    {
+      const uint64_t next_end = std::min(end + PIPELINE_CHUNK, length);
+      load(end, next_end);
+      reduce.loaded(next_end);
+    }
+    reduce.wait_reduced(end);
+    store(begin, end);
+  }
+}
+
+template <class T>
+void accumulate(vw& all, VW::weight_sync& sync, T& weights, size_t offset, const VW::reduced_callback& reduced)
+{
+  const uint64_t length = UINT64_ONE << all.num_bits;  // This is size of gradient
+
+  if (sync.sparse)
+  {
+    sync.indices.clear();
+    sync.values.clear();
     for (uint64_t i = 0; i < length; i++)
-      (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset] = local_grad[i];
+    {
+      const float value = weight_at(weights, i, offset);
+      if (value != 0.f)
+      {
+        sync.indices.push_back(static_cast<uint32_t>(i));
+        sync.values.push_back(value);
+      }
+    }
+    if (share_entries(all, sync, sync.indices.size(), length, VW::sync_precision::fp32))
+    {
+      for (uint64_t i = 0; i < length; i++) weight_at(weights, i, offset) = 0.f;
+      for_each_entry(all, sync, VW::sync_precision::fp32,
+          [&](uint32_t i, float value) { weight_at(weights, i, offset) += value; });
+      if (reduced)
+        reduced(0, length);
+      return;
+    }
+  }
 
-  delete[] local_grad;
+  sync.values.resize(length);
+  const float* sums = sync.values.data();
+  pipelined_all_reduce(all, sync.values.data(), length, weights, offset, [&](uint64_t begin, uint64_t end) {
+    for (uint64_t i = begin; i < end; i++) weight_at(weights, i, offset) = sums[i];
+    if (reduced)
+      reduced(begin, end);
+  });
 }
 
-float accumulate_scalar(vw& all, float local_sum)
+// Ships the weight changes since the last sync, and the ones left over from earlier syncs.
+template <class T>
+void accumulate_changes(vw& all, VW::weight_sync& sync, T& weights, size_t offset)
 {
-  float temp = local_sum;
-  all_reduce<float, add_float>(all, &temp, 1);
-  return temp;
+  const uint64_t length = sync.base.size();
+  const float numnodes = (float)all.all_reduce->total;
+  const bool lossy = sync.precision != VW::sync_precision::fp32 || sync.top_k < 1.f;
+  if (lossy && sync.residual.size() != length)
+    sync.residual.assign(length, 0.f);
+
+  sync.indices.clear();
+  sync.values.clear();
+  for (uint64_t i = 0; i < length; i++)
+  {
+    float change = weight_at(weights, i, offset) - sync.base[i];
+    if (lossy)
+    {
+      change += sync.residual[i];
+      sync.residual[i] = 0.f;
+    }
+    if (change != 0.f)
+    {
+      sync.indices.push_back(static_cast<uint32_t>(i));
+      sync.values.push_back(change);
+    }
+  }
+
+  // The largest changes go first, the others stay in the residual.
+  size_t count = sync.indices.size();
+  const size_t top_k = std::max<size_t>(1, static_cast<size_t>(sync.top_k * length));
+  if (count > top_k)
+  {
+    sync.scratch.resize(count);
+    for (size_t i = 0; i < count; i++) sync.scratch[i] = std::fabs(sync.values[i]);
+    std::nth_element(sync.scratch.begin(), sync.scratch.begin() + (count - top_k), sync.scratch.end());
+    const float threshold = sync.scratch[count - top_k];
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+      if (std::fabs(sync.values[i]) >= threshold)
+      {
+        std::swap(sync.indices[i], sync.indices[kept]);
+        std::swap(sync.values[i], sync.values[kept]);
+        kept++;
+      }
+    }
+    count = kept;
+  }
+
+  if (share_entries(all, sync, count, length, sync.precision))
+  {
+    for (size_t i = count; i < sync.indices.size(); i++) sync.residual[sync.indices[i]] = sync.values[i];
+    if (sync.precision != VW::sync_precision::fp32)
+      for (size_t i = 0; i < count; i++)
+        sync.residual[sync.indices[i]] =
+            sync.values[i] - decode(encode(sync.values[i], sync.precision), sync.precision);
+
+    for_each_entry(all, sync, sync.precision, [&](uint32_t i, float change) { sync.base[i] += change / numnodes; });
+  }
+  else
+  {
+    // Too many changes: ship all of them exactly as a dense vector.
+    sync.scratch.assign(length, 0.f);
+    for (size_t i = 0; i < sync.indices.size(); i++) sync.scratch[sync.indices[i]] = sync.values[i];
+    all_reduce<float, add_float>(all, sync.scratch.data(), length);
+    for (uint64_t i = 0; i < length; i++) sync.base[i] += sync.scratch[i] / numnodes;
+  }
+
+  for (uint64_t i = 0; i < length; i++) weight_at(weights, i, offset) = sync.base[i];
 }
 
-void accumulate_avg(vw& all, parameters& weights, size_t offset)
+template <class T>
+void accumulate_avg(vw& all, VW::weight_sync& sync, T& weights, size_t offset)
 {
-  uint32_t length = 1 << all.num_bits;  // This is size of gradient
+  const uint64_t length = UINT64_ONE << all.num_bits;  // This is size of gradient
+  if (sync.sparse && sync.base.size() == length && sync.base_offset == offset)
+  {
+    accumulate_changes(all, sync, weights, offset);
+    return;
+  }
+
   float numnodes = (float)all.all_reduce->total;
-  float* local_grad = new float[length];
+  sync.values.resize(length);
+  const float* sums = sync.values.data();
+  pipelined_all_reduce(all, sync.values.data(), length, weights, offset, [&](uint64_t begin, uint64_t end) {
+    for (uint64_t i = begin; i < end; i++) weight_at(weights, i, offset) = sums[i] / numnodes;
+  });
 
+  if (sync.sparse)
+  {
+    // Later syncs ship only what changed from here.
+    sync.base.resize(length);
+    for (uint64_t i = 0; i < length; i++) sync.base[i] = weight_at(weights, i, offset);
+    sync.base_offset = offset;
+    sync.residual.clear();
+  }
+}
+}  // namespace
+
+void accumulate(vw& all, parameters& weights, size_t offset) { accumulate(all, weights, offset, nullptr); }
+
+void accumulate(vw& all, parameters& weights, size_t offset, const VW::reduced_callback& reduced)
+{
   if (weights.sparse)
-    for (uint64_t i = 0; i < length; i++)
-      local_grad[i] = (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset];
+    accumulate(all, get_sync(all), weights.sparse_weights, offset, reduced);
   else
-    for (uint64_t i = 0; i < length; i++)
-      local_grad[i] = (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset];
+    accumulate(all, get_sync(all), weights.dense_weights, offset, reduced);
+}
 
-  all_reduce<float, add_float>(all, local_grad, length);  // TODO: modify to not use first()
+float accumulate_scalar(vw& all, float local_sum)
+{
+  float temp = local_sum;
+  all_reduce<float, add_float>(all, &temp, 1);
+  return temp;
+}
 
+void accumulate_avg(vw& all, parameters& weights, size_t offset)
+{
   if (weights.sparse)
-    for (uint64_t i = 0; i < length; i++)
-      (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[offset] = local_grad[i] / numnodes;
+    accumulate_avg(all, get_sync(all), weights.sparse_weights, offset);
   else
-    for (uint64_t i = 0; i < length; i++)
-      (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[offset] = local_grad[i] / numnodes;
-
-  delete[] local_grad;
+    accumulate_avg(all, get_sync(all), weights.dense_weights, offset);
 }
 
 float max_elem(float* arr, int length)
@@ -121,17 +452,16 @@ void accumulate_weighted_avg(vw& all, parameters& weights)
   }
 
   uint32_t length = 1 << all.num_bits;  // This is the number of parameters
-  float* local_weights = new float[length];
+  VW::weight_sync& sync = get_sync(all);
+  sync.values.resize(length);
+  float* local_weights = sync.values.data();
 
+  // First compute weights for averaging
+  auto keep = [](uint64_t, uint64_t) {};
   if (weights.sparse)
-    for (uint64_t i = 0; i < length; i++)
-      local_weights[i] = (&(weights.sparse_weights[i << weights.sparse_weights.stride_shift()]))[1];
+    pipelined_all_reduce(all, local_weights, length, weights.sparse_weights, 1, keep);
   else
-    for (uint64_t i = 0; i < length; i++)
-      local_weights[i] = (&(weights.dense_weights[i << weights.dense_weights.stride_shift()]))[1];
-
-  // First compute weights for averaging
-  all_reduce<float, add_float>(all, local_weights, length);
+    pipelined_all_reduce(all, local_weights, length, weights.dense_weights, 1, keep);
 
   if (weights.sparse)
     do_weighting(all, length, local_weights, weights.sparse_weights);
@@ -143,5 +473,4 @@ void accumulate_weighted_avg(vw& all, parameters& weights)
   else
     all_reduce<float, add_float>(
         all, weights.dense_weights.first(), ((size_t)length) * (1ull << weights.stride_shift()));
-  delete[] local_weights;
 }
@@ -6,7 +6,50 @@
 #pragma once
 #include "global_data.h"
 
+#include <functional>
+#include <vector>
+
+namespace VW
+{
+enum class sync_precision
+{
+  fp32,
+  fp16,
+  bf16
+};
+
+// How accumulate and accumulate_avg ship vectors between nodes, and the buffers they reuse from one sync to the next.
+struct weight_sync
+{
+  // Ship only the nonzero gradients, or the weights changed since the last sync, whenever that is less than the whole
+  // vector. The first sync of the weights ships all of them.
+  bool sparse = false;
+  // Precision of the weight changes shipped. What a change loses is kept and added to the next one.
+  sync_precision precision = sync_precision::fp32;
+  // Fraction of the weights whose changes are shipped by each node, largest first. The others are kept for later.
+  float top_k = 1.f;
+
+  // The entries this node ships, and the dense vector when all are shipped.
+  std::vector<uint32_t> indices;
+  std::vector<float> values;
+  // The entries of all nodes, which ship them in turn.
+  std::vector<uint64_t> counts;
+  std::vector<uint32_t> words;
+  // The weights after the last sync, which are the same on every node, and what this node has yet to ship of its own.
+  std::vector<float> base;
+  size_t base_offset = 0;
+  std::vector<float> residual;
+  // The magnitudes of the changes when picking the largest, or all changes when they are shipped densely.
+  std::vector<float> scratch;
+};
+
+using reduced_callback = std::function<void(uint64_t begin, uint64_t end)>;
+}  // namespace VW
+
 void accumulate(vw& all, parameters& weights, size_t o);
+// Calls reduced(begin, end) as soon as the sums of the weights from begin to end are in, while those of the following
+// weights may still be on their way.
+void accumulate(vw& all, parameters& weights, size_t o, const VW::reduced_callback& reduced);
 float accumulate_scalar(vw& all, float local_sum);
 void accumulate_weighted_avg(vw& all, parameters& weights);
 void accumulate_avg(vw& all, parameters& weights, size_t o);
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <algorithm>
+#include <vector>
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -48,12 +49,27 @@ typedef int socket_t;
 #include <cassert>
 
 constexpr size_t ar_buf_size = 1 << 16;
+// Vectors of fewer bytes are reduced along the spanning tree, which takes the fewest round trips.
+constexpr size_t ar_tree_max_bytes = 1 << 16;
+// Vectors of fewer bytes are reduced by recursive halving and doubling, larger ones around the ring. Both send the
+// same amount, but halving and doubling takes fewer steps while the ring only ever talks to its neighbours.
+constexpr size_t ar_ring_min_bytes = 1 << 20;
+
+enum class AllReduceAlgorithm
+{
+  Automatic,
+  Tree,
+  Ring,
+  HalvingDoubling
+};
 
 struct node_socks
 {
   std::string current_master;
   socket_t parent;
   socket_t children[2];
+  // Direct connections to other nodes by node id, -1 where there is none.
+  std::vector<socket_t> peers;
   ~node_socks()
   {
     if (current_master != "")
@@ -65,8 +81,17 @@ struct node_socks
       if (children[1] != -1)
         CLOSESOCK(this->children[1]);
     }
+    close_peers();
   }
   node_socks() { current_master = ""; }
+
+  void close_peers()
+  {
+    for (socket_t peer : peers)
+      if (peer != -1)
+        CLOSESOCK(peer);
+    peers.clear();
+  }
 };
 
 template <class T, void (*f)(T&, const T&)>
@@ -284,10 +309,147 @@ class AllReduceSockets : public AllReduce
   void pass_down(char* buffer, const size_t parent_read_pos, size_t& children_sent_pos);
   void broadcast(char* buffer, const size_t n);
 
+  // Sends send_count elements to one peer while receiving recv_count elements from another, which may be the same
+  // one. What is received is added to recv_buffer with f if reduce is set and copied there otherwise.
+  template <class T, void (*f)(T&, const T&)>
+  void exchange(socket_t out, const T* send_buffer, size_t send_count, socket_t in, T* recv_buffer,
+      size_t recv_count, bool reduce)
+  {
+    const char* send_bytes = (const char*)send_buffer;
+    const size_t send_size = send_count * sizeof(T);
+    const size_t recv_size = recv_count * sizeof(T);
+    if (reduce && scratch.size() < recv_size)
+      scratch.resize(recv_size);
+    char* recv_bytes = reduce ? scratch.data() : (char*)recv_buffer;
+
+    size_t sent = 0;
+    size_t received = 0;
+    size_t reduced = 0;  // elements
+    while (sent < send_size || received < recv_size)
+    {
+      bool writable = sent < send_size;
+      bool readable = received < recv_size;
+      wait_for_peers(out, writable, in, readable);
+      if (writable)
+        sent += send_some(out, send_bytes + sent, std::min(ar_buf_size, send_size - sent));
+      if (readable)
+      {
+        received += recv_some(in, recv_bytes + received, std::min(ar_buf_size, recv_size - received));
+        if (reduce)
+        {
+          addbufs<T, f>(recv_buffer + reduced, (T*)recv_bytes + reduced, received / sizeof(T) - reduced);
+          reduced = received / sizeof(T);
+        }
+      }
+    }
+  }
+
+  // Bandwidth optimal: every node sends and receives 2 (total - 1) / total of the vector, always to the same
+  // neighbours, in 2 (total - 1) steps.
+  template <class T, void (*f)(T&, const T&)>
+  void ring_all_reduce(T* buffer, const size_t n)
+  {
+    peer_init();
+    const socket_t next = socks.peers[(node + 1) % total];
+    const socket_t prev = socks.peers[(node + total - 1) % total];
+    // Chunk i holds the elements from n i / total up to n (i + 1) / total.
+    auto chunk_begin = [&](size_t i) { return n * (i % total) / total; };
+    auto chunk_size = [&](size_t i) { return n * (i % total + 1) / total - chunk_begin(i); };
+
+    // Partial sums go around the ring until node holds the full sum of chunk node + 1...
+    for (size_t step = 0; step + 1 < total; step++)
+    {
+      const size_t out = node + total - step;
+      const size_t in = out + total - 1;
+      exchange<T, f>(next, buffer + chunk_begin(out), chunk_size(out), prev, buffer + chunk_begin(in),
+          chunk_size(in), true);
+    }
+    // ...and then the full sums go around once more.
+    for (size_t step = 0; step + 1 < total; step++)
+    {
+      const size_t out = node + total + 1 - step;
+      const size_t in = out + total - 1;
+      exchange<T, f>(next, buffer + chunk_begin(out), chunk_size(out), prev, buffer + chunk_begin(in),
+          chunk_size(in), false);
+    }
+  }
+
+  // Sends as much as the ring but in 2 log2(total) steps. With a total that is not a power of two the nodes past the
+  // largest power of two first hand their vector to a partner, which sends the whole result back at the end.
+  template <class T, void (*f)(T&, const T&)>
+  void halving_doubling_all_reduce(T* buffer, const size_t n)
+  {
+    peer_init();
+    const size_t nodes = largest_power_of_two(total);
+    if (node >= nodes)
+    {
+      const socket_t partner = socks.peers[node - nodes];
+      exchange<T, f>(partner, buffer, n, partner, buffer, 0, false);
+      exchange<T, f>(partner, buffer, 0, partner, buffer, n, false);
+      return;
+    }
+    const socket_t extra = node + nodes < total ? socks.peers[node + nodes] : static_cast<socket_t>(-1);
+    if (extra != static_cast<socket_t>(-1))
+      exchange<T, f>(extra, buffer, 0, extra, buffer, n, true);
+
+    // Recursive halving: partners split the range both hold, each sums one half, until every node holds the full sum
+    // of 1 / nodes of the vector.
+    size_t begin[64];
+    size_t end[64];
+    size_t steps = 0;
+    size_t low = 0;
+    size_t high = n;
+    for (size_t distance = nodes / 2; distance > 0; distance /= 2, steps++)
+    {
+      const socket_t partner = socks.peers[node ^ distance];
+      const size_t middle = low + (high - low) / 2;
+      begin[steps] = low;
+      end[steps] = high;
+      if (node & distance)
+      {
+        exchange<T, f>(partner, buffer + low, middle - low, partner, buffer + middle, high - middle, true);
+        low = middle;
+      }
+      else
+      {
+        exchange<T, f>(partner, buffer + middle, high - middle, partner, buffer + low, middle - low, true);
+        high = middle;
+      }
+    }
+    // Recursive doubling: partners swap their sums in the reverse order.
+    for (size_t distance = 1; distance < nodes; distance *= 2)
+    {
+      steps--;
+      const socket_t partner = socks.peers[node ^ distance];
+      const size_t other = (node & distance) ? begin[steps] : high;
+      const size_t other_size = end[steps] - begin[steps] - (high - low);
+      exchange<T, f>(partner, buffer + low, high - low, partner, buffer + other, other_size, false);
+      low = begin[steps];
+      high = end[steps];
+    }
+
+    if (extra != static_cast<socket_t>(-1))
+      exchange<T, f>(extra, buffer, n, extra, buffer, 0, false);
+  }
+
+  static size_t largest_power_of_two(size_t n);
+  // Connects the peers needed by the ring and by recursive halving and doubling, once per spanning tree.
+  void peer_init();
+  void wait_for_peers(socket_t out, bool& writable, socket_t in, bool& readable);
+  size_t send_some(socket_t sock, const char* buffer, size_t count);
+  size_t recv_some(socket_t sock, char* buffer, size_t count);
+
   socket_t sock_connect(const uint32_t ip, const int port);
   socket_t getsock();
+  // Listens on the first free port from netport on, which is in network order.
+  socket_t listen_on_free_port(short unsigned int& netport, int backlog);
+
+  uint32_t local_ip = 0;  // network order, as seen by the span server
+  std::vector<char> scratch;
 
  public:
+  AllReduceAlgorithm algorithm = AllReduceAlgorithm::Automatic;
+
   AllReduceSockets(std::string pspan_server, const int pport, const size_t punique_id, size_t ptotal,
       const size_t pnode, bool pquiet)
       : AllReduce(ptotal, pnode, pquiet), span_server(pspan_server), port(pport), unique_id(punique_id)
@@ -296,12 +458,25 @@ class AllReduceSockets : public AllReduce
 
   virtual ~AllReduceSockets() = default;
 
+  // The algorithm all_reduce uses for a vector of the given size.
+  AllReduceAlgorithm algorithm_for(size_t bytes) const;
+
   template <class T, void (*f)(T&, const T&)>
   void all_reduce(T* buffer, const size_t n)
   {
     if (span_server != socks.current_master)
       all_reduce_init();
-    reduce<T, f>((char*)buffer, n * sizeof(T));
-    broadcast((char*)buffer, n * sizeof(T));
+    switch (algorithm_for(n * sizeof(T)))
+    {
+      case AllReduceAlgorithm::Ring:
+        ring_all_reduce<T, f>(buffer, n);
+        break;
+      case AllReduceAlgorithm::HalvingDoubling:
+        halving_doubling_all_reduce<T, f>(buffer, n);
+        break;
+      default:
+        reduce<T, f>((char*)buffer, n * sizeof(T));
+        broadcast((char*)buffer, n * sizeof(T));
+    }
   }
 };
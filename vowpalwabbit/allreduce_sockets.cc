@@ -23,6 +23,7 @@ Alekh Agarwal and John Langford, with help Olivier Chapelle.
 #  include <io.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #endif
 #include <sys/timeb.h>
@@ -82,6 +83,49 @@ socket_t AllReduceSockets::sock_connect(const uint32_t ip, const int port)
   return sock;
 }
 
+socket_t AllReduceSockets::listen_on_free_port(short unsigned int& netport, int backlog)
+{
+  socket_t sock = getsock();
+  sockaddr_in address;
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = netport;
+
+  bool listening = false;
+  while (!listening)
+  {
+    if (::bind(sock, (sockaddr*)&address, sizeof(address)) < 0)
+    {
+#ifdef _WIN32
+      if (WSAGetLastError() == WSAEADDRINUSE)
+#else
+      if (errno == EADDRINUSE)
+#endif
+      {
+        netport = htons(ntohs(netport) + 1);
+        address.sin_port = netport;
+      }
+      else
+        THROWERRNO("bind");
+    }
+    else
+    {
+      if (listen(sock, backlog) < 0)
+      {
+        if (!quiet)
+          cerr << "listen: " << VW::strerror_to_string(errno) << endl;
+        CLOSESOCK(sock);
+        sock = getsock();
+      }
+      else
+      {
+        listening = true;
+      }
+    }
+  }
+  return sock;
+}
+
 socket_t AllReduceSockets::getsock()
 {
   socket_t sock = socket(PF_INET, SOCK_STREAM, 0);
@@ -129,10 +173,18 @@ void AllReduceSockets::all_reduce_init()
     THROWERRNO("gethostbyname(" << span_server << ")");
 
   socks.current_master = span_server;
+  socks.close_peers();
 
   uint32_t master_ip = *((uint32_t*)master->h_addr);
 
   socket_t master_sock = sock_connect(master_ip, htons(port));
+  {
+    sockaddr_in local_address;
+    socklen_t size = sizeof(local_address);
+    if (getsockname(master_sock, (sockaddr*)&local_address, &size) < 0)
+      THROWERRNO("getsockname");
+    local_ip = local_address.sin_addr.s_addr;
+  }
   if (send(master_sock, (const char*)&unique_id, sizeof(unique_id), 0) < (int)sizeof(unique_id))
   {
     THROW("write unique_id=" << unique_id << " to span server failed");
@@ -190,46 +242,7 @@ void AllReduceSockets::all_reduce_init()
   auto sock = static_cast<socket_t>(-1);
   short unsigned int netport = htons(26544);
   if (kid_count > 0)
-  {
-    sock = getsock();
-    sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = htonl(INADDR_ANY);
-    address.sin_port = netport;
-
-    bool listening = false;
-    while (!listening)
-    {
-      if (::bind(sock, (sockaddr*)&address, sizeof(address)) < 0)
-      {
-#ifdef _WIN32
-        if (WSAGetLastError() == WSAEADDRINUSE)
-#else
-        if (errno == EADDRINUSE)
-#endif
-        {
-          netport = htons(ntohs(netport) + 1);
-          address.sin_port = netport;
-        }
-        else
-          THROWERRNO("bind");
-      }
-      else
-      {
-        if (listen(sock, kid_count) < 0)
-        {
-          if (!quiet)
-            cerr << "listen: " << VW::strerror_to_string(errno) << endl;
-          CLOSESOCK(sock);
-          sock = getsock();
-        }
-        else
-        {
-          listening = true;
-        }
-      }
-    }
-  }
+    sock = listen_on_free_port(netport, kid_count);
 
   if (send(master_sock, (const char*)&netport, sizeof(netport), 0) < (int)sizeof(netport))
     THROW("write netport failed!");
@@ -354,3 +367,161 @@ void AllReduceSockets::broadcast(char* buffer, const size_t n)
     }
   }
 }
+
+size_t AllReduceSockets::largest_power_of_two(size_t n)
+{
+  size_t power = 1;
+  while (power * 2 <= n) power *= 2;
+  return power;
+}
+
+AllReduceAlgorithm AllReduceSockets::algorithm_for(size_t bytes) const
+{
+  if (total == 1)
+    return AllReduceAlgorithm::Tree;
+  if (algorithm != AllReduceAlgorithm::Automatic)
+    return algorithm;
+  if (bytes < ar_tree_max_bytes)
+    return AllReduceAlgorithm::Tree;
+  if (bytes < ar_ring_min_bytes)
+    return AllReduceAlgorithm::HalvingDoubling;
+  return AllReduceAlgorithm::Ring;
+}
+
+static void merge_address(uint64_t& address, const uint64_t& other) { address |= other; }
+
+void AllReduceSockets::peer_init()
+{
+  if (!socks.peers.empty())
+    return;
+
+  std::vector<bool> needed(total, false);
+  needed[(node + 1) % total] = true;
+  needed[(node + total - 1) % total] = true;
+  const size_t nodes = largest_power_of_two(total);
+  if (node < nodes)
+  {
+    for (size_t distance = 1; distance < nodes; distance *= 2) needed[node ^ distance] = true;
+    if (node + nodes < total)
+      needed[node + nodes] = true;
+  }
+  else
+    needed[node - nodes] = true;
+
+  // Every node connects to the peers with a lower id and accepts the others.
+  int accept_count = 0;
+  for (size_t i = node + 1; i < total; i++)
+    if (needed[i])
+      accept_count++;
+  auto sock = static_cast<socket_t>(-1);
+  short unsigned int netport = htons(26544);
+  if (accept_count > 0)
+    sock = listen_on_free_port(netport, accept_count);
+
+  // The spanning tree tells every node where the others listen.
+  std::vector<uint64_t> addresses(total, 0);
+  addresses[node] = (static_cast<uint64_t>(local_ip) << 16) | netport;
+  reduce<uint64_t, merge_address>((char*)addresses.data(), total * sizeof(uint64_t));
+  broadcast((char*)addresses.data(), total * sizeof(uint64_t));
+
+  socks.peers.assign(total, static_cast<socket_t>(-1));
+  for (size_t i = 0; i < node; i++)
+  {
+    if (!needed[i])
+      continue;
+    socks.peers[i] = sock_connect(static_cast<uint32_t>(addresses[i] >> 16), static_cast<int>(addresses[i] & 0xffff));
+    if (send(socks.peers[i], (const char*)&node, sizeof(node), 0) < (int)sizeof(node))
+      THROW("write node=" << node << " to peer " << i << " failed");
+  }
+  for (int i = 0; i < accept_count; i++)
+  {
+    sockaddr_in peer_address;
+    socklen_t size = sizeof(peer_address);
+    socket_t f = accept(sock, (sockaddr*)&peer_address, &size);
+#ifdef _WIN32
+    if (f == INVALID_SOCKET)
+#else
+    if (f < 0)
+#endif
+      THROWERRNO("accept");
+
+    size_t peer = 0;
+    if (recv(f, (char*)&peer, sizeof(peer), 0) < (int)sizeof(peer))
+      THROW("read node from peer failed");
+    if (peer <= node || peer >= total || !needed[peer] || socks.peers[peer] != static_cast<socket_t>(-1))
+      THROW("unexpected connection from node " << peer);
+    socks.peers[peer] = f;
+  }
+  if (accept_count > 0)
+    CLOSESOCK(sock);
+
+  // Peers send in both directions at once, which must not block on a full buffer.
+  for (socket_t peer : socks.peers)
+  {
+    if (peer == static_cast<socket_t>(-1))
+      continue;
+    int on = 1;
+    if (setsockopt(peer, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(on)) < 0)
+      THROWERRNO("setsockopt TCP_NODELAY");
+#ifdef _WIN32
+    u_long nonblocking = 1;
+    if (ioctlsocket(peer, FIONBIO, &nonblocking) != 0)
+      THROWERRNO("ioctlsocket FIONBIO");
+#else
+    if (fcntl(peer, F_SETFL, fcntl(peer, F_GETFL) | O_NONBLOCK) < 0)
+      THROWERRNO("fcntl O_NONBLOCK");
+#endif
+  }
+}
+
+void AllReduceSockets::wait_for_peers(socket_t out, bool& writable, socket_t in, bool& readable)
+{
+  fd_set write_fds;
+  fd_set read_fds;
+  FD_ZERO(&write_fds);
+  FD_ZERO(&read_fds);
+  if (writable)
+    FD_SET(out, &write_fds);
+  if (readable)
+    FD_SET(in, &read_fds);
+  socket_t max_fd = std::max(writable ? out : 0, readable ? in : 0) + 1;
+  if (select((int)max_fd, &read_fds, &write_fds, nullptr, nullptr) == -1)
+    THROWERRNO("select");
+  writable = writable && FD_ISSET(out, &write_fds);
+  readable = readable && FD_ISSET(in, &read_fds);
+}
+
+static bool would_block()
+{
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+size_t AllReduceSockets::send_some(socket_t sock, const char* buffer, size_t count)
+{
+  int write_size = send(sock, buffer, (int)count, 0);
+  if (write_size < 0)
+  {
+    if (would_block())
+      return 0;
+    THROWERRNO("send to peer");
+  }
+  return write_size;
+}
+
+size_t AllReduceSockets::recv_some(socket_t sock, char* buffer, size_t count)
+{
+  int read_size = recv(sock, buffer, (int)count, 0);
+  if (read_size < 0)
+  {
+    if (would_block())
+      return 0;
+    THROWERRNO("recv from peer");
+  }
+  if (read_size == 0)
+    THROW("peer closed the connection");
+  return read_size;
+}
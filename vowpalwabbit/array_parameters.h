@@ -4,9 +4,10 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
 #include <cstddef>
 #include <functional>
+#include <vector>
 
 #ifndef _WIN32
 #define NOMINMAX
@@ -22,15 +23,35 @@
 #include "array_parameters_dense.h"
 #include "vw_exception.h"
 
-class sparse_parameters;
-typedef std::unordered_map<uint64_t, weight*> weight_map;
+// Entry of the open addressing table of sparse_parameters. A null block marks an empty slot.
+struct sparse_weight_slot
+{
+  uint64_t index;
+  weight* block;
+};
 
 template <typename T>
 class sparse_iterator
 {
  private:
-  weight_map::iterator _iter;
-  uint32_t _stride;
+  // Walks the occupied slots of [_current, _end), then those of [_next, _next_end).
+  sparse_weight_slot* _current;
+  sparse_weight_slot* _end;
+  sparse_weight_slot* _next;
+  sparse_weight_slot* _next_end;
+
+  void skip_empty()
+  {
+    while (true)
+    {
+      while (_current != _end && _current->block == nullptr) ++_current;
+      if (_current != _end || _next == _next_end)
+        return;
+      _current = _next;
+      _end = _next_end;
+      _next = _next_end;
+    }
+  }
 
  public:
   typedef std::forward_iterator_tag iterator_category;
@@ -39,62 +60,207 @@ class sparse_iterator
   typedef T* pointer;
   typedef T& reference;
 
-  sparse_iterator(weight_map::iterator& iter, uint32_t stride) : _iter(iter), _stride(stride) {}
+  sparse_iterator(
+      sparse_weight_slot* current, sparse_weight_slot* end, sparse_weight_slot* next, sparse_weight_slot* next_end)
+      : _current(current), _end(end), _next(next), _next_end(next_end)
+  {
+    skip_empty();
+  }
 
   sparse_iterator& operator=(const sparse_iterator& other) = default;
   sparse_iterator(const sparse_iterator& other) = default;
   sparse_iterator& operator=(sparse_iterator&& other) noexcept = default;
   sparse_iterator(sparse_iterator&& other) noexcept = default;
 
-  uint64_t index() { return _iter->first; }
+  uint64_t index() { return _current->index; }
 
-  T& operator*() { return *(_iter->second); }
+  T& operator*() { return *(_current->block); }
 
   sparse_iterator& operator++()
   {
-    _iter++;
+    ++_current;
+    skip_empty();
     return *this;
   }
 
-  bool operator==(const sparse_iterator& rhs) const { return _iter == rhs._iter; }
-  bool operator!=(const sparse_iterator& rhs) const { return _iter != rhs._iter; }
+  bool operator==(const sparse_iterator& rhs) const { return _current == rhs._current; }
+  bool operator!=(const sparse_iterator& rhs) const { return _current != rhs._current; }
 };
 
+/*
+ * Weights are kept in a linear probing hash table from index to weight block. The blocks of stride() weights are
+ * carved out of slabs and never move, so references to weights stay valid as the table grows. Growing does not
+ * rehash everything at once: the previous table is kept and a few of its slots are moved over on every insertion,
+ * with lookups falling back to it until it is empty.
+ */
 class sparse_parameters
 {
+ public:
+  typedef sparse_iterator<weight> iterator;
+  typedef sparse_iterator<const weight> const_iterator;
+
  private:
-  // This must be mutable because the const operator[] must be able to intialize default weights to return.
-  mutable weight_map _map;
+  static constexpr size_t INITIAL_CAPACITY = 1 << 6;
+  static constexpr size_t BLOCKS_PER_SLAB = 1 << 12;
+  // Slots of the previous table moved per insertion. With the table doubling at 3/4 load the previous table is empty
+  // well before the new one fills up.
+  static constexpr size_t SLOTS_MIGRATED_PER_INSERT = 8;
+
+  // Table state must be mutable because the const operator[] must be able to intialize default weights to return.
+  mutable sparse_weight_slot* _slots;
+  mutable size_t _capacity;
+  mutable uint32_t _hash_shift;  // 64 - log2(_capacity)
+  mutable size_t _size;
+  // Previous table while it is being migrated, slots before _migrated have been moved.
+  mutable sparse_weight_slot* _old_slots;
+  mutable size_t _old_capacity;
+  mutable uint32_t _old_hash_shift;
+  mutable size_t _migrated;
+  // Slabs allocated by this instance, a shallow copy references the slabs of the original.
+  mutable std::vector<weight*> _slabs;
+  mutable weight* _slab_next;
+  mutable weight* _slab_end;
+
   uint64_t _weight_mask;  // (stride*(1 << num_bits) -1)
   uint32_t _stride_shift;
   bool _seeded;  // whether the instance is sharing model state with others
   bool _delete;
   std::function<void(weight*, uint64_t)> _default_func;
 
+  static size_t slot_of(uint64_t index, uint32_t hash_shift)
+  {
+    // Fibonacci hashing, indices are mostly multiples of the stride so their low bits cannot be used directly.
+    return static_cast<size_t>((index * UINT64_C(0x9E3779B97F4A7C15)) >> hash_shift);
+  }
+
+  static uint32_t hash_shift_for(size_t capacity)
+  {
+    uint32_t shift = 64;
+    while (capacity > 1)
+    {
+      capacity >>= 1;
+      shift--;
+    }
+    return shift;
+  }
+
+  static sparse_weight_slot* find_slot(sparse_weight_slot* slots, size_t capacity, uint32_t hash_shift, uint64_t index)
+  {
+    for (size_t pos = slot_of(index, hash_shift);; pos = (pos + 1) & (capacity - 1))
+      if (slots[pos].block == nullptr || slots[pos].index == index)
+        return &slots[pos];
+  }
+
+  weight* allocate_block() const
+  {
+    if (_slab_end - _slab_next < static_cast<ptrdiff_t>(stride()))
+    {
+      _slabs.push_back(calloc_or_throw<weight>(BLOCKS_PER_SLAB << _stride_shift));
+      _slab_next = _slabs.back();
+      _slab_end = _slab_next + (BLOCKS_PER_SLAB << _stride_shift);
+    }
+    weight* block = _slab_next;
+    _slab_next += stride();
+    return block;
+  }
+
+  void migrate_some() const
+  {
+    const size_t migrate_end = std::min(_migrated + SLOTS_MIGRATED_PER_INSERT, _old_capacity);
+    for (; _migrated < migrate_end; _migrated++)
+    {
+      const sparse_weight_slot& old_slot = _old_slots[_migrated];
+      if (old_slot.block != nullptr)
+        *find_slot(_slots, _capacity, _hash_shift, old_slot.index) = old_slot;
+    }
+    if (_migrated == _old_capacity)
+    {
+      free(_old_slots);
+      _old_slots = nullptr;
+      _old_capacity = 0;
+    }
+  }
+
+  void grow() const
+  {
+    _old_slots = _slots;
+    _old_capacity = _capacity;
+    _old_hash_shift = _hash_shift;
+    _migrated = 0;
+    _capacity *= 2;
+    _hash_shift--;
+    _slots = calloc_or_throw<sparse_weight_slot>(_capacity);
+  }
+
+  // slot is where index belongs in the current table.
+  weight* insert(uint64_t index, sparse_weight_slot* slot) const
+  {
+    // Not yet migrated, as the previous table takes no insertions only its slots after _migrated can hold the index.
+    if (_old_slots != nullptr)
+    {
+      const sparse_weight_slot* old_slot = find_slot(_old_slots, _old_capacity, _old_hash_shift, index);
+      if (old_slot->block != nullptr)
+        return old_slot->block;
+    }
+
+    weight* block = allocate_block();
+    if (_default_func != nullptr)
+      _default_func(block, index);
+    slot->index = index;
+    slot->block = block;
+    _size++;
+
+    if (_old_slots != nullptr)
+      migrate_some();
+    else if (_size * 4 > _capacity * 3)
+      grow();
+    return block;
+  }
+
   // It is marked const so it can be used from both const and non const operator[]
-  // The map itself is mutable to facilitate this
+  // The table itself is mutable to facilitate this
   inline weight* get_or_default_and_get(size_t i) const
   {
     uint64_t index = i & _weight_mask;
-    weight_map::iterator iter = _map.find(index);
-    if (iter == _map.end())
-    {
-      _map.insert(std::make_pair(index, calloc_mergable_or_throw<weight>(stride())));
-      iter = _map.find(index);
-      if (_default_func != nullptr)
-      {
-        _default_func(iter->second, index);
-      }
-    }
-    return iter->second;
+    sparse_weight_slot* slot = find_slot(_slots, _capacity, _hash_shift, index);
+    if (slot->block != nullptr)
+      return slot->block;
+    return insert(index, slot);
   }
 
-public:
-  typedef sparse_iterator<weight> iterator;
-  typedef sparse_iterator<const weight> const_iterator;
+  void free_storage()
+  {
+    for (weight* slab : _slabs) free(slab);
+    _slabs.clear();
+    _slab_next = _slab_end = nullptr;
+    free(_slots);
+    free(_old_slots);
+    _slots = _old_slots = nullptr;
+  }
 
+  template <typename Iterator>
+  Iterator make_iterator(bool at_end)
+  {
+    sparse_weight_slot* end = _slots + _capacity;
+    sparse_weight_slot* old_begin = _old_slots == nullptr ? end : _old_slots + _migrated;
+    sparse_weight_slot* old_end = _old_slots == nullptr ? end : _old_slots + _old_capacity;
+    if (at_end)
+      return Iterator(old_end, old_end, old_end, old_end);
+    return Iterator(_slots, end, old_begin, old_end);
+  }
+
+ public:
   sparse_parameters(size_t length, uint32_t stride_shift = 0)
-      : _map()
+      : _slots(calloc_or_throw<sparse_weight_slot>(INITIAL_CAPACITY))
+      , _capacity(INITIAL_CAPACITY)
+      , _hash_shift(hash_shift_for(INITIAL_CAPACITY))
+      , _size(0)
+      , _old_slots(nullptr)
+      , _old_capacity(0)
+      , _old_hash_shift(0)
+      , _migrated(0)
+      , _slab_next(nullptr)
+      , _slab_end(nullptr)
       , _weight_mask((length << stride_shift) - 1)
       , _stride_shift(stride_shift)
       , _seeded(false)
@@ -103,12 +269,9 @@ public:
   {
   }
 
-  sparse_parameters()
-      : _map(), _weight_mask(0), _stride_shift(0), _seeded(false), _delete(false), _default_func(nullptr)
-  {
-  }
+  sparse_parameters() : sparse_parameters(1) { _weight_mask = 0; }
 
-  bool not_null() { return (_weight_mask > 0 && !_map.empty()); }
+  bool not_null() { return (_weight_mask > 0 && _size > 0); }
 
   sparse_parameters(const sparse_parameters& other) = delete;
   sparse_parameters& operator=(const sparse_parameters& other) = delete;
@@ -118,28 +281,12 @@ public:
   weight* first() { THROW_OR_RETURN("Allreduce currently not supported in sparse", nullptr); }
 
   // iterator with stride
-  iterator begin()
-  {
-    weight_map::iterator i = _map.begin();
-    return iterator(i, stride());
-  }
-  iterator end()
-  {
-    weight_map::iterator i = _map.end();
-    return iterator(i, stride());
-  }
+  iterator begin() { return make_iterator<iterator>(false); }
+  iterator end() { return make_iterator<iterator>(true); }
 
   // const iterator
-  const_iterator cbegin()
-  {
-    weight_map::iterator i = _map.begin();
-    return const_iterator(i, stride());
-  }
-  const_iterator cend()
-  {
-    weight_map::iterator i = _map.begin();
-    return const_iterator(i, stride());
-  }
+  const_iterator cbegin() { return make_iterator<const_iterator>(false); }
+  const_iterator cend() { return make_iterator<const_iterator>(true); }
 
   inline weight& operator[](size_t i)
   {
@@ -153,18 +300,33 @@ public:
 
   inline weight& strided_index(size_t index) { return operator[](index << _stride_shift); }
 
+  // Unlike operator[], does not insert weights that were never accessed, for which it returns nullptr instead.
+  inline const weight* find(size_t i) const
+  {
+    uint64_t index = i & _weight_mask;
+    const sparse_weight_slot* slot = find_slot(_slots, _capacity, _hash_shift, index);
+    if (slot->block == nullptr && _old_slots != nullptr)
+      slot = find_slot(_old_slots, _old_capacity, _old_hash_shift, index);
+    return slot->block;
+  }
+
   void shallow_copy(const sparse_parameters& input)
   {
-    // TODO: this is level-1 copy (weight* are stilled shared)
-    if (!_seeded)
+    // TODO: this is level-1 copy (weight blocks are stilled shared)
+    free_storage();
+    _slots = calloc_or_throw<sparse_weight_slot>(input._capacity);
+    std::copy(input._slots, input._slots + input._capacity, _slots);
+    _capacity = input._capacity;
+    _hash_shift = input._hash_shift;
+    _size = input._size;
+    if (input._old_slots != nullptr)
     {
-      for (auto& iter : _map)
-      {
-        auto* weight_ptr = iter.second;
-        free(weight_ptr);
-      }
+      _old_slots = calloc_or_throw<sparse_weight_slot>(input._old_capacity);
+      std::copy(input._old_slots, input._old_slots + input._old_capacity, _old_slots);
     }
-    _map = input._map;
+    _old_capacity = input._old_capacity;
+    _old_hash_shift = input._old_hash_shift;
+    _migrated = input._migrated;
     _weight_mask = input._weight_mask;
     _stride_shift = input._stride_shift;
     _seeded = true;
@@ -178,9 +340,9 @@ public:
 
   void set_zero(size_t offset)
   {
-    for (auto& iter : _map)
+    for (iterator iter = begin(); iter != end(); ++iter)
     {
-      (&(*(iter.second)))[offset] = 0;
+      (&(*iter))[offset] = 0;
     }
   }
 
@@ -203,14 +365,10 @@ public:
 
   ~sparse_parameters()
   {
-    if (!_delete && !_seeded)  // don't free weight vector if it is shared with another instance
+    // Slabs of the instance this was seeded from are not in _slabs, so only owned weights are freed.
+    if (!_delete)
     {
-      for (auto& iter : _map)
-      {
-        auto* weight_ptr = iter.second;
-        free(weight_ptr);
-      }
-      _map.clear();
+      free_storage();
       _delete = true;
     }
   }
@@ -223,6 +381,7 @@ class parameters
   bool normalized;
 
   bool sparse;
+  VW::weight_memory_options memory_options;
   dense_parameters dense_weights;
   sparse_parameters sparse_weights;
 
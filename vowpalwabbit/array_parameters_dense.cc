@@ -0,0 +1,322 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "array_parameters_dense.h"
+#include "vw_exception.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+namespace
+{
+constexpr size_t HUGE_PAGE_2MB = size_t(1) << 21;
+constexpr size_t HUGE_PAGE_1GB = size_t(1) << 30;
+// From linux/mempolicy.h and linux/mman.h, which are not available everywhere.
+constexpr int MPOL_BIND_MODE = 2;
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr int HUGE_SHIFT = 26;
+constexpr size_t MAX_NUMA_NODES = 1024;
+constexpr size_t BITS_PER_WORD = 8 * sizeof(unsigned long);
+
+size_t round_up(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+void* map_huge_pages(size_t size, size_t page_size)
+{
+  const int page_bits = page_size == HUGE_PAGE_1GB ? 30 : 21;
+  return mmap(nullptr, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_bits << HUGE_SHIFT), -1, 0);
+}
+
+// Maps size bytes aligned to alignment, so that transparent huge pages can back the whole range.
+void* map_aligned(size_t size, size_t alignment)
+{
+  const size_t padded = size + alignment;
+  void* data = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  char* begin = static_cast<char*>(data);
+  char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(begin), alignment));
+  if (aligned != begin)
+    munmap(begin, aligned - begin);
+  const size_t tail = (begin + padded) - (aligned + size);
+  if (tail != 0)
+    munmap(aligned + size, tail);
+  return aligned;
+}
+
+bool transparent_huge_pages_enabled()
+{
+  std::ifstream setting("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string value((std::istreambuf_iterator<char>(setting)), std::istreambuf_iterator<char>());
+  return value.find("[never]") == std::string::npos;
+}
+
+// Parses a node list such as "0-1,3" into a mask of MAX_NUMA_NODES bits.
+std::vector<unsigned long> parse_node_list(const std::string& nodes)
+{
+  std::vector<unsigned long> mask(MAX_NUMA_NODES / BITS_PER_WORD, 0);
+  std::stringstream ranges(nodes);
+  std::string range;
+  while (std::getline(ranges, range, ','))
+  {
+    if (range.find_first_not_of(" \n") == std::string::npos)
+      continue;
+    size_t first, last;
+    char dash;
+    std::stringstream parts(range);
+    if (!(parts >> first))
+      THROW("invalid NUMA node list: " << nodes);
+    last = first;
+    if (parts >> dash && (dash != '-' || !(parts >> last)))
+      THROW("invalid NUMA node list: " << nodes);
+    if (last < first || last >= MAX_NUMA_NODES)
+      THROW("invalid NUMA node list: " << nodes);
+    for (size_t node = first; node <= last; node++) mask[node / BITS_PER_WORD] |= 1ul << (node % BITS_PER_WORD);
+  }
+  return mask;
+}
+
+std::string online_nodes()
+{
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  std::getline(online, nodes);
+  return nodes.empty() ? "0" : nodes;
+}
+}  // namespace
+#endif
+
+void* VW::allocate_weight_memory(
+    size_t size, const weight_memory_options& options, size_t& mapped_size, std::string& description)
+{
+#ifdef __linux__
+  std::stringstream obtained;
+  void* data = nullptr;
+
+  if (options.huge_pages == huge_page_mode::explicit_2mb || options.huge_pages == huge_page_mode::explicit_1gb)
+  {
+    const bool gigabyte = options.huge_pages == huge_page_mode::explicit_1gb;
+    const size_t page_size = gigabyte ? HUGE_PAGE_1GB : HUGE_PAGE_2MB;
+    mapped_size = round_up(size, page_size);
+    data = map_huge_pages(mapped_size, page_size);
+    if (data == MAP_FAILED)
+    {
+      data = nullptr;
+      obtained << (gigabyte ? "no 1GB" : "no 2MB") << " huge pages available (" << strerror(errno) << "), ";
+    }
+    else
+      obtained << (gigabyte ? "1GB" : "2MB") << " huge pages";
+  }
+
+  if (data == nullptr)
+  {
+    // Explicit huge pages that could not be had still get transparent ones if possible.
+    const bool transparent = options.huge_pages != huge_page_mode::off;
+    mapped_size = transparent ? round_up(size, HUGE_PAGE_2MB) : size;
+    data = map_aligned(mapped_size, transparent ? HUGE_PAGE_2MB : sysconf(_SC_PAGE_SIZE));
+    if (data == nullptr)
+      THROW("internal error: memory allocation failed!");
+    if (transparent && transparent_huge_pages_enabled() && madvise(data, mapped_size, MADV_HUGEPAGE) == 0)
+      obtained << "transparent huge pages";
+    else
+      obtained << "regular pages";
+  }
+
+  if (options.numa != numa_mode::off)
+  {
+    // Pages are placed on first touch, which has not happened yet for a fresh mapping.
+    const bool interleave = options.numa == numa_mode::interleave;
+    const std::string nodes = options.numa_nodes.empty() ? online_nodes() : options.numa_nodes;
+    const auto mask = parse_node_list(nodes);
+    if (syscall(SYS_mbind, data, mapped_size, interleave ? MPOL_INTERLEAVE_MODE : MPOL_BIND_MODE, mask.data(),
+            MAX_NUMA_NODES, 0) == 0)
+      obtained << ", NUMA " << (interleave ? "interleave" : "bind") << " on nodes " << nodes;
+    else
+      obtained << ", no NUMA policy (" << strerror(errno) << ")";
+  }
+
+  description = obtained.str();
+  return data;
+#else
+  mapped_size = 0;
+  description = options.requested() ? "regular pages, huge pages and NUMA policies are only supported on Linux" : "";
+  return calloc_mergable_or_throw<char>(size);
+#endif
+}
+
+#ifndef _WIN32
+namespace
+{
+constexpr char SHARED_WEIGHTS_MAGIC[8] = {'V', 'W', 'W', 'E', 'I', 'G', 'H', 'T'};
+constexpr uint32_t SHARED_WEIGHTS_FORMAT = 1;
+
+// Names with a single leading slash are shared memory segments, anything else is a file.
+bool is_segment_name(const std::string& name)
+{
+  return name.size() > 1 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+}
+
+int open_shared_weights(const std::string& name, int flags)
+{
+  return is_segment_name(name) ? shm_open(name.c_str(), flags, 0644) : open(name.c_str(), flags, 0644);
+}
+
+// Removes a partial publication, keeping the errno of what went wrong.
+void remove_shared_weights(const std::string& name)
+{
+  const int error = errno;
+  is_segment_name(name) ? shm_unlink(name.c_str()) : unlink(name.c_str());
+  errno = error;
+}
+
+bool read_header(int fd, VW::shared_weights_header& header)
+{
+  return pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+      memcmp(header.magic, SHARED_WEIGHTS_MAGIC, sizeof(SHARED_WEIGHTS_MAGIC)) == 0 &&
+      header.format == SHARED_WEIGHTS_FORMAT;
+}
+}  // namespace
+
+bool VW::shared_weights_published(const std::string& name)
+{
+  const int fd = open_shared_weights(name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  shared_weights_header header;
+  const bool published = read_header(fd, header);
+  close(fd);
+  return published;
+}
+
+void* VW::map_shared_weights(
+    const std::string& name, size_t length, uint32_t stride_shift, size_t& mapped_size, uint64_t& generation)
+{
+  const int fd = open_shared_weights(name, O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  shared_weights_header header;
+  struct stat status;
+  const size_t size = (length << stride_shift) * sizeof(float);
+  if (!read_header(fd, header) || fstat(fd, &status) != 0 ||
+      static_cast<size_t>(status.st_size) < SHARED_WEIGHTS_OFFSET + (header.length << header.stride_shift) * sizeof(float))
+  {
+    close(fd);
+    THROW(name << " does not hold shared weights");
+  }
+  if (header.length != length)
+  {
+    close(fd);
+    THROW(name << " holds " << header.length << " weights, not " << length);
+  }
+  if (header.stride_shift != stride_shift)
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, SHARED_WEIGHTS_OFFSET);
+  close(fd);
+  if (data == MAP_FAILED)
+    THROWERRNO("cannot map shared weights " << name);
+  mapped_size = size;
+  generation = header.generation;
+  return data;
+}
+
+uint64_t VW::publish_shared_weights(const std::string& name, const float* weights, size_t length, uint32_t stride_shift,
+    uint32_t published_stride_shift)
+{
+  shared_weights_header header;
+  memcpy(header.magic, SHARED_WEIGHTS_MAGIC, sizeof(SHARED_WEIGHTS_MAGIC));
+  header.format = SHARED_WEIGHTS_FORMAT;
+  header.stride_shift = published_stride_shift;
+  header.length = length;
+  header.generation = 1;
+
+  shared_weights_header previous;
+  const int previous_fd = open_shared_weights(name, O_RDONLY);
+  if (previous_fd >= 0)
+  {
+    if (read_header(previous_fd, previous))
+      header.generation = previous.generation + 1;
+    close(previous_fd);
+  }
+
+  // Written aside and renamed, so that nobody maps a partial publication.
+  const std::string writing = name + ".writing." + std::to_string(getpid());
+  const int fd = open_shared_weights(writing, O_RDWR | O_CREAT | O_TRUNC);
+  if (fd < 0)
+    THROWERRNO("cannot create shared weights " << writing);
+
+  const size_t size = (length << published_stride_shift) * sizeof(float);
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, SHARED_WEIGHTS_OFFSET + size) == 0 &&
+      pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)))
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, SHARED_WEIGHTS_OFFSET);
+  if (data == MAP_FAILED)
+  {
+    remove_shared_weights(writing);
+    close(fd);
+    THROWERRNO("cannot write shared weights " << writing);
+  }
+  if (published_stride_shift == stride_shift)
+    memcpy(data, weights, size);
+  else
+  {
+    const size_t published = size_t(1) << published_stride_shift;
+    float* destination = static_cast<float*>(data);
+    for (size_t i = 0; i < length; i++)
+      memcpy(destination + (i << published_stride_shift), weights + (i << stride_shift), published * sizeof(float));
+  }
+  munmap(data, size);
+  close(fd);
+
+  if (is_segment_name(name))
+  {
+#ifdef __linux__
+    // Segments are the files of /dev/shm.
+    if (rename(("/dev/shm" + writing).c_str(), ("/dev/shm" + name).c_str()) != 0)
+    {
+      remove_shared_weights(writing);
+      THROWERRNO("cannot publish shared weights " << name);
+    }
+#else
+    remove_shared_weights(writing);
+    THROW("shared memory segments can only be published on Linux, use a file for " << name);
+#endif
+  }
+  else if (rename(writing.c_str(), name.c_str()) != 0)
+  {
+    remove_shared_weights(writing);
+    THROWERRNO("cannot publish shared weights " << name);
+  }
+  return header.generation;
+}
+#else
+bool VW::shared_weights_published(const std::string&) { return false; }
+
+void* VW::map_shared_weights(const std::string&, size_t, uint32_t, size_t&, uint64_t&) { return nullptr; }
+
+uint64_t VW::publish_shared_weights(const std::string&, const float*, size_t, uint32_t, uint32_t)
+{
+  THROW("shared weights are not supported on Windows");
+}
+#endif
@@ -5,10 +5,84 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include "memory.h"
 
 typedef float weight;
 
+namespace VW
+{
+enum class huge_page_mode
+{
+  off,
+  transparent,
+  explicit_2mb,
+  explicit_1gb
+};
+
+enum class numa_mode
+{
+  off,
+  interleave,
+  bind
+};
+
+// Requested placement of dense weights, see --huge_pages and --numa_policy.
+struct weight_memory_options
+{
+  huge_page_mode huge_pages = huge_page_mode::off;
+  numa_mode numa = numa_mode::off;
+  // Node list such as "0-1,3", all online nodes if empty.
+  std::string numa_nodes;
+  // Segment or file the weights are published as, see --shared_weights.
+  std::string shared_weights;
+
+  bool requested() const { return huge_pages != huge_page_mode::off || numa != numa_mode::off; }
+};
+
+// Zeroed memory of at least size bytes placed according to options as far as the system allows. Each request that
+// cannot be met falls back to regular placement, description tells what was obtained. The memory is released with
+// munmap(data, mapped_size) if mapped_size is not zero and free(data) otherwise.
+void* allocate_weight_memory(
+    size_t size, const weight_memory_options& options, size_t& mapped_size, std::string& description);
+
+// Dense weights shared between processes through a POSIX shared memory segment (a name such as /model) or a file, see
+// --shared_weights. The header is followed by the weights at SHARED_WEIGHTS_OFFSET.
+struct shared_weights_header
+{
+  char magic[8];
+  uint32_t format;
+  uint32_t stride_shift;
+  // Number of weights, each of which takes 1 << stride_shift floats.
+  uint64_t length;
+  // Incremented by every publication under the same name.
+  uint64_t generation;
+};
+
+// A multiple of every page size, so that the weights can be mapped on their own.
+constexpr size_t SHARED_WEIGHTS_OFFSET = 1 << 16;
+
+// Maps the weights published as name, or returns nullptr if nothing is published with this stride. Throws unless there
+// are length of them. The mapping is private: its pages are those of every process mapping the same publication until
+// written to.
+void* map_shared_weights(const std::string& name, size_t length, uint32_t stride_shift, size_t& mapped_size,
+    uint64_t& generation);
+
+// Whether anything is published as name.
+bool shared_weights_published(const std::string& name);
+
+// Publishes the first 1 << published_stride_shift floats of each weight as name, replacing the previous publication for
+// the processes mapping it afterwards. Those which mapped it before keep the previous one. Returns the generation of the
+// new publication.
+uint64_t publish_shared_weights(const std::string& name, const float* weights, size_t length, uint32_t stride_shift,
+    uint32_t published_stride_shift);
+}  // namespace VW
+
 template <typename T>
 class dense_iterator
 {
@@ -47,6 +121,22 @@ class dense_parameters
   uint64_t _weight_mask;  // (stride*(1 << num_bits) -1)
   uint32_t _stride_shift;
   bool _seeded;  // whether the instance is sharing model state with others
+  size_t _mapped_size;  // non zero if _begin was mapped rather than allocated
+  bool _shared;  // whether _begin maps weights published by another process
+  std::string _memory_description;
+
+  void release()
+  {
+#ifndef _WIN32
+    if (_mapped_size != 0)
+      munmap(_begin, _mapped_size);
+    else
+#endif
+      free(_begin);
+    _begin = nullptr;
+    _mapped_size = 0;
+    _shared = false;
+  }
 
  public:
   typedef dense_iterator<weight> iterator;
@@ -56,10 +146,26 @@ class dense_parameters
       , _weight_mask((length << stride_shift) - 1)
       , _stride_shift(stride_shift)
       , _seeded(false)
+      , _mapped_size(0)
+      , _shared(false)
+  {
+  }
+
+  dense_parameters(size_t length, uint32_t stride_shift, const VW::weight_memory_options& memory_options)
+      : _begin(nullptr)
+      , _weight_mask((length << stride_shift) - 1)
+      , _stride_shift(stride_shift)
+      , _seeded(false)
+      , _shared(false)
   {
+    _begin = static_cast<weight*>(VW::allocate_weight_memory(
+        (length << stride_shift) * sizeof(weight), memory_options, _mapped_size, _memory_description));
   }
 
-  dense_parameters() : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false) {}
+  dense_parameters()
+      : _begin(nullptr), _weight_mask(0), _stride_shift(0), _seeded(false), _mapped_size(0), _shared(false)
+  {
+  }
 
   bool not_null() { return (_weight_mask > 0 && _begin != nullptr); }
 
@@ -86,7 +192,7 @@ class dense_parameters
   void shallow_copy(const dense_parameters& input)
   {
     if (!_seeded)
-      free(_begin);
+      release();
     _begin = input._begin;
     _weight_mask = input._weight_mask;
     _stride_shift = input._stride_shift;
@@ -121,17 +227,67 @@ class dense_parameters
 
   void stride_shift(uint32_t stride_shift) { _stride_shift = stride_shift; }
 
+  // What placement the weights were allocated with, empty unless requested through weight_memory_options.
+  const std::string& memory_description() const { return _memory_description; }
+
+  // Takes over the weights from memory mapped with mmap, such as a model image.
+  void adopt_mapping(weight* data, size_t mapped_size)
+  {
+    if (!_seeded)
+      release();
+    _begin = data;
+    _seeded = false;
+    _mapped_size = mapped_size;
+  }
+
+  // Uses length weights owned elsewhere, such as in a mapped model, which must outlive this instance.
+  void borrow(weight* data, size_t length)
+  {
+    if (!_seeded)
+      release();
+    _begin = data;
+    _weight_mask = (length << _stride_shift) - 1;
+    _seeded = true;
+    _mapped_size = 0;
+  }
+
+  // Whether the weights are those published as a shared_weights segment, which are not to be loaded again.
+  bool shared() const { return _shared; }
+
+  // Replaces the weights by those published as name, if any, see VW::map_shared_weights.
+  bool map_shared(const std::string& name, size_t length)
+  {
+    size_t mapped_size;
+    uint64_t generation;
+    void* data = VW::map_shared_weights(name, length, _stride_shift, mapped_size, generation);
+    if (data == nullptr)
+      return false;
+    if (!_seeded)
+      release();
+    _begin = static_cast<weight*>(data);
+    _weight_mask = (length << _stride_shift) - 1;
+    _seeded = false;
+    _mapped_size = mapped_size;
+    _shared = true;
+    _memory_description = name + " generation " + std::to_string(generation);
+    return true;
+  }
+
 #ifndef _WIN32
 #ifndef DISABLE_SHARED_WEIGHTS
   void share(size_t length)
   {
+    // Published weights are already shared by every process mapping them.
+    if (_shared)
+      return;
     float* shared_weights = (float*)mmap(
         0, (length << _stride_shift) * sizeof(float), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
     size_t float_count = length << _stride_shift;
     weight* dest = shared_weights;
     memcpy(dest, _begin, float_count * sizeof(float));
-    free(_begin);
+    release();
     _begin = dest;
+    _mapped_size = float_count * sizeof(float);
   }
 #endif
 #endif
@@ -139,9 +295,6 @@ class dense_parameters
   ~dense_parameters()
   {
     if (_begin != nullptr && !_seeded)  // don't free weight vector if it is shared with another instance
-    {
-      free(_begin);
-      _begin = nullptr;
-    }
+      release();
   }
 };
@@ -440,27 +440,35 @@ double wolfe_eval(vw& all, bfgs& b, float* mem, double loss_sum, double previous
         all.weights.dense_weights);
 }
 
-template <class T>
-double add_regularization(vw& all, bfgs& b, float regularization, T& weights)
+// Adds the regularization to the gradients of the weights from begin to end and returns its loss.
+template <class Iterator>
+double add_regularization(bfgs& b, float regularization, uint32_t stride_shift, Iterator begin, Iterator end)
 {
   // compute the derivative difference
   double ret = 0.;
 
   if (b.regularizers == nullptr)
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    for (Iterator w = begin; w != end; ++w)
     {
       (&(*w))[W_GT] += regularization * (*w);
       ret += 0.5 * regularization * (*w) * (*w);
     }
   else
-    for (typename T::iterator w = weights.begin(); w != weights.end(); ++w)
+    for (Iterator w = begin; w != end; ++w)
     {
-      uint64_t i = w.index() >> weights.stride_shift();
+      uint64_t i = w.index() >> stride_shift;
       weight delta_weight = *w - b.regularizers[2 * i + 1];
       (&(*w))[W_GT] += b.regularizers[2 * i] * delta_weight;
       ret += 0.5 * b.regularizers[2 * i] * delta_weight * delta_weight;
     }
 
+  return ret;
+}
+
+template <class T>
+double subtract_bias_regularization(vw& all, bfgs& b, float regularization, T& weights)
+{
+  double ret = 0.;
   // if we're not regularizing the intercept term, then subtract it off from the result above
   // when accessing weights[constant], always use weights.strided_index(constant)
   if (all.no_bias)
@@ -482,6 +490,13 @@ double add_regularization(vw& all, bfgs& b, float regularization, T& weights)
   return ret;
 }
 
+template <class T>
+double add_regularization(vw& all, bfgs& b, float regularization, T& weights)
+{
+  return add_regularization(b, regularization, weights.stride_shift(), weights.begin(), weights.end()) +
+      subtract_bias_regularization(all, b, regularization, weights);
+}
+
 double add_regularization(vw& all, bfgs& b, float regularization)
 {
   if (all.weights.sparse)
@@ -490,6 +505,33 @@ double add_regularization(vw& all, bfgs& b, float regularization)
     return add_regularization(all, b, regularization, all.weights.dense_weights);
 }
 
+// Sums the gradients of all nodes and, with l2 regularization, returns its loss. For dense weights the regularization
+// is added to each chunk of gradients as soon as it is summed, while the next chunks are still being summed.
+double accumulate_gradient(vw& all, bfgs& b)
+{
+  if (all.l2_lambda <= 0.)
+  {
+    accumulate(all, all.weights, W_GT);
+    return 0.;
+  }
+  if (all.weights.sparse)
+  {
+    accumulate(all, all.weights, W_GT);
+    return add_regularization(all, b, all.l2_lambda);
+  }
+
+  dense_parameters& weights = all.weights.dense_weights;
+  const uint32_t stride_shift = weights.stride_shift();
+  auto at = [&](uint64_t i) {
+    return dense_parameters::iterator(weights.first() + (i << stride_shift), weights.first(), weights.stride());
+  };
+  double ret = 0.;
+  accumulate(all, all.weights, W_GT, [&](uint64_t begin, uint64_t end) {
+    ret += add_regularization(b, all.l2_lambda, stride_shift, at(begin), at(end));
+  });
+  return ret + subtract_bias_regularization(all, b, all.l2_lambda, weights);
+}
+
 template <class T>
 void finalize_preconditioner(vw& /* all */, bfgs& b, float regularization, T& weights)
 {
@@ -653,9 +695,9 @@ int process_pass(vw& all, bfgs& b)
     {
       float temp = (float)b.loss_sum;
       b.loss_sum = accumulate_scalar(all, temp);  // Accumulate loss_sums
-      accumulate(all, all.weights, 1);            // Accumulate gradients from all nodes
+      b.loss_sum += accumulate_gradient(all, b);  // Accumulate gradients from all nodes
     }
-    if (all.l2_lambda > 0.)
+    else if (all.l2_lambda > 0.)
       b.loss_sum += add_regularization(all, b, all.l2_lambda);
     if (!all.logger.quiet)
       fprintf(stderr, "%2lu %-10.5f\t", (long unsigned int)b.current_pass + 1, b.loss_sum / b.importance_weight_sum);
@@ -690,10 +732,10 @@ int process_pass(vw& all, bfgs& b)
     if (all.all_reduce != nullptr)
     {
       float t = (float)b.loss_sum;
-      b.loss_sum = accumulate_scalar(all, t);  // Accumulate loss_sums
-      accumulate(all, all.weights, 1);         // Accumulate gradients from all nodes
+      b.loss_sum = accumulate_scalar(all, t);     // Accumulate loss_sums
+      b.loss_sum += accumulate_gradient(all, b);  // Accumulate gradients from all nodes
     }
-    if (all.l2_lambda > 0.)
+    else if (all.l2_lambda > 0.)
       b.loss_sum += add_regularization(all, b, all.l2_lambda);
     if (!all.logger.quiet)
     {
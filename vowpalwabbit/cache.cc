@@ -7,6 +7,22 @@
 #include "global_data.h"
 #include "vw.h"
 
+#include <cstring>
+#include <zlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VW_CACHE_BMI2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows BMI2 intrinsics in any function.
+#define VW_TARGET_BMI2
+#else
+#include <cpuid.h>
+#define VW_TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+#endif
+
 constexpr size_t int_size = 11;
 constexpr size_t char_size = 2;
 constexpr size_t neg_1 = 1;
@@ -61,32 +77,304 @@ __attribute__((packed))
 #endif
 ;
 
+namespace
+{
+// Features are stored as 7 bit varints, least significant group first, with the high bit set on all bytes but the
+// last. The decoders below differ only in how they read a varint. Those reading 8 bytes at once need 8 readable bytes
+// and otherwise fall back to run_len_decode(), as they do for varints longer than 8 bytes.
+constexpr uint64_t STOP_BITS = 0x8080808080808080;
+constexpr uint64_t VARINT_PAYLOAD = 0x7f7f7f7f7f7f7f7f;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool WORD_DECODE_SUPPORTED = false;
+#else
+constexpr bool WORD_DECODE_SUPPORTED = true;
+#endif
+
+inline unsigned count_trailing_zeros(uint64_t x)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return index;
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
+// Loads the varint at p as a word holding exactly its bytes and returns its length in bytes, or 0 if the varint does
+// not fit into 8 bytes.
+inline size_t load_varint_word(const char* p, uint64_t& word)
+{
+  memcpy(&word, p, sizeof(word));
+  const uint64_t stops = ~word & STOP_BITS;
+  if (stops == 0)
+    return 0;
+  const size_t len = (count_trailing_zeros(stops) >> 3) + 1;
+  if (len < sizeof(word))
+    word &= (UINT64_C(1) << (8 * len)) - 1;
+  return len;
+}
+
+// Value of a feature given the flags in its varint, consuming the float that follows if there is one.
+inline feature_value decode_value(char*& c, uint64_t i)
+{
+  feature_value v = 1.f;
+  if (i & neg_1)
+    v = -1.;
+  else if (i & general)
+  {
+    v = ((one_float*)c)->f;
+    c += sizeof(float);
+  }
+  return v;
+}
+
+struct scalar_varint
+{
+  char* operator()(char* p, const char*, uint64_t& i) const { return run_len_decode(p, i); }
+};
+
+struct swar_varint
+{
+  char* operator()(char* p, const char* end, uint64_t& i) const
+  {
+    uint64_t word;
+    size_t len;
+    if (end - p < 8 || (len = load_varint_word(p, word)) == 0)
+      return run_len_decode(p, i);
+
+    // Squeeze the 7 bit groups together, doubling the group width in each step.
+    word &= VARINT_PAYLOAD;
+    word = (word & 0x007f007f007f007f) | ((word & 0x7f007f007f007f00) >> 1);
+    word = (word & 0x00003fff00003fff) | ((word & 0x3fff00003fff0000) >> 2);
+    word = (word & 0x000000000fffffff) | ((word & 0x0fffffff00000000) >> 4);
+    i = word;
+    return p + len;
+  }
+};
+
+// Every feature takes at least one byte, so the arrays can be grown once up front and filled without checks through
+// local pointers, which the compiler can keep in registers.
+inline void reserve_features(features& ours, size_t storage)
+{
+  const size_t max_features = ours.size() + storage;
+  if (static_cast<size_t>(ours.values.end_array - ours.values.begin()) < max_features)
+    ours.values.resize(max_features);
+  if (static_cast<size_t>(ours.indicies.end_array - ours.indicies.begin()) < max_features)
+    ours.indicies.resize(max_features);
+}
+
+template <typename decode_varint_fn>
+inline void decode_features_with(char* c, char* end, features& ours, bool& sorted, decode_varint_fn decode_varint)
+{
+  reserve_features(ours, end - c);
+  feature_value* values = ours.values.end();
+  feature_index* indices = ours.indicies.end();
+  float sum_feat_sq = ours.sum_feat_sq;
+  uint64_t last = 0;
+
+  for (; c != end;)
+  {
+    feature_index i = 0;
+    c = decode_varint(c, end, i);
+    const feature_value v = decode_value(c, i);
+    uint64_t diff = i >> 2;
+    int64_t s_diff = ZigZagDecode(diff);
+    if (s_diff < 0)
+      sorted = false;
+    i = last + s_diff;
+    last = i;
+    *(values++) = v;
+    *(indices++) = i;
+    sum_feat_sq += v * v;
+  }
+  ours.values.end() = values;
+  ours.indicies.end() = indices;
+  ours.sum_feat_sq = sum_feat_sq;
+}
+
+void decode_features_scalar(char* c, char* end, features& ours, bool& sorted)
+{
+  decode_features_with(c, end, ours, sorted, scalar_varint{});
+}
+
+void decode_features_swar(char* c, char* end, features& ours, bool& sorted)
+{
+  decode_features_with(c, end, ours, sorted, swar_varint{});
+}
+
+#ifdef VW_CACHE_BMI2
+// Same as decode_features_with() and swar_varint, with the 7 bit groups gathered by a single pext. This cannot share
+// the template, code compiled for BMI2 must not end up in functions that run on any CPU.
+VW_TARGET_BMI2 void decode_features_bmi2(char* c, char* end, features& ours, bool& sorted)
+{
+  reserve_features(ours, end - c);
+  feature_value* values = ours.values.end();
+  feature_index* indices = ours.indicies.end();
+  float sum_feat_sq = ours.sum_feat_sq;
+  uint64_t last = 0;
+
+  for (; c != end;)
+  {
+    feature_index i = 0;
+    uint64_t word;
+    size_t len;
+    if (end - c >= 8 && (len = load_varint_word(c, word)) != 0)
+    {
+      i = _pext_u64(word, VARINT_PAYLOAD);
+      c += len;
+    }
+    else
+      c = run_len_decode(c, i);
+
+    const feature_value v = decode_value(c, i);
+    uint64_t diff = i >> 2;
+    int64_t s_diff = ZigZagDecode(diff);
+    if (s_diff < 0)
+      sorted = false;
+    i = last + s_diff;
+    last = i;
+    *(values++) = v;
+    *(indices++) = i;
+    sum_feat_sq += v * v;
+  }
+  ours.values.end() = values;
+  ours.indicies.end() = indices;
+  ours.sum_feat_sq = sum_feat_sq;
+}
+
+void cpuid(unsigned leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuidex(info, leaf, 0);
+  for (int r = 0; r < 4; r++) regs[r] = static_cast<unsigned>(info[r]);
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// pext is microcoded and very slow on AMD processors before Zen 3, fast_pext tells whether it is worth using.
+bool bmi2_supported(bool& fast_pext)
+{
+  fast_pext = false;
+  unsigned regs[4];
+  cpuid(0, regs);
+  const unsigned max_leaf = regs[0];
+  const bool is_amd = regs[1] == 0x68747541 && regs[3] == 0x69746e65 && regs[2] == 0x444d4163;  // "AuthenticAMD"
+  if (max_leaf < 7)
+    return false;
+
+  cpuid(7, regs);
+  if ((regs[1] & (1u << 8)) == 0)
+    return false;
+
+  fast_pext = true;
+  if (is_amd)
+  {
+    cpuid(1, regs);
+    unsigned family = (regs[0] >> 8) & 0xf;
+    if (family == 0xf)
+      family += (regs[0] >> 20) & 0xff;
+    fast_pext = family >= 0x19;
+  }
+  return true;
+}
+#endif
+
+VW::decode_cached_features_fn get_decoder(VW::cache_decoder decoder)
+{
+  switch (decoder)
+  {
+    case VW::cache_decoder::scalar:
+      return decode_features_scalar;
+    case VW::cache_decoder::swar:
+      return decode_features_swar;
+#ifdef VW_CACHE_BMI2
+    case VW::cache_decoder::bmi2:
+      return decode_features_bmi2;
+#endif
+    default:
+      THROW("cache decoder is not supported on this platform");
+  }
+}
+
+const VW::decode_cached_features_fn decode_features = get_decoder(VW::fastest_cache_decoder());
+}  // namespace
+
+bool VW::cache_decoder_supported(cache_decoder decoder)
+{
+  switch (decoder)
+  {
+    case cache_decoder::scalar:
+      return true;
+    case cache_decoder::swar:
+      return WORD_DECODE_SUPPORTED;
+    case cache_decoder::bmi2:
+    {
+#ifdef VW_CACHE_BMI2
+      bool fast_pext;
+      return bmi2_supported(fast_pext);
+#else
+      return false;
+#endif
+    }
+  }
+  return false;
+}
+
+VW::cache_decoder VW::fastest_cache_decoder()
+{
+#ifdef VW_CACHE_BMI2
+  bool fast_pext;
+  if (bmi2_supported(fast_pext) && fast_pext)
+    return cache_decoder::bmi2;
+#endif
+  return WORD_DECODE_SUPPORTED ? cache_decoder::swar : cache_decoder::scalar;
+}
+
+VW::decode_cached_features_fn VW::get_cached_features_decoder(cache_decoder decoder)
+{
+  if (!cache_decoder_supported(decoder))
+    THROW("cache decoder is not supported on this CPU");
+  return get_decoder(decoder);
+}
+
 int read_cached_features(vw* all, v_array<example*>& examples)
 {
-  example* ae = examples[0];
-  ae->sorted = all->p->sorted_cache;
-  io_buf* input = all->p->input;
+  return VW::read_cached_example(*all, *all->p->input, examples[0]);
+}
+
+int read_cached_block_features(vw* all, v_array<example*>& examples)
+{
+  return all->p->cache_reader->read_example(*all, *all->p->input, examples[0]);
+}
+
+int VW::read_cached_example(vw& all, io_buf& input, example* ae)
+{
+  ae->sorted = all.p->sorted_cache;
 
-  size_t total = all->p->lp.read_cached_label(all->p->_shared_data, &ae->l, *input);
+  size_t total = all.p->lp.read_cached_label(all.p->_shared_data, &ae->l, input);
   if (total == 0)
     return 0;
-  if (read_cached_tag(*input, ae) == 0)
+  if (read_cached_tag(input, ae) == 0)
     return 0;
   char* c;
   unsigned char num_indices = 0;
-  if (input->buf_read(c, sizeof(num_indices)) < sizeof(num_indices))
+  if (input.buf_read(c, sizeof(num_indices)) < sizeof(num_indices))
     return 0;
   num_indices = *(unsigned char*)c;
   c += sizeof(num_indices);
 
-  all->p->input->set(c);
+  input.set(c);
   for (; num_indices > 0; num_indices--)
   {
     size_t temp;
     unsigned char index = 0;
-    if ((temp = input->buf_read(c, sizeof(index) + sizeof(size_t))) < sizeof(index) + sizeof(size_t))
+    if ((temp = input.buf_read(c, sizeof(index) + sizeof(size_t))) < sizeof(index) + sizeof(size_t))
     {
-      all->trace_message << "truncated example! " << temp << " " << char_size + sizeof(size_t) << std::endl;
+      all.trace_message << "truncated example! " << temp << " " << char_size + sizeof(size_t) << std::endl;
       return 0;
     }
 
@@ -96,39 +384,18 @@ int read_cached_features(vw* all, v_array<example*>& examples)
     features& ours = ae->feature_space[index];
     size_t storage = *(size_t*)c;
     c += sizeof(size_t);
-    all->p->input->set(c);
+    input.set(c);
     total += storage;
-    if (input->buf_read(c, storage) < storage)
+    if (input.buf_read(c, storage) < storage)
     {
-      all->trace_message << "truncated example! wanted: " << storage << " bytes" << std::endl;
+      all.trace_message << "truncated example! wanted: " << storage << " bytes" << std::endl;
       return 0;
     }
 
     char* end = c + storage;
-
-    uint64_t last = 0;
-
-    for (; c != end;)
-    {
-      feature_index i = 0;
-      c = run_len_decode(c, i);
-      feature_value v = 1.f;
-      if (i & neg_1)
-        v = -1.;
-      else if (i & general)
-      {
-        v = ((one_float*)c)->f;
-        c += sizeof(float);
-      }
-      uint64_t diff = i >> 2;
-      int64_t s_diff = ZigZagDecode(diff);
-      if (s_diff < 0)
-        ae->sorted = false;
-      i = last + s_diff;
-      last = i;
-      ours.push_back(v, i);
-    }
-    all->p->input->set(c);
+    decode_features(c, end, ours, ae->sorted);
+    c = end;
+    input.set(c);
   }
 
   return (int)total;
@@ -215,3 +482,187 @@ uint32_t VW::convert(size_t number)
   }
   return static_cast<uint32_t>(number);
 }
+
+VW::cache_block_writer::cache_block_writer(io_buf& output, uint64_t offset, bool compress)
+    : _output(output), _offset(offset), _compress(compress), _block(std::make_shared<std::vector<char>>())
+{
+  _block->reserve(CACHE_BLOCK_SIZE);
+  _example_buf.add_file(VW::io::create_vector_writer(_block));
+}
+
+void VW::cache_block_writer::end_example()
+{
+  _example_buf.flush();
+  _block_examples++;
+  if (_block->size() >= CACHE_BLOCK_SIZE)
+    write_block();
+}
+
+void VW::cache_block_writer::write_example(const char* data, size_t len)
+{
+  _block->insert(_block->end(), data, data + len);
+  _block_examples++;
+  if (_block->size() >= CACHE_BLOCK_SIZE)
+    write_block();
+}
+
+void VW::cache_block_writer::finish()
+{
+  write_block();
+
+  std::vector<char> index(_index.size() * sizeof(cache_index_entry) + sizeof(cache_index_trailer));
+  if (!_index.empty())
+    memcpy(index.data(), _index.data(), _index.size() * sizeof(cache_index_entry));
+  cache_index_trailer trailer{_offset, _index.size(), CACHE_INDEX_MAGIC};
+  memcpy(index.data() + _index.size() * sizeof(cache_index_entry), &trailer, sizeof(trailer));
+
+  write_section(cache_section_kind::index, 0, index.size(), index.data(), index.size());
+  _output.flush();
+}
+
+void VW::cache_block_writer::write_block()
+{
+  if (_block_examples == 0)
+    return;
+
+  _index.push_back({_offset, _block_examples});
+  const char* data = _block->data();
+  size_t len = _block->size();
+  auto kind = cache_section_kind::raw_block;
+  if (_compress)
+  {
+    uLongf deflated_len = compressBound(static_cast<uLong>(len));
+    _deflated.resize(deflated_len);
+    // Stored raw if deflating does not pay off.
+    if (compress2(reinterpret_cast<Bytef*>(_deflated.data()), &deflated_len, reinterpret_cast<const Bytef*>(data),
+            static_cast<uLong>(len), Z_BEST_SPEED) == Z_OK &&
+        deflated_len < len)
+    {
+      data = _deflated.data();
+      len = deflated_len;
+      kind = cache_section_kind::deflated_block;
+    }
+  }
+  write_section(kind, _block_examples, _block->size(), data, len);
+
+  _block->clear();
+  _block_examples = 0;
+}
+
+void VW::cache_block_writer::write_section(
+    cache_section_kind kind, uint32_t num_examples, uint64_t raw_size, const char* data, size_t len)
+{
+  cache_section_header header{static_cast<uint32_t>(kind), num_examples, raw_size, len};
+  _output.bin_write_fixed(reinterpret_cast<const char*>(&header), sizeof(header));
+  _output.bin_write_fixed(data, len);
+  _offset += sizeof(header) + len;
+}
+
+int VW::cache_block_reader::read_example(vw& all, io_buf& input, example* ae)
+{
+  while (_examples_left == 0)
+    if (!next_section(all, input))
+      return 0;
+
+  _examples_left--;
+  return read_cached_example(all, _block_buf, ae);
+}
+
+void VW::cache_block_reader::reset()
+{
+  _block_buf.close_files();
+  _block_buf.reset_buffer();
+  _examples_left = 0;
+}
+
+bool VW::cache_block_reader::next_section(vw& all, io_buf& input)
+{
+  reset();
+
+  char* p;
+  cache_section_header header;
+  size_t read = input.buf_read(p, sizeof(header));
+  if (read < sizeof(header))
+  {
+    if (read > 0)
+      all.trace_message << "truncated cache section header!" << std::endl;
+    return false;
+  }
+  memcpy(&header, p, sizeof(header));
+
+  // The payload is viewed in place. It stays valid until input is read again, which only happens once the block is
+  // used up.
+  if (input.buf_read(p, header.stored_size) < header.stored_size)
+  {
+    all.trace_message << "truncated cache section! wanted: " << header.stored_size << " bytes" << std::endl;
+    return false;
+  }
+
+  switch (static_cast<cache_section_kind>(header.kind))
+  {
+    case cache_section_kind::raw_block:
+      break;
+    case cache_section_kind::deflated_block:
+    {
+      _inflated.resize(header.raw_size);
+      uLongf inflated_len = static_cast<uLongf>(header.raw_size);
+      if (uncompress(reinterpret_cast<Bytef*>(_inflated.data()), &inflated_len, reinterpret_cast<const Bytef*>(p),
+              static_cast<uLong>(header.stored_size)) != Z_OK ||
+          inflated_len != header.raw_size)
+        THROW("corrupt cache block");
+      p = _inflated.data();
+      break;
+    }
+    case cache_section_kind::index:
+      // Nothing to decode, the next section belongs to the next cache file if any.
+      return true;
+    default:
+      THROW("unknown cache section kind " << header.kind << ", cache file is probably invalid");
+  }
+
+  _block_buf.add_file(VW::io::create_buffer_view(p, header.raw_size));
+  _examples_left = header.num_examples;
+  return true;
+}
+
+bool VW::read_cache_index(const std::string& file_name, std::vector<cache_index_entry>& blocks)
+{
+  auto reader = VW::io::open_mmap_file_reader(file_name);
+  const char* data;
+  size_t len;
+  std::vector<char> contents;
+  if (!reader->take_remaining(data, len))
+  {
+    char buffer[1 << 16];
+    ssize_t num_read;
+    while ((num_read = reader->read(buffer, sizeof(buffer))) > 0) contents.insert(contents.end(), buffer, buffer + num_read);
+    data = contents.data();
+    len = contents.size();
+  }
+
+  size_t v_length;
+  if (len < sizeof(v_length))
+    return false;
+  memcpy(&v_length, data, sizeof(v_length));
+  if (v_length > 61)
+    return false;
+  const size_t header_size = sizeof(v_length) + v_length + 1 + sizeof(uint32_t);
+  if (len < header_size + sizeof(cache_section_header) + sizeof(cache_index_trailer) ||
+      data[sizeof(v_length) + v_length] != BLOCK_CACHE_MARKER)
+    return false;
+
+  cache_index_trailer trailer;
+  memcpy(&trailer, data + len - sizeof(trailer), sizeof(trailer));
+  cache_section_header header;
+  if (trailer.magic != CACHE_INDEX_MAGIC || trailer.index_offset < header_size ||
+      trailer.index_offset + sizeof(header) + trailer.num_blocks * sizeof(cache_index_entry) + sizeof(trailer) != len)
+    return false;
+  memcpy(&header, data + trailer.index_offset, sizeof(header));
+  if (header.kind != static_cast<uint32_t>(cache_section_kind::index))
+    return false;
+
+  blocks.resize(trailer.num_blocks);
+  if (!blocks.empty())
+    memcpy(blocks.data(), data + trailer.index_offset + sizeof(header), blocks.size() * sizeof(cache_index_entry));
+  return true;
+}
@@ -7,10 +7,16 @@
 #include "io_buf.h"
 #include "example.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 char* run_len_decode(char* p, size_t& i);
 char* run_len_encode(char* p, size_t i);
 
 int read_cached_features(vw* all, v_array<example*>& examples);
+int read_cached_block_features(vw* all, v_array<example*>& examples);
 void cache_tag(io_buf& cache, v_array<char> tag);
 void cache_features(io_buf& cache, example* ae, uint64_t mask);
 void output_byte(io_buf& cache, unsigned char s);
@@ -19,4 +25,121 @@ void output_features(io_buf& cache, unsigned char index, features& fs, uint64_t
 namespace VW
 {
 uint32_t convert(size_t number);
-}
+
+// Ways to decode the varints of cached features, which is the bulk of the work when reading a cache. All give the same
+// result, the fastest one the CPU supports is picked at startup.
+enum class cache_decoder
+{
+  scalar,  // one byte at a time
+  swar,    // 8 bytes at a time with word operations, on little endian platforms
+  bmi2     // 8 bytes at a time with pext, on x86-64 CPUs with a fast implementation of it
+};
+bool cache_decoder_supported(cache_decoder decoder);
+cache_decoder fastest_cache_decoder();
+
+// Decodes the features of one namespace as written by output_features(), without the leading index and size, appending
+// them to fs. sorted is cleared if the indices are not increasing.
+using decode_cached_features_fn = void (*)(char* begin, char* end, features& fs, bool& sorted);
+// Throws if the decoder is not supported.
+decode_cached_features_fn get_cached_features_decoder(cache_decoder decoder);
+
+// Decodes one example in the per example cache encoding from input. Returns the number of bytes decoded, 0 if the input
+// ran out.
+int read_cached_example(vw& all, io_buf& input, example* ae);
+
+/*
+ * Block cache format
+ *
+ * The file starts with the same header as the legacy format, with BLOCK_CACHE_MARKER in place of LEGACY_CACHE_MARKER.
+ * Then come sections, each a cache_section_header followed by its payload. A block section holds the per example
+ * encoding of a run of examples, deflated if the cache was created with --compressed. A block is closed once it holds
+ * at least CACHE_BLOCK_SIZE bytes. The last section is the index, a cache_index_entry per block followed by a
+ * cache_index_trailer. The trailer ends the file, so the index can be located without reading any blocks, which allows
+ * blocks to be read, decoded or assigned to different readers independently.
+ */
+constexpr char LEGACY_CACHE_MARKER = 'c';
+constexpr char BLOCK_CACHE_MARKER = 'b';
+constexpr size_t CACHE_BLOCK_SIZE = 1 << 18;
+constexpr uint64_t CACHE_INDEX_MAGIC = 0x5844494b434f4c42;  // "BLOCKIDX"
+
+enum class cache_section_kind : uint32_t
+{
+  raw_block = 1,
+  deflated_block = 2,
+  index = 3
+};
+
+struct cache_section_header
+{
+  uint32_t kind;
+  uint32_t num_examples;
+  uint64_t raw_size;     // payload size after inflating
+  uint64_t stored_size;  // payload size in the file
+};
+
+struct cache_index_entry
+{
+  uint64_t offset;  // file offset of the section header of the block
+  uint64_t num_examples;
+};
+
+struct cache_index_trailer
+{
+  uint64_t index_offset;  // file offset of the section header of the index
+  uint64_t num_blocks;
+  uint64_t magic;
+};
+
+class cache_block_writer
+{
+ public:
+  // offset is the number of bytes already written to output, i.e. the size of the header.
+  cache_block_writer(io_buf& output, uint64_t offset, bool compress);
+
+  // Examples are encoded into this buffer with cache_label() and cache_features(), followed by end_example().
+  io_buf& example_buf() { return _example_buf; }
+  void end_example();
+
+  // Appends an example that has already been encoded.
+  void write_example(const char* data, size_t len);
+
+  // Writes the last block and the index. Nothing may be written afterwards.
+  void finish();
+
+ private:
+  void write_block();
+  void write_section(cache_section_kind kind, uint32_t num_examples, uint64_t raw_size, const char* data, size_t len);
+
+  io_buf& _output;
+  uint64_t _offset;
+  bool _compress;
+  std::shared_ptr<std::vector<char>> _block;
+  io_buf _example_buf;
+  uint32_t _block_examples = 0;
+  std::vector<char> _deflated;
+  std::vector<cache_index_entry> _index;
+};
+
+class cache_block_reader
+{
+ public:
+  // Decodes the next example of the block cache read from input. Returns the number of bytes decoded, 0 at the end of
+  // the input.
+  int read_example(vw& all, io_buf& input, example* ae);
+
+  // Must be called when input is reset.
+  void reset();
+
+ private:
+  bool next_section(vw& all, io_buf& input);
+
+  // Views the current block, which is either in input or in _inflated.
+  io_buf _block_buf;
+  std::vector<char> _inflated;
+  size_t _examples_left = 0;
+};
+
+// Reads the index of a block cache file. Returns false if the file is not a block cache or lacks the index, which is
+// the case while it is still being written.
+bool read_cache_index(const std::string& file_name, std::vector<cache_index_entry>& blocks);
+}  // namespace VW
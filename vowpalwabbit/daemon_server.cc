@@ -0,0 +1,566 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "daemon_server.h"
+
+#include "global_data.h"
+#include "parser.h"
+#include "vw.h"
+#include "vw_exception.h"
+#include "options_serializer_boost_po.h"
+#include "io/io_adapter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Batches waiting for a prediction thread. The event loop waits for room once there are more.
+constexpr size_t MAX_QUEUED_BATCHES = 4096;
+constexpr size_t READ_CHUNK_SIZE = 1 << 16;
+constexpr int MAX_EVENTS = 256;
+
+// Options of the served instance which the instances of the prediction threads must not act on.
+const char* const SERVER_ONLY_OPTIONS[] = {"daemon", "daemon_threads", "port", "port_file", "pid_file", "num_children",
+    "foreground", "data", "cache", "cache_file", "kill_cache", "no_stdin", "initial_regressor", "final_regressor",
+    "predictions", "raw_predictions", "readable_model", "invert_hash", "save_per_pass", "save_resume", "quiet",
+    "daemon_batch_size", "daemon_batch_wait"};
+
+bool is_blank(const char* begin, const char* end)
+{
+  return std::all_of(begin, end, [](char c) { return c == ' ' || c == '\t' || c == '\r'; });
+}
+}  // namespace
+
+namespace VW
+{
+struct daemon_server::connection
+{
+  int fd;
+  std::vector<char> input;
+  std::vector<char> output;
+  size_t output_sent = 0;
+  // Events the socket is registered for in epoll, -1 if it is not registered.
+  int events = -1;
+  bool busy = false;
+  bool end_of_input = false;
+  bool failed = false;
+
+  bool output_pending() const { return output_sent < output.size(); }
+};
+
+struct daemon_server::request
+{
+  int fd;
+  // Complete lines, each terminated by '\n'.
+  std::vector<char> text;
+  std::vector<char> response;
+  std::string error;
+};
+
+struct daemon_server::batch
+{
+  std::vector<std::unique_ptr<request>> requests;
+  // Lines in all requests.
+  size_t lines = 0;
+  std::chrono::steady_clock::time_point deadline;
+};
+
+struct daemon_server::worker
+{
+  vw* instance = nullptr;
+  std::shared_ptr<std::vector<char>> output = std::make_shared<std::vector<char>>();
+  multi_ex examples;
+};
+}  // namespace VW
+
+#ifdef __linux__
+namespace
+{
+vw* create_prediction_instance(vw& all)
+{
+  VW::config::options_serializer_boost_po serializer;
+  for (auto const& option : all.options->get_all_options())
+  {
+    if (!all.options->was_supplied(option->m_name))
+      continue;
+    const auto& name = option->m_name;
+    if (std::any_of(std::begin(SERVER_ONLY_OPTIONS), std::end(SERVER_ONLY_OPTIONS),
+            [&name](const char* server_only) { return name == server_only; }))
+      continue;
+    serializer.add(*option);
+  }
+
+  vw* instance = VW::initialize(serializer.str() + " --no_daemon --no_stdin --quiet", nullptr, true /* skipModelLoad */);
+  instance->weights.shallow_copy(all.weights);
+
+  // The statistics are updated with every example, so each instance keeps its own copy. The copy shares the label
+  // dictionary of the served instance, which owns it.
+  if (instance->sd->ldict)
+  {
+    instance->sd->ldict->~named_labels();
+    free(instance->sd->ldict);
+  }
+  instance->sd->copy_from(*all.sd);
+  return instance;
+}
+
+void destroy_prediction_instance(vw* instance)
+{
+  // Shallow copied weights make the instance leave sd alone.
+  shared_data* sd = instance->sd;
+  VW::finish(*instance);
+  free(sd);
+}
+}  // namespace
+
+VW::daemon_server::daemon_server(
+    vw& all, int listen_socket, size_t num_threads, size_t batch_size, size_t batch_wait_us)
+    : _all(all)
+    , _listen_socket(listen_socket)
+    , _multiline(all.l->is_multiline)
+    , _batch_size(std::max<size_t>(batch_size, 1))
+    , _batch_wait(batch_wait_us)
+    , _batches(MAX_QUEUED_BATCHES)
+{
+  if (all.training)
+    THROW("--daemon_threads only predicts, use it with -t");
+
+  // The default backlog of daemon mode is a single connection.
+  if (listen(_listen_socket, SOMAXCONN) < 0)
+    THROWERRNO("listen");
+  if (fcntl(_listen_socket, F_SETFL, fcntl(_listen_socket, F_GETFL) | O_NONBLOCK) < 0)
+    THROWERRNO("fcntl");
+
+  _epoll = epoll_create1(EPOLL_CLOEXEC);
+  if (_epoll < 0)
+    THROWERRNO("epoll_create1");
+  _wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_wake < 0)
+    THROWERRNO("eventfd");
+  _timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (_timer < 0)
+    THROWERRNO("timerfd_create");
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = _listen_socket;
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _listen_socket, &event) < 0)
+    THROWERRNO("epoll_ctl");
+  event.data.fd = _wake;
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &event) < 0)
+    THROWERRNO("epoll_ctl");
+  event.data.fd = _timer;
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &event) < 0)
+    THROWERRNO("epoll_ctl");
+
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    _workers.emplace_back(new worker);
+    auto& state = *_workers.back();
+    state.instance = create_prediction_instance(all);
+    state.instance->final_prediction_sink.push_back(VW::io::create_vector_writer(state.output));
+  }
+  for (auto& state : _workers) _threads.emplace_back(&daemon_server::worker_loop, this, std::ref(*state));
+}
+
+VW::daemon_server::~daemon_server()
+{
+  _batches.set_done();
+  for (auto& thread : _threads) thread.join();
+  for (auto& state : _workers) destroy_prediction_instance(state->instance);
+  for (auto& entry : _connections) close(entry.first);
+  for (auto* completed : _completed) delete completed;
+  if (_timer >= 0)
+    close(_timer);
+  if (_wake >= 0)
+    close(_wake);
+  if (_epoll >= 0)
+    close(_epoll);
+}
+
+void VW::daemon_server::run()
+{
+  epoll_event events[MAX_EVENTS];
+  while (!_stopping || _in_flight > 0)
+  {
+    const int count = epoll_wait(_epoll, events, MAX_EVENTS, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      THROWERRNO("epoll_wait");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+      const int fd = events[i].data.fd;
+      if (fd == _listen_socket)
+      {
+        if (!_stopping)
+          accept_connections();
+        continue;
+      }
+      if (fd == _wake)
+      {
+        uint64_t value;
+        while (read(_wake, &value, sizeof(value)) > 0)
+        {
+        }
+        complete_batches();
+        continue;
+      }
+      if (fd == _timer)
+      {
+        uint64_t expirations;
+        while (read(_timer, &expirations, sizeof(expirations)) > 0)
+        {
+        }
+        continue;
+      }
+
+      auto found = _connections.find(fd);
+      if (found == _connections.end())
+        continue;
+      auto& conn = *found->second;
+      if (events[i].events & EPOLLOUT)
+        write_output(conn);
+      if (!conn.failed && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        read_input(conn);
+      dispatch(conn);
+    }
+
+    // Whatever arrived in this round goes out together, unless the batch may still wait for more.
+    if (_pending != nullptr)
+    {
+      const auto now = std::chrono::steady_clock::now();
+      if (_stopping || now >= _pending->deadline)
+        submit_batch();
+      else
+        set_timer(_pending->deadline - now);
+    }
+  }
+}
+
+void VW::daemon_server::stop()
+{
+  _stopping = true;
+  const uint64_t one = 1;
+  if (write(_wake, &one, sizeof(one)) < 0)
+  {
+    // The counter is saturated, so the event loop wakes up anyway.
+  }
+}
+
+void VW::daemon_server::accept_connections()
+{
+  while (true)
+  {
+    const int fd = accept4(_listen_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno == EMFILE || errno == ENFILE)
+      {
+        // Stop listening until a connection is closed, instead of being woken up for the pending one over and over.
+        _all.trace_message << "accept: " << VW::strerror_to_string(errno) << ", pausing new connections" << std::endl;
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, _listen_socket, nullptr);
+        _accepting = false;
+      }
+      else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR)
+        _all.trace_message << "accept: " << VW::strerror_to_string(errno) << std::endl;
+      if (errno != ECONNABORTED && errno != EINTR)
+        return;
+      continue;
+    }
+
+    // Disable Nagle delay algorithm due to daemon mode's interactive workload
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&one), sizeof(one));
+
+    std::unique_ptr<connection> conn(new connection);
+    conn->fd = fd;
+    auto& added = *conn;
+    _connections[fd] = std::move(conn);
+    update_events(added);
+  }
+}
+
+void VW::daemon_server::read_input(connection& conn)
+{
+  while (!conn.end_of_input)
+  {
+    const size_t used = conn.input.size();
+    conn.input.resize(used + READ_CHUNK_SIZE);
+    const ssize_t received = recv(conn.fd, conn.input.data() + used, READ_CHUNK_SIZE, 0);
+    conn.input.resize(used + std::max<ssize_t>(received, 0));
+    if (received > 0)
+      continue;
+    if (received == 0)
+      conn.end_of_input = true;
+    else if (errno == EINTR)
+      continue;
+    else if (errno != EAGAIN && errno != EWOULDBLOCK)
+      conn.failed = true;
+    break;
+  }
+}
+
+void VW::daemon_server::dispatch(connection& conn)
+{
+  if (!conn.busy && !conn.failed && !conn.output_pending() && !conn.input.empty())
+  {
+    // Everything up to the last newline, or to the end of the last empty line for multiline learners.
+    size_t end = 0;
+    size_t line_start = 0;
+    for (size_t i = 0; i < conn.input.size(); i++)
+    {
+      if (conn.input[i] != '\n')
+        continue;
+      if (!_multiline || is_blank(conn.input.data() + line_start, conn.input.data() + i))
+        end = i + 1;
+      line_start = i + 1;
+    }
+    if (conn.end_of_input)
+      end = conn.input.size();
+
+    if (end > 0)
+    {
+      std::unique_ptr<request> req(new request);
+      req->fd = conn.fd;
+      req->text.assign(conn.input.begin(), conn.input.begin() + end);
+      if (req->text.back() != '\n')
+        req->text.push_back('\n');
+      conn.input.erase(conn.input.begin(), conn.input.begin() + end);
+      conn.busy = true;
+      _in_flight++;
+
+      if (_pending == nullptr)
+      {
+        _pending.reset(new batch);
+        _pending->deadline = std::chrono::steady_clock::now() + _batch_wait;
+      }
+      _pending->lines += std::count(req->text.begin(), req->text.end(), '\n');
+      _pending->requests.push_back(std::move(req));
+      if (_pending->lines >= _batch_size)
+        submit_batch();
+    }
+  }
+
+  if (!conn.busy && (conn.failed || (conn.end_of_input && conn.input.empty() && !conn.output_pending())))
+    close_connection(conn);
+  else
+    update_events(conn);
+}
+
+void VW::daemon_server::submit_batch()
+{
+  if (_batch_wait.count() > 0)
+    set_timer(std::chrono::steady_clock::duration::zero());
+  _batches.push(_pending.release());
+}
+
+void VW::daemon_server::set_timer(std::chrono::steady_clock::duration delay)
+{
+  // A zero delay disarms the timer.
+  const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count();
+  itimerspec value{};
+  value.it_value.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+  value.it_value.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+  if (timerfd_settime(_timer, 0, &value, nullptr) < 0)
+    THROWERRNO("timerfd_settime");
+}
+
+void VW::daemon_server::write_output(connection& conn)
+{
+  while (conn.output_pending())
+  {
+    const ssize_t sent =
+        send(conn.fd, conn.output.data() + conn.output_sent, conn.output.size() - conn.output_sent, MSG_NOSIGNAL);
+    if (sent >= 0)
+      conn.output_sent += sent;
+    else if (errno == EINTR)
+      continue;
+    else
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        conn.failed = true;
+      break;
+    }
+  }
+  if (!conn.output_pending())
+  {
+    conn.output.clear();
+    conn.output_sent = 0;
+  }
+}
+
+void VW::daemon_server::complete_batches()
+{
+  std::vector<batch*> completed;
+  {
+    std::lock_guard<std::mutex> lock(_completed_lock);
+    completed.swap(_completed);
+  }
+
+  for (auto* completed_batch : completed)
+  {
+    std::unique_ptr<batch> done(completed_batch);
+    for (auto& req : done->requests) complete_request(*req);
+  }
+}
+
+void VW::daemon_server::complete_request(request& req)
+{
+  _in_flight--;
+  // Connections are only closed while idle, so the connection of a request is still there.
+  auto& conn = *_connections[req.fd];
+  conn.busy = false;
+  conn.output.insert(conn.output.end(), req.response.begin(), req.response.end());
+  if (!req.error.empty())
+  {
+    _all.trace_message << "daemon connection " << conn.fd << ": " << req.error << std::endl;
+    conn.failed = true;
+  }
+  write_output(conn);
+  dispatch(conn);
+}
+
+void VW::daemon_server::update_events(connection& conn)
+{
+  // Input is only read while there is nothing else to do for the connection, which bounds what it can buffer.
+  int events = 0;
+  if (conn.output_pending())
+    events = EPOLLOUT;
+  else if (!conn.busy && !conn.end_of_input)
+    events = EPOLLIN;
+  if (events == conn.events)
+    return;
+
+  // A socket without events is taken out of epoll, as hangups are reported regardless of the events asked for.
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = conn.fd;
+  if (events == 0)
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, conn.fd, nullptr);
+  else if (epoll_ctl(_epoll, conn.events == -1 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, conn.fd, &event) < 0)
+    THROWERRNO("epoll_ctl");
+  conn.events = events == 0 ? -1 : events;
+}
+
+void VW::daemon_server::close_connection(connection& conn)
+{
+  const int fd = conn.fd;
+  if (conn.events != -1)
+    epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+  _connections.erase(fd);
+  close(fd);
+
+  if (!_accepting && !_stopping)
+  {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = _listen_socket;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _listen_socket, &event) == 0)
+      _accepting = true;
+  }
+}
+
+void VW::daemon_server::worker_loop(worker& state)
+{
+  batch* requests;
+  while ((requests = _batches.pop()) != nullptr)
+  {
+    for (auto& req : requests->requests)
+    {
+      try
+      {
+        process(state, *req);
+      }
+      catch (std::exception& e)
+      {
+        // Parsed examples that never made it to the learner go back to the pool without output.
+        for (auto* ex : state.examples) VW::clean_example(*state.instance, *ex, false);
+        state.examples.clear();
+        req->error = e.what();
+      }
+      req->response.swap(*state.output);
+      state.output->clear();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_completed_lock);
+      _completed.push_back(requests);
+    }
+    const uint64_t one = 1;
+    if (write(_wake, &one, sizeof(one)) < 0)
+    {
+      // The counter is saturated, so the event loop wakes up anyway.
+    }
+  }
+}
+
+void VW::daemon_server::process(worker& state, request& req)
+{
+  vw& instance = *state.instance;
+  char* line = req.text.data();
+  char* const end = req.text.data() + req.text.size();
+  while (line < end)
+  {
+    char* line_end = static_cast<char*>(memchr(line, '\n', end - line));
+    *line_end = '\0';
+
+    if (_multiline && is_blank(line, line_end))
+    {
+      if (!state.examples.empty())
+      {
+        instance.learn(state.examples);
+        instance.finish_example(state.examples);
+        state.examples.clear();
+      }
+    }
+    else
+    {
+      example* ex = VW::read_example(instance, line);
+      if (_multiline)
+        state.examples.push_back(ex);
+      else
+      {
+        instance.learn(*ex);
+        instance.finish_example(*ex);
+      }
+    }
+    line = line_end + 1;
+  }
+
+  // The client closed the connection without ending the last multiline example.
+  if (!state.examples.empty())
+  {
+    instance.learn(state.examples);
+    instance.finish_example(state.examples);
+    state.examples.clear();
+  }
+}
+#else
+VW::daemon_server::daemon_server(vw& all, int listen_socket, size_t, size_t, size_t)
+    : _all(all), _listen_socket(listen_socket), _multiline(false), _batch_size(1), _batch_wait(0), _batches(1)
+{
+  THROW("--daemon_threads is only supported on Linux");
+}
+
+VW::daemon_server::~daemon_server() = default;
+void VW::daemon_server::run() {}
+void VW::daemon_server::stop() {}
+#endif
@@ -0,0 +1,97 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+#pragma once
+
+#include "queue.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct vw;
+
+namespace VW
+{
+/*
+ * Persistent daemon mode serving many connections from one process, as an alternative to forking --num_children
+ * processes which serve one connection each.
+ *
+ * One thread waits on all sockets with epoll, reads what clients send and writes back what they are due. All complete
+ * lines received on a connection form one request, which goes to a pool of prediction threads, and the predictions for
+ * all its lines go back in one write. A client can therefore send any number of examples without waiting for the
+ * predictions of earlier ones. A connection has at most one request in flight, so its predictions come back in the
+ * order of its examples. With a multiline learner requests end after an empty line, so that no multiline example is
+ * split across requests.
+ *
+ * Requests of different connections can be coalesced into batches, which trades latency for throughput when many
+ * clients send few examples each. A batch goes to a prediction thread once it holds batch_size examples or its first
+ * request has waited batch_wait_us microseconds, so a prediction thread takes a batch off the queue, predicts and hands
+ * back its results at once instead of for every request. With a batch_size of 1 every request is a batch of its own.
+ *
+ * Every prediction thread has its own vw instance, set up from the options of the served one and sharing its weights.
+ * The weights are shared without synchronization, so the server only predicts and requires -t. Only the text format
+ * is supported. Linux only.
+ */
+class daemon_server
+{
+ public:
+  // listen_socket must be bound and listening already.
+  daemon_server(vw& all, int listen_socket, size_t num_threads, size_t batch_size = 1, size_t batch_wait_us = 0);
+  ~daemon_server();
+
+  daemon_server(const daemon_server&) = delete;
+  daemon_server& operator=(const daemon_server&) = delete;
+
+  // Serves connections until stop() is called.
+  void run();
+  // Makes run() return once the requests in flight are done. Async signal safe.
+  void stop();
+
+ private:
+  struct connection;
+  struct request;
+  struct batch;
+  struct worker;
+
+  void accept_connections();
+  void read_input(connection& conn);
+  void dispatch(connection& conn);
+  void submit_batch();
+  void set_timer(std::chrono::steady_clock::duration delay);
+  void write_output(connection& conn);
+  void complete_batches();
+  void complete_request(request& req);
+  void update_events(connection& conn);
+  void close_connection(connection& conn);
+  void worker_loop(worker& state);
+  void process(worker& state, request& req);
+
+  vw& _all;
+  const int _listen_socket;
+  int _epoll = -1;
+  // Written by stop() and by workers when requests complete.
+  int _wake = -1;
+  // Expires when the pending batch is due.
+  int _timer = -1;
+  bool _accepting = true;
+  bool _multiline;
+  const size_t _batch_size;
+  const std::chrono::microseconds _batch_wait;
+  volatile bool _stopping = false;
+
+  std::unordered_map<int, std::unique_ptr<connection>> _connections;
+  std::vector<std::unique_ptr<worker>> _workers;
+  std::vector<std::thread> _threads;
+  // Requests not yet submitted to the prediction threads.
+  std::unique_ptr<batch> _pending;
+  lock_free_ptr_queue<batch> _batches;
+
+  std::mutex _completed_lock;
+  std::vector<batch*> _completed;
+  size_t _in_flight = 0;
+};
+}  // namespace VW
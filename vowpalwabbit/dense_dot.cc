@@ -0,0 +1,213 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "dense_dot.h"
+#include "vw_exception.h"
+
+#if !defined(VW_NO_INLINE_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define VW_DENSE_DOT_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX2 and AVX-512 intrinsics in any function.
+#define VW_TARGET_AVX2
+#define VW_TARGET_AVX512
+#else
+#include <cpuid.h>
+#define VW_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define VW_TARGET_AVX512 __attribute__((target("avx2,fma,avx512f,avx512vl")))
+#endif
+#endif
+
+namespace
+{
+float dense_dot_scalar(const float* weights, uint64_t weight_mask, const features& fs, uint64_t offset)
+{
+  const float* values = fs.values.begin();
+  const feature_index* indices = fs.indicies.begin();
+  const size_t count = fs.size();
+  float sum = 0.f;
+  for (size_t i = 0; i < count; i++) sum += weights[(indices[i] + offset) & weight_mask] * values[i];
+  return sum;
+}
+
+#ifdef VW_DENSE_DOT_SIMD
+VW_TARGET_AVX2 inline float horizontal_sum(__m256 sum)
+{
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_movehdup_ps(half));
+  return _mm_cvtss_f32(half);
+}
+
+VW_TARGET_AVX2 float dense_dot_avx2(const float* weights, uint64_t weight_mask, const features& fs, uint64_t offset)
+{
+  const float* values = fs.values.begin();
+  const feature_index* indices = fs.indicies.begin();
+  const size_t count = fs.size();
+  const __m256i offsets = _mm256_set1_epi64x(static_cast<long long>(offset));
+  const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(weight_mask));
+  __m256 sum = _mm256_setzero_ps();
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    // Indices are 64 bits, so a gather fetches 4 weights.
+    const __m256i low = _mm256_and_si256(
+        _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i)), offsets), mask);
+    const __m256i high = _mm256_and_si256(
+        _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i + 4)), offsets), mask);
+    const __m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_i64gather_ps(weights, low, sizeof(float))),
+        _mm256_i64gather_ps(weights, high, sizeof(float)), 1);
+    sum = _mm256_fmadd_ps(w, _mm256_loadu_ps(values + i), sum);
+  }
+
+  float result = horizontal_sum(sum);
+  for (; i < count; i++) result += weights[(indices[i] + offset) & weight_mask] * values[i];
+  return result;
+}
+
+VW_TARGET_AVX512 float dense_dot_avx512(const float* weights, uint64_t weight_mask, const features& fs, uint64_t offset)
+{
+  const float* values = fs.values.begin();
+  const feature_index* indices = fs.indicies.begin();
+  const size_t count = fs.size();
+  const __m512i offsets = _mm512_set1_epi64(static_cast<long long>(offset));
+  const __m512i mask = _mm512_set1_epi64(static_cast<long long>(weight_mask));
+  // Two sums so that consecutive fused multiply adds do not wait for each other.
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    const __m512i idx0 = _mm512_and_si512(_mm512_add_epi64(_mm512_loadu_si512(indices + i), offsets), mask);
+    const __m512i idx1 = _mm512_and_si512(_mm512_add_epi64(_mm512_loadu_si512(indices + i + 8), offsets), mask);
+    sum0 = _mm256_fmadd_ps(_mm512_i64gather_ps(idx0, weights, sizeof(float)), _mm256_loadu_ps(values + i), sum0);
+    sum1 = _mm256_fmadd_ps(_mm512_i64gather_ps(idx1, weights, sizeof(float)), _mm256_loadu_ps(values + i + 8), sum1);
+  }
+  for (; i < count; i += 8)
+  {
+    // Lanes past the end are neither loaded nor gathered.
+    const size_t remaining = count - i;
+    const __mmask8 lanes = remaining >= 8 ? 0xff : static_cast<__mmask8>((1u << remaining) - 1);
+    const __m512i idx =
+        _mm512_and_si512(_mm512_add_epi64(_mm512_maskz_loadu_epi64(lanes, indices + i), offsets), mask);
+    const __m256 w = _mm512_mask_i64gather_ps(_mm256_setzero_ps(), lanes, idx, weights, sizeof(float));
+    sum0 = _mm256_fmadd_ps(w, _mm256_maskz_loadu_ps(lanes, values + i), sum0);
+  }
+  return horizontal_sum(_mm256_add_ps(sum0, sum1));
+}
+
+void cpuid(unsigned leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuidex(info, leaf, 0);
+  for (int r = 0; r < 4; r++) regs[r] = static_cast<unsigned>(info[r]);
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// The register state the operating system saves on context switches, without which the wide registers can't be used.
+uint64_t enabled_register_state()
+{
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned low, high;
+  __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+  return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+}
+
+bool avx2_supported(bool& avx512)
+{
+  avx512 = false;
+  unsigned regs[4];
+  cpuid(0, regs);
+  if (regs[0] < 7)
+    return false;
+
+  cpuid(1, regs);
+  const bool fma = (regs[2] & (1u << 12)) != 0;
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+  if (!fma || !osxsave)
+    return false;
+  const uint64_t state = enabled_register_state();
+  // SSE and AVX state, then the AVX-512 mask and upper register state.
+  if ((state & 0x6) != 0x6)
+    return false;
+
+  cpuid(7, regs);
+  if ((regs[1] & (1u << 5)) == 0)
+    return false;
+  avx512 = (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 31)) != 0 && (state & 0xe0) == 0xe0;
+  return true;
+}
+#endif
+
+VW::dense_dot_fn get_kernel(VW::dense_dot_kernel kernel)
+{
+  switch (kernel)
+  {
+    case VW::dense_dot_kernel::scalar:
+      return dense_dot_scalar;
+#ifdef VW_DENSE_DOT_SIMD
+    case VW::dense_dot_kernel::avx2:
+      return dense_dot_avx2;
+    case VW::dense_dot_kernel::avx512:
+      return dense_dot_avx512;
+#endif
+    default:
+      THROW("dense dot product kernel is not supported on this platform");
+  }
+}
+}  // namespace
+
+bool VW::dense_dot_kernel_supported(dense_dot_kernel kernel)
+{
+  switch (kernel)
+  {
+    case dense_dot_kernel::scalar:
+      return true;
+    case dense_dot_kernel::avx2:
+    case dense_dot_kernel::avx512:
+    {
+#ifdef VW_DENSE_DOT_SIMD
+      bool avx512;
+      const bool avx2 = avx2_supported(avx512);
+      return kernel == dense_dot_kernel::avx2 ? avx2 : avx512;
+#else
+      return false;
+#endif
+    }
+  }
+  return false;
+}
+
+VW::dense_dot_kernel VW::fastest_dense_dot_kernel()
+{
+#ifdef VW_DENSE_DOT_SIMD
+  bool avx512;
+  if (avx2_supported(avx512))
+    return avx512 ? dense_dot_kernel::avx512 : dense_dot_kernel::avx2;
+#endif
+  return dense_dot_kernel::scalar;
+}
+
+VW::dense_dot_kernel VW::preferred_dense_dot_kernel(size_t weight_bytes, bool huge_pages)
+{
+  if (weight_bytes > GATHER_WEIGHT_BYTES && !huge_pages)
+    return dense_dot_kernel::scalar;
+  return fastest_dense_dot_kernel();
+}
+
+VW::dense_dot_fn VW::get_dense_dot(dense_dot_kernel kernel)
+{
+  if (!dense_dot_kernel_supported(kernel))
+    THROW("dense dot product kernel is not supported on this CPU");
+  return get_kernel(kernel);
+}
@@ -0,0 +1,34 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+#pragma once
+
+#include "feature_group.h"
+
+namespace VW
+{
+// Ways to compute the dot product of one namespace with dense weights, which is most of the work of a linear
+// prediction. The vector kernels gather the weights of several features at once, so they add up the products in a
+// different order than the scalar one and the result may differ in the last bits, which is why gd only uses them with
+// --vector_dot.
+enum class dense_dot_kernel
+{
+  scalar,  // one feature at a time
+  avx2,    // 8 features at a time with gathers and fused multiply adds, on x86-64 CPUs with AVX2 and FMA
+  avx512   // 16 features at a time, the remainder with masked gathers, on x86-64 CPUs with AVX-512F and AVX-512VL
+};
+bool dense_dot_kernel_supported(dense_dot_kernel kernel);
+dense_dot_kernel fastest_dense_dot_kernel();
+
+// Weights up to this size stay mostly in cache and in reach of the TLB.
+constexpr size_t GATHER_WEIGHT_BYTES = size_t(1) << 23;
+// Picks the kernel for dense weights of weight_bytes. A gather waits for the page walks of all its lanes, which scalar
+// loads overlap, so for larger weights in regular pages the scalar kernel is faster even where gathers are supported.
+dense_dot_kernel preferred_dense_dot_kernel(size_t weight_bytes, bool huge_pages);
+
+// Returns the sum of value * weights[(index + offset) & weight_mask] over the features of fs, where weights and
+// weight_mask are those of dense_parameters.
+using dense_dot_fn = float (*)(const float* weights, uint64_t weight_mask, const features& fs, uint64_t offset);
+// Throws if the kernel is not supported.
+dense_dot_fn get_dense_dot(dense_dot_kernel kernel);
+}  // namespace VW
@@ -65,6 +65,8 @@ class features_value_iterator
 
   inline features_value_iterator operator+(std::ptrdiff_t index) { return features_value_iterator(_begin + index); }
 
+  inline std::ptrdiff_t operator-(const features_value_iterator& rhs) const { return _begin - rhs._begin; }
+
   inline features_value_iterator& operator+=(std::ptrdiff_t index)
   {
     _begin += index;
@@ -4,6 +4,8 @@
 #include "crossplat_compat.h"
 
 #include <cfloat>
+#include <thread>
+#include <vector>
 
 #if !defined(VW_NO_INLINE_SIMD)
 #if !defined(__SSE2__) && (defined(_M_AMD64) || defined(_M_X64))
@@ -18,6 +20,7 @@
 #endif
 
 #include "gd.h"
+#include "dense_dot.h"
 #include "accumulate.h"
 #include "reductions.h"
 #include "vw.h"
@@ -48,9 +51,15 @@ struct gd
   void (*update)(gd&, base_learner&, example&);
   float (*sensitivity)(gd&, base_learner&, example&);
   void (*multipredict)(gd&, base_learner&, example&, size_t, size_t, polyprediction*, bool);
+  // Compute the linear terms with dense weights through dense_dot, see --vector_dot.
+  bool vector_dot;
+  // Linear terms with dense weights, picked at setup.
+  VW::dense_dot_fn dense_dot;
   bool adaptive_input;
   bool normalized_input;
   bool adax;
+  // Save the weights as a dense image, see save_load_dense_image.
+  bool dense_image;
 
   vw* all;  // parallel, features, parameters
 };
@@ -372,12 +381,27 @@ inline void vec_add_print(float& p, const float fx, float& fw)
   std::cerr << " + " << fw << "*" << fx;
 }
 
+inline float dense_predict(gd& g, vw& all, example& ec)
+{
+  dense_parameters& weights = all.weights.dense_weights;
+  const VW::dense_dot_fn dot = g.dense_dot;
+  float prediction = ec.l.simple.initial;
+  for (example_predict::iterator i = ec.begin(); i != ec.end(); ++i)
+    if (!all.ignore_some_linear || !all.ignore_linear[i.index()])
+      prediction += dot(weights.first(), weights.mask(), *i, ec.ft_offset);
+  generate_interactions<float, const float&, vec_add, dense_parameters>(
+      *ec.interactions, all.permutations, ec, prediction, weights);
+  return prediction;
+}
+
 template <bool l1, bool audit>
 void predict(gd& g, base_learner&, example& ec)
 {
   vw& all = *g.all;
   if (l1)
     ec.partial_prediction = trunc_predict(all, ec, all.sd->gravity);
+  else if (!audit && g.vector_dot && !all.weights.sparse)
+    ec.partial_prediction = dense_predict(g, all, ec);
   else
     ec.partial_prediction = inline_predict(all, ec);
 
@@ -705,7 +729,8 @@ size_t write_index(io_buf& model_file, std::stringstream& msg, bool text, uint32
   size_t brw;
   uint32_t old_i = 0;
 
-  msg << i;
+  if (text)
+    msg << i;
 
   if (num_bits < 31)
   {
@@ -718,6 +743,68 @@ size_t write_index(io_buf& model_file, std::stringstream& msg, bool text, uint32
   return brw;
 }
 
+// Binary models hold an (index, value) record for every weight that is not zero.
+template <class I>
+void encode_weights(const dense_parameters& weights, uint64_t begin, uint64_t end, std::vector<char>& records)
+{
+  records.clear();
+  for (uint64_t i = begin; i < end; i++)
+  {
+    const weight value = weights[i << weights.stride_shift()];
+    if (value != 0.f)
+    {
+      const I index = static_cast<I>(i);
+      records.insert(records.end(), (const char*)&index, (const char*)&index + sizeof(index));
+      records.insert(records.end(), (const char*)&value, (const char*)&value + sizeof(value));
+    }
+  }
+}
+
+constexpr uint64_t ENCODE_CHUNK = 1 << 20;
+
+// Dense weights are encoded by several threads, each a range of its own, and written in order in large blocks.
+void write_regressor(vw& all, io_buf& model_file, const dense_parameters& weights)
+{
+  const uint64_t length = all.length();
+  void (*encode)(const dense_parameters&, uint64_t, uint64_t, std::vector<char>&) = encode_weights<uint64_t>;
+  if (all.num_bits < 31)  // backwards compatible
+    encode = encode_weights<uint32_t>;
+  const size_t num_threads =
+      all.in_background_save ? 1 : std::max(1u, std::min(std::thread::hardware_concurrency(), 16u));
+  std::vector<std::vector<char>> records(std::min<uint64_t>(num_threads, (length + ENCODE_CHUNK - 1) / ENCODE_CHUNK));
+
+  for (uint64_t begin = 0; begin < length; begin += records.size() * ENCODE_CHUNK)
+  {
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < records.size(); t++)
+    {
+      const uint64_t first = std::min(length, begin + t * ENCODE_CHUNK);
+      threads.emplace_back(
+          [&, t, first]() { encode(weights, first, std::min(length, first + ENCODE_CHUNK), records[t]); });
+    }
+    encode(weights, begin, std::min(length, begin + ENCODE_CHUNK), records[0]);
+    for (auto& thread : threads) thread.join();
+    for (const auto& block : records) model_file.bin_write_fixed(block.data(), block.size());
+  }
+}
+
+void write_regressor(vw& all, io_buf& model_file, sparse_parameters& weights)
+{
+  for (auto v = weights.begin(); v != weights.end(); ++v)
+    if (*v != 0.)
+    {
+      const uint64_t i = v.index() >> weights.stride_shift();
+      if (all.num_bits < 31)
+      {
+        const uint32_t old_i = static_cast<uint32_t>(i);
+        model_file.bin_write_fixed((const char*)&old_i, sizeof(old_i));
+      }
+      else
+        model_file.bin_write_fixed((const char*)&i, sizeof(i));
+      model_file.bin_write_fixed((const char*)&(*v), sizeof(*v));
+    }
+}
+
 template <class T>
 void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& weights)
 {
@@ -751,6 +838,9 @@ void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& w
   uint64_t i = 0;
   uint32_t old_i = 0;
   uint64_t length = (uint64_t)1 << all.num_bits;
+  // Published weights are mapped already, those of the model are skipped.
+  const bool shared = !all.weights.sparse && all.weights.dense_weights.shared();
+  weight skipped;
   if (read)
     do
     {
@@ -767,21 +857,24 @@ void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text, T& w
         if (i >= length)
           THROW("Model content is corrupted, weight vector index " << i << " must be less than total vector length "
                                                                    << length);
-        weight* v = &weights.strided_index(i);
+        weight* v = shared ? &skipped : &weights.strided_index(i);
         brw += model_file.bin_read_fixed((char*)&(*v), sizeof(*v), "");
       }
     } while (brw > 0);
-  else  // write
+  else if (!text)
+    write_regressor(all, model_file, weights);
+  else
+  {
+    std::stringstream msg;
     for (typename T::iterator v = weights.begin(); v != weights.end(); ++v)
       if (*v != 0.)
       {
         i = v.index() >> weights.stride_shift();
-        std::stringstream msg;
-
         brw = write_index(model_file, msg, text, all.num_bits, i);
         msg << ":" << *v << "\n";
         brw += bin_text_write_fixed(model_file, (char*)&(*v), sizeof(*v), msg, text);
       }
+  }
 }
 
 void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text)
@@ -801,6 +894,7 @@ void save_load_online_state(
   uint64_t i = 0;
   uint32_t old_i = 0;
   size_t brw = 1;
+  const bool shared = !all.weights.sparse && all.weights.dense_weights.shared();
 
   if (read)
     do
@@ -827,6 +921,8 @@ void save_load_online_state(
           brw += model_file.bin_read_fixed((char*)buff, sizeof(buff[0]) * 2, "");
         else  // adaptive and normalized
           brw += model_file.bin_read_fixed((char*)buff, sizeof(buff[0]) * 3, "");
+        if (shared)
+          continue;
         uint32_t stride = 1 << weights.stride_shift();
         weight* v = &weights.strided_index(i);
         for (size_t j = 0; j < stride; j++) v[j] = buff[j];
@@ -842,7 +938,8 @@ void save_load_online_state(
         if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
+          if (text)
+            msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), 3 * sizeof(*v), msg, text);
         }
       }
@@ -851,7 +948,8 @@ void save_load_online_state(
         if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0. || (&(*v))[3] != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << "\n";
+          if (text)
+            msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), 4 * sizeof(*v), msg, text);
         }
       }
@@ -861,8 +959,9 @@ void save_load_online_state(
             (&(*v))[5] != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << " " << (&(*v))[4] << " "
-              << (&(*v))[5] << "\n";
+          if (text)
+            msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << " " << (&(*v))[3] << " " << (&(*v))[4] << " "
+                << (&(*v))[5] << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), 6 * sizeof(*v), msg, text);
         }
       }
@@ -871,7 +970,8 @@ void save_load_online_state(
         if (*v != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << "\n";
+          if (text)
+            msg << ":" << *v << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), sizeof(*v), msg, text);
         }
       }
@@ -881,7 +981,8 @@ void save_load_online_state(
         if (*v != 0. || (&(*v))[1] != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << "\n";
+          if (text)
+            msg << ":" << *v << " " << (&(*v))[1] << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), 2 * sizeof(*v), msg, text);
         }
       }
@@ -891,19 +992,18 @@ void save_load_online_state(
         if (*v != 0. || (&(*v))[1] != 0. || (&(*v))[2] != 0.)
         {
           brw = write_index(model_file, msg, text, all.num_bits, i);
-          msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
+          if (text)
+            msg << ":" << *v << " " << (&(*v))[1] << " " << (&(*v))[2] << "\n";
           brw += bin_text_write_fixed(model_file, (char*)&(*v), 3 * sizeof(*v), msg, text);
         }
       }
     }
 }
 
-void save_load_online_state(
-    vw& all, io_buf& model_file, bool read, bool text, double& total_weight, gd* g, uint32_t ftrl_size)
+// The online state besides the weights.
+void save_load_online_counters(
+    vw& all, io_buf& model_file, bool read, bool text, double& total_weight, std::stringstream& msg)
 {
-  // vw& all = *g.all;
-  std::stringstream msg;
-
   msg << "initial_t " << all.initial_t << "\n";
   bin_text_read_write_fixed(model_file, (char*)&all.initial_t, sizeof(all.initial_t), "", read, msg, text);
 
@@ -992,20 +1092,137 @@ void save_load_online_state(
     all.sd->total_features = 0;
     all.current_pass = 0;
   }
+}
+
+void save_load_online_state(
+    vw& all, io_buf& model_file, bool read, bool text, double& total_weight, gd* g, uint32_t ftrl_size)
+{
+  // vw& all = *g.all;
+  std::stringstream msg;
+
+  save_load_online_counters(all, model_file, read, text, total_weight, msg);
   if (all.weights.sparse)
     save_load_online_state(all, model_file, read, text, g, msg, ftrl_size, all.weights.sparse_weights);
   else
     save_load_online_state(all, model_file, read, text, g, msg, ftrl_size, all.weights.dense_weights);
 }
 
+// The byte saying whether the online state was saved also says whether the weights follow as a dense image.
+constexpr uint8_t SAVED_RESUME = 1;
+constexpr uint8_t SAVED_DENSE_IMAGE = 2;
+// A multiple of every page size, so that the image can be mapped where it starts in the model file.
+constexpr size_t DENSE_IMAGE_ALIGNMENT = 1 << 16;
+constexpr size_t DENSE_IMAGE_CHUNK = 1 << 16;
+
+struct dense_image_header
+{
+  uint64_t length;
+  // The image holds 1 << stride_shift floats of each weight, all of them with the online state and the first
+  // otherwise.
+  uint32_t stride_shift;
+  uint32_t reserved;
+};
+
+// Writes the weights as one array, aligned within the file so that loading can map it copy-on-write. The image ends the
+// model, as the base learner saves last.
+void save_dense_image(vw& all, io_buf& model_file, bool resume)
+{
+  auto& weights = all.weights.dense_weights;
+  dense_image_header header{all.length(), resume ? weights.stride_shift() : 0, 0};
+  model_file.bin_write_fixed((char*)&header, sizeof(header));
+
+  const std::vector<char> padding(
+      (DENSE_IMAGE_ALIGNMENT - model_file.file_position() % DENSE_IMAGE_ALIGNMENT) % DENSE_IMAGE_ALIGNMENT, 0);
+  model_file.bin_write_fixed(padding.data(), padding.size());
+
+  if (header.stride_shift == weights.stride_shift())
+  {
+    const size_t size = (header.length << header.stride_shift) * sizeof(weight);
+    for (size_t written = 0; written < size; written += DENSE_IMAGE_CHUNK)
+      model_file.bin_write_fixed((char*)weights.first() + written, std::min(DENSE_IMAGE_CHUNK, size - written));
+    return;
+  }
+
+  std::vector<weight> chunk;
+  for (uint64_t i = 0; i < header.length;)
+  {
+    chunk.clear();
+    for (; i < header.length && chunk.size() < DENSE_IMAGE_CHUNK / sizeof(weight); i++)
+      chunk.push_back(weights.strided_index(i));
+    model_file.bin_write_fixed((char*)chunk.data(), chunk.size() * sizeof(weight));
+  }
+}
+
+// Maps the image if it holds weights of the same stride and the model comes from a file. Otherwise it is read, as much
+// of each weight as both strides have.
+template <class T>
+void load_dense_image(vw& all, io_buf& model_file, T& weights)
+{
+  dense_image_header header;
+  if (model_file.bin_read_fixed((char*)&header, sizeof(header), "") != sizeof(header) || header.length != all.length())
+    THROW("Model content is corrupted, the weight image does not hold " << all.length() << " weights");
+
+  std::vector<char> padding(
+      (DENSE_IMAGE_ALIGNMENT - model_file.file_position() % DENSE_IMAGE_ALIGNMENT) % DENSE_IMAGE_ALIGNMENT);
+  model_file.bin_read_fixed(padding.data(), padding.size(), "");
+
+  // Published weights are mapped already, those of the model are not needed.
+  if (!all.weights.sparse && all.weights.dense_weights.shared())
+    return;
+
+  const size_t size = (header.length << header.stride_shift) * sizeof(weight);
+  if (!all.weights.sparse && header.stride_shift == weights.stride_shift())
+  {
+    void* data = model_file.map_private(size);
+    if (data != nullptr)
+    {
+      all.weights.dense_weights.adopt_mapping(static_cast<weight*>(data), size);
+      return;
+    }
+  }
+
+  const size_t saved_stride = size_t(1) << header.stride_shift;
+  const size_t stride = std::min(saved_stride, static_cast<size_t>(weights.stride()));
+  std::vector<weight> chunk(DENSE_IMAGE_CHUNK / sizeof(weight) / saved_stride * saved_stride);
+  for (uint64_t i = 0; i < header.length;)
+  {
+    const size_t count = std::min(chunk.size() / saved_stride, static_cast<size_t>(header.length - i));
+    if (model_file.bin_read_fixed((char*)chunk.data(), count * saved_stride * sizeof(weight), "") !=
+        count * saved_stride * sizeof(weight))
+      THROW("Model content is corrupted, the weight image is truncated");
+    for (size_t j = 0; j < count; j++, i++)
+    {
+      const weight* saved = chunk.data() + j * saved_stride;
+      // Sparse weights only hold the weights that are not zero.
+      if (all.weights.sparse && std::all_of(saved, saved + stride, [](weight w) { return w == 0.f; }))
+        continue;
+      weight* w = &weights.strided_index(i);
+      std::copy(saved, saved + stride, w);
+    }
+  }
+}
+
+void save_load_dense_image(vw& all, io_buf& model_file, bool read, bool resume)
+{
+  if (!read)
+    save_dense_image(all, model_file, resume);
+  else if (all.weights.sparse)
+    load_dense_image(all, model_file, all.weights.sparse_weights);
+  else
+    load_dense_image(all, model_file, all.weights.dense_weights);
+}
+
 void save_load(gd& g, io_buf& model_file, bool read, bool text)
 {
   vw& all = *g.all;
+  // Published weights are ready to use as they are.
+  bool shared = false;
   if (read)
   {
     initialize_regressor(all);
+    shared = !all.weights.sparse && all.weights.dense_weights.shared();
 
-    if (all.weights.adaptive && all.initial_t > 0)
+    if (!shared && all.weights.adaptive && all.initial_t > 0)
     {
       float init_weight = all.initial_weight;
       float init_t = all.initial_t;
@@ -1023,17 +1240,27 @@ void save_load(gd& g, io_buf& model_file, bool read, bool text)
       // stored in memory at each update, and always start sum of gradients to 0, at the price of additional additions
       // and multiplications during the update...
     }
-    if (g.initial_constant != 0.0)
+    if (!shared && g.initial_constant != 0.0)
       VW::set_weight(all, constant, 0, g.initial_constant);
   }
 
   if (model_file.num_files() > 0)
   {
     bool resume = all.save_resume;
+    uint8_t saved = resume ? SAVED_RESUME : 0;
+    if (!read && g.dense_image && !text && !all.print_invert)
+      saved |= SAVED_DENSE_IMAGE;
     std::stringstream msg;
     msg << ":" << resume << "\n";
-    bin_text_read_write_fixed(model_file, (char*)&resume, sizeof(resume), "", read, msg, text);
-    if (resume)
+    bin_text_read_write_fixed(model_file, (char*)&saved, sizeof(saved), "", read, msg, text);
+    resume = (saved & SAVED_RESUME) != 0;
+    if (saved & SAVED_DENSE_IMAGE)
+    {
+      if (resume)
+        save_load_online_counters(all, model_file, read, text, g.total_weight, msg);
+      save_load_dense_image(all, model_file, read, resume);
+    }
+    else if (resume)
     {
       if (read && all.model_file_ver < VERSION_SAVE_RESUME_FIX)
         all.trace_message
@@ -1046,8 +1273,13 @@ void save_load(gd& g, io_buf& model_file, bool read, bool text)
     else
       save_load_regressor(all, model_file, read, text);
   }
-  if (!all.training)  // If the regressor was saved as --save_resume, then when testing we want to materialize the
-                      // weights.
+  if (shared)  // Regularization was applied before the weights were published.
+  {
+    all.sd->gravity = 0.;
+    all.sd->contraction = 1.;
+  }
+  else if (!all.training)  // If the regressor was saved as --save_resume, then when testing we want to materialize the
+                           // weights.
     sync_weights(all);
 }
 
@@ -1152,9 +1384,19 @@ base_learner* setup(options_i& options, vw& all)
       .add(make_option("l2_state", all.sd->contraction)
                .keep(all.save_resume)
                .default_value(1.)
-               .help("use per feature normalized updates"));
+               .help("use per feature normalized updates"))
+      .add(make_option("dense_image", g->dense_image)
+               .keep()
+               .help("save models with the weights as a dense image, which loads by mapping the model file rather "
+                     "than reading it"))
+      .add(make_option("vector_dot", g->vector_dot)
+               .help("compute linear predictions with dense weights using gathers where the CPU supports them. This "
+                     "adds up in a different order, so predictions may differ in the last bits and between CPUs"));
   options.add_and_parse(new_options);
 
+  if (g->dense_image && all.weights.sparse)
+    THROW("--dense_image requires dense weights, it cannot be used with --sparse_weights");
+
   g->all = &all;
   g->all->normalized_sum_norm_x = 0;
   g->no_win_counter = 0;
@@ -1256,6 +1498,15 @@ base_learner* setup(options_i& options, vw& all)
 
   all.weights.stride_shift((uint32_t)ceil_log_2(stride - 1));
 
+  if (g->vector_dot && !all.weights.sparse)
+  {
+    // The weights are allocated after setup, including for instances seeded from another one, but their size is
+    // already known from the bits and the stride.
+    const size_t weight_bytes = (((size_t)1 << all.num_bits) << all.weights.stride_shift()) * sizeof(weight);
+    const bool huge_pages = all.weights.memory_options.huge_pages != VW::huge_page_mode::off;
+    g->dense_dot = VW::get_dense_dot(VW::preferred_dense_dot_kernel(weight_bytes, huge_pages));
+  }
+
   gd* bare = g.get();
   learner<gd, example>& ret = init_learner(g, g->learn, bare->predict, ((uint64_t)1 << all.weights.stride_shift()));
   ret.set_sensitivity(bare->sensitivity);
@@ -17,6 +17,8 @@ VW::LEARNER::base_learner* setup(VW::config::options_i& options, vw& all);
 struct gd;
 
 float finalize_prediction(shared_data* sd, vw_logger& logger, float ret);
+// Applies pending l1 and l2 regularization to the weights.
+void sync_weights(vw& all);
 void print_audit_features(vw&, example& ec);
 void save_load_regressor(vw& all, io_buf& model_file, bool read, bool text);
 void save_load_online_state(vw& all, io_buf& model_file, bool read, bool text, double& total_weight,
@@ -15,6 +15,7 @@
 #include "vw_exception.h"
 #include "future_compat.h"
 #include "vw_allreduce.h"
+#include "accumulate.h"
 #include "named_labels.h"
 
 struct global_prediction
@@ -150,6 +151,40 @@ void print_raw_text_by_ref(VW::io::writer* f, const std::string& s, const v_arra
 }
 
 
+void shared_data::copy_from(const shared_data& other)
+{
+  queries = other.queries;
+  example_number = other.example_number;
+  total_features = other.total_features;
+  t = other.t;
+  weighted_labeled_examples = other.weighted_labeled_examples;
+  old_weighted_labeled_examples = other.old_weighted_labeled_examples;
+  weighted_unlabeled_examples = other.weighted_unlabeled_examples;
+  weighted_labels = other.weighted_labels;
+  sum_loss = other.sum_loss;
+  sum_loss_since_last_dump = other.sum_loss_since_last_dump;
+  dump_interval = other.dump_interval;
+  gravity = other.gravity;
+  contraction = other.contraction;
+  min_label = other.min_label;
+  max_label = other.max_label;
+  ldict = other.ldict;
+  weighted_holdout_examples = other.weighted_holdout_examples;
+  weighted_holdout_examples_since_last_dump = other.weighted_holdout_examples_since_last_dump;
+  holdout_sum_loss_since_last_dump = other.holdout_sum_loss_since_last_dump;
+  holdout_sum_loss = other.holdout_sum_loss;
+  holdout_best_loss = other.holdout_best_loss;
+  weighted_holdout_examples_since_last_pass = other.weighted_holdout_examples_since_last_pass;
+  holdout_sum_loss_since_last_pass = other.holdout_sum_loss_since_last_pass;
+  holdout_best_pass = other.holdout_best_pass;
+  report_multiclass_log_loss = other.report_multiclass_log_loss;
+  multiclass_log_loss = other.multiclass_log_loss;
+  holdout_multiclass_log_loss = other.holdout_multiclass_log_loss;
+  is_more_than_two_labels_observed.store(other.is_more_than_two_labels_observed.load());
+  first_observed_label.store(other.first_observed_label.load());
+  second_observed_label.store(other.second_observed_label.load());
+}
+
 void set_mm(shared_data* sd, float label)
 {
   sd->min_label = std::min(sd->min_label, label);
@@ -344,6 +379,7 @@ vw::vw()
   initial_constant = 0.0;
 
   all_reduce = nullptr;
+  weight_sync = nullptr;
 
   for (size_t i = 0; i < NUM_NAMESPACES; i++)
   {
@@ -362,6 +398,9 @@ vw::vw()
   passes_complete = 0;
 
   save_per_pass = false;
+  save_in_background = false;
+  background_save_pid = 0;
+  in_background_save = false;
 
   stdin_off = false;
   do_reset_source = false;
@@ -421,4 +460,5 @@ vw::~vw()
 
   delete loss;
   delete all_reduce;
+  delete weight_sync;
 }
@@ -121,6 +121,9 @@ struct shared_data
 
   double weighted_examples() { return weighted_labeled_examples + weighted_unlabeled_examples; }
 
+  // Copies the statistics of other and shares its label dictionary. Some members are atomic, so memcpy must not be used.
+  void copy_from(const shared_data& other);
+
   void update(bool test_example, bool labeled_example, float loss, float weight, size_t num_features)
   {
     t += weight;
@@ -271,6 +274,11 @@ enum AllReduceType
 
 class AllReduce;
 
+namespace VW
+{
+struct weight_sync;
+}
+
 enum class label_type_t
 {
   simple,
@@ -323,6 +331,7 @@ struct vw
 
   AllReduceType all_reduce_type;
   AllReduce* all_reduce;
+  VW::weight_sync* weight_sync;  // see accumulate.h
 
   bool chain_hash = false;
 
@@ -352,6 +361,9 @@ struct vw
   size_t num_children;
 
   bool save_per_pass;
+  bool save_in_background;
+  int background_save_pid;  // the process writing a model for --save_in_background, 0 if there is none
+  bool in_background_save;  // true in that process, which must write the model on a single thread
   float initial_weight;
   float initial_constant;
 
@@ -0,0 +1,117 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "hash_cache.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+constexpr size_t MAX_SHARDS = 64;
+constexpr uint8_t EMPTY = 0xFF;
+
+size_t round_up_to_power_of_two(size_t n)
+{
+  size_t result = 1;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+uint64_t load_bytes(const char* p, size_t len)
+{
+  uint64_t v = 0;
+  memcpy(&v, p, len < sizeof(v) ? len : sizeof(v));
+  return v;
+}
+
+// Only has to spread tokens over the slots, the entry compares the whole token.
+uint64_t slot_hash(const char* token, size_t len, uint64_t seed)
+{
+  uint64_t h = seed ^ (static_cast<uint64_t>(len) * 0x9E3779B97F4A7C15ULL);
+  h ^= load_bytes(token, len);
+  if (len > sizeof(uint64_t))
+    h = (h * 0xFF51AFD7ED558CCDULL) ^ load_bytes(token + len - sizeof(uint64_t), sizeof(uint64_t));
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  return h ^ (h >> 29);
+}
+}  // namespace
+
+namespace VW
+{
+struct hash_cache::entry
+{
+  uint64_t seed;
+  uint64_t hash;
+  uint8_t len = EMPTY;
+  char token[MAX_TOKEN_LENGTH];
+};
+
+struct hash_cache::shard
+{
+  std::mutex lock;
+  std::unique_ptr<entry[]> entries;
+  // Only written while holding the lock, atomic so that stats() can read them at any time.
+  std::atomic<uint64_t> hits{0};
+  std::atomic<uint64_t> misses{0};
+  std::atomic<uint64_t> bypasses{0};
+};
+
+hash_cache::hash_cache(size_t entries, hash_func_t hasher) : _hasher(hasher)
+{
+  const size_t total = round_up_to_power_of_two(entries == 0 ? 1 : entries);
+  _num_shards = total < MAX_SHARDS ? total : MAX_SHARDS;
+  _entries_per_shard = total / _num_shards;
+  _shards.reset(new shard[_num_shards]);
+  for (size_t i = 0; i < _num_shards; i++) _shards[i].entries.reset(new entry[_entries_per_shard]);
+}
+
+hash_cache::~hash_cache() = default;
+
+uint64_t hash_cache::hash(const char* token, size_t len, uint64_t seed)
+{
+  const uint64_t h = slot_hash(token, len, seed);
+  // The low bits pick the shard, the ones above them the entry.
+  auto& s = _shards[h & (_num_shards - 1)];
+  if (len > MAX_TOKEN_LENGTH)
+  {
+    s.bypasses.fetch_add(1, std::memory_order_relaxed);
+    return _hasher(token, len, seed);
+  }
+
+  std::unique_lock<std::mutex> guard(s.lock, std::try_to_lock);
+  if (!guard.owns_lock())
+  {
+    s.bypasses.fetch_add(1, std::memory_order_relaxed);
+    return _hasher(token, len, seed);
+  }
+
+  auto& e = s.entries[(h / _num_shards) & (_entries_per_shard - 1)];
+  if (e.len == len && e.seed == seed && memcmp(e.token, token, len) == 0)
+  {
+    s.hits.store(s.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return e.hash;
+  }
+
+  s.misses.store(s.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  e.seed = seed;
+  e.hash = _hasher(token, len, seed);
+  e.len = static_cast<uint8_t>(len);
+  memcpy(e.token, token, len);
+  return e.hash;
+}
+
+hash_cache::statistics hash_cache::stats() const
+{
+  statistics result;
+  for (size_t i = 0; i < _num_shards; i++)
+  {
+    result.hits += _shards[i].hits.load(std::memory_order_relaxed);
+    result.misses += _shards[i].misses.load(std::memory_order_relaxed);
+    result.bypasses += _shards[i].bypasses.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+}  // namespace VW
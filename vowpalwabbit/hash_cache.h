@@ -0,0 +1,59 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include "parse_primitives.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace VW
+{
+// Remembers the hashes of recently seen feature and namespace names, so that tokens which occur over and over skip the
+// hash function, and for the default hasher its scan for numeric names. Lookups are keyed on the seed, which is the
+// namespace hash for feature names, and the exact token bytes, so the cache always returns what the hasher would.
+//
+// The entries are split into shards, each guarded by its own lock, so that parse threads can share one cache. A lookup
+// that finds its shard locked by another thread hashes the token directly rather than waiting.
+class hash_cache
+{
+ public:
+  // Longer tokens are rarely repeated and bypass the cache.
+  static constexpr size_t MAX_TOKEN_LENGTH = 46;
+
+  struct statistics
+  {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Lookups of long tokens or which found their shard busy.
+    uint64_t bypasses = 0;
+
+    uint64_t lookups() const { return hits + misses + bypasses; }
+  };
+
+  // entries is rounded up to a power of two.
+  hash_cache(size_t entries, hash_func_t hasher);
+  ~hash_cache();
+
+  hash_cache(const hash_cache&) = delete;
+  hash_cache& operator=(const hash_cache&) = delete;
+
+  uint64_t hash(const char* token, size_t len, uint64_t seed);
+
+  size_t capacity() const { return _num_shards * _entries_per_shard; }
+  // Sums the counters of all shards. Counts being updated concurrently may or may not be included.
+  statistics stats() const;
+
+ private:
+  struct entry;
+  struct shard;
+
+  hash_func_t _hasher;
+  size_t _num_shards;
+  size_t _entries_per_shard;
+  std::unique_ptr<shard[]> _shards;
+};
+}  // namespace VW
@@ -4,9 +4,11 @@
 #define NOMINMAX
 #define ssize_t int64_t
 #include <winsock2.h>
+#include <windows.h>
 #include <io.h>
 #else
 #include <sys/socket.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -72,12 +74,34 @@ struct file_adapter : public writer, public reader
   ssize_t read(char* buffer, size_t num_bytes) override;
   ssize_t write(const char* buffer, size_t num_bytes) override;
   void reset() override;
+  void* map_private(uint64_t offset, size_t len) override;
 
 private:
   int _file_descriptor;
   file_mode _mode;
 };
 
+// Read only view of a whole file mapped into memory.
+struct mmap_file_adapter : public reader
+{
+  // Returns nullptr if the file cannot be opened or mapped.
+  static mmap_file_adapter* open(const char* filename);
+  ~mmap_file_adapter();
+  ssize_t read(char* buffer, size_t num_bytes) override;
+  bool take_remaining(const char*& data, size_t& len) override;
+  void reset() override;
+
+private:
+  mmap_file_adapter(const char* data, size_t len)
+      : reader(true /*is_resettable*/), _data(data), _read_head(data), _len(len)
+  {
+  }
+
+  const char* _data;
+  const char* _read_head;
+  size_t _len;
+};
+
 struct gzip_file_adapter : public writer, public reader
 {
   gzip_file_adapter(const char* filename, file_mode mode);
@@ -120,6 +144,7 @@ struct buffer_view : public reader
   buffer_view(const char* data, size_t len);
   ~buffer_view() = default;
   ssize_t read(char* buffer, size_t num_bytes) override;
+  bool take_remaining(const char*& data, size_t& len) override;
   void reset() override;
 
 private:
@@ -142,6 +167,14 @@ std::unique_ptr<reader> open_file_reader(const std::string& file_path)
   return std::unique_ptr<reader>(new file_adapter(file_path.c_str(), file_mode::read));
 }
 
+std::unique_ptr<reader> open_mmap_file_reader(const std::string& file_path)
+{
+  auto* mapped = mmap_file_adapter::open(file_path.c_str());
+  if (mapped != nullptr)
+    return std::unique_ptr<reader>(mapped);
+  return open_file_reader(file_path);
+}
+
 std::unique_ptr<writer> open_compressed_file_writer(const std::string& file_path)
 {
   return std::unique_ptr<writer>(new gzip_file_adapter(file_path.c_str(), file_mode::write));
@@ -302,6 +335,25 @@ void file_adapter::reset()
 #endif
 }
 
+void* file_adapter::map_private(uint64_t offset, size_t len)
+{
+#ifdef _WIN32
+  return nullptr;
+#else
+  if (_mode != file_mode::read || len == 0)
+    return nullptr;
+  void* data = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, _file_descriptor, offset);
+  if (data == MAP_FAILED)
+    return nullptr;
+  if (::lseek(_file_descriptor, offset + len, SEEK_SET) == -1)
+  {
+    munmap(data, len);
+    return nullptr;
+  }
+  return data;
+#endif
+}
+
 file_adapter::~file_adapter()
 {
 #ifdef _WIN32
@@ -311,6 +363,81 @@ file_adapter::~file_adapter()
 #endif
 }
 
+//
+// mmap_file_adapter
+//
+
+mmap_file_adapter* mmap_file_adapter::open(const char* filename)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return nullptr;
+
+  LARGE_INTEGER file_size;
+  const char* data = nullptr;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+  {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+    {
+      data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      // The view keeps the mapping alive.
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+  if (data == nullptr)
+    return nullptr;
+  return new mmap_file_adapter(data, static_cast<size_t>(file_size.QuadPart));
+#else
+  int fd = ::open(filename, O_RDONLY | O_LARGEFILE);
+  if (fd == -1)
+    return nullptr;
+
+  struct stat file_stat;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0)
+    data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive.
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  // Let the kernel read ahead aggressively, the file is consumed front to back on every pass.
+  madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+  return new mmap_file_adapter(static_cast<const char*>(data), static_cast<size_t>(file_stat.st_size));
+#endif
+}
+
+mmap_file_adapter::~mmap_file_adapter()
+{
+#ifdef _WIN32
+  UnmapViewOfFile(const_cast<char*>(_data));
+#else
+  munmap(const_cast<char*>(_data), _len);
+#endif
+}
+
+ssize_t mmap_file_adapter::read(char* buffer, size_t num_bytes)
+{
+  num_bytes = std::min(static_cast<size_t>((_data + _len) - _read_head), num_bytes);
+  std::memcpy(buffer, _read_head, num_bytes);
+  _read_head += num_bytes;
+  return num_bytes;
+}
+
+bool mmap_file_adapter::take_remaining(const char*& data, size_t& len)
+{
+  data = _read_head;
+  len = (_data + _len) - _read_head;
+  _read_head = _data + _len;
+  return true;
+}
+
+void mmap_file_adapter::reset() { _read_head = _data; }
+
 //
 // gzip_file_adapter
 //
@@ -411,4 +538,12 @@ ssize_t buffer_view::read(char* buffer, size_t num_bytes)
 
   return num_bytes;
 }
+bool buffer_view::take_remaining(const char*& data, size_t& len)
+{
+  data = _read_head;
+  len = (_data + _len) - _read_head;
+  _read_head = _data + _len;
+  return true;
+}
+
 void buffer_view::reset() { _read_head = _data; }
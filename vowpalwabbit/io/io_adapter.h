@@ -48,6 +48,22 @@ struct reader
   /// \returns true if this reader can be reset, otherwise false
   bool is_resettable() const { return _is_resettable; }
 
+  /// Readers whose contents are already in memory can hand out everything that has not been read yet in one go, which
+  /// lets io_buf decode directly from that memory instead of copying it into its own buffer. The handed out bytes count
+  /// as read. They remain valid until the reader is destroyed and must not be modified.
+  /// \param data set to the first unread byte
+  /// \param len set to the number of unread bytes, 0 once everything has been read
+  /// \returns false if this reader does not support it, in which case data and len are left untouched
+  virtual bool take_remaining(const char*& /* data */, size_t& /* len */) { return false; }
+
+  /// Readers of regular files can map part of the file into memory instead of reading it. The mapping is private and
+  /// writable, pages are copied when first written to. It outlives the reader and is released with munmap(). Reading
+  /// continues after the mapped bytes.
+  /// \param offset where the bytes start in the file, a multiple of the page size
+  /// \param len the number of bytes
+  /// \returns nullptr if this reader does not support it or the bytes cannot be mapped
+  virtual void* map_private(uint64_t /* offset */, size_t /* len */) { return nullptr; }
+
   reader(reader& other) = delete;
   reader& operator=(reader& other) = delete;
   reader(reader&& other) = delete;
@@ -91,6 +107,9 @@ private:
 
 std::unique_ptr<writer> open_file_writer(const std::string& file_path);
 std::unique_ptr<reader> open_file_reader(const std::string& file_path);
+/// Maps the file into memory for sequential reading and supports take_remaining(). Falls back to the reader returned
+/// by open_file_reader() if the file cannot be mapped.
+std::unique_ptr<reader> open_mmap_file_reader(const std::string& file_path);
 std::unique_ptr<writer> open_compressed_file_writer(const std::string& file_path);
 std::unique_ptr<reader> open_compressed_file_reader(const std::string& file_path);
 std::unique_ptr<reader> open_compressed_stdin();
@@ -14,6 +14,8 @@ size_t io_buf::buf_read(char*& pointer, size_t n)
   }
   else  // out of bytes, so refill.
   {
+    if (_viewing)
+      end_view();
     if (head != space.begin())  // There exists room to shift.
     {
       // Out of buffer so swap to beginning.
@@ -25,7 +27,10 @@ size_t io_buf::buf_read(char*& pointer, size_t n)
     if (current < input_files.size() && fill(input_files[current].get()) > 0)  // read more bytes from current file if present
       return buf_read(pointer, n);  // more bytes are read.
     else if (++current < input_files.size())
+    {
+      _file_bytes = 0;
       return buf_read(pointer, n);  // No more bytes, so go to next file and try again.
+    }
     else
     {
       // no more bytes to read, return all that we have left.
@@ -63,6 +68,11 @@ size_t io_buf::readto(char*& pointer, char terminal)
   }
   else
   {
+    if (_viewing)
+    {
+      end_view();
+      pointer = space.end();
+    }
     if (space.end() == space.end_array)
     {
       size_t left = space.end() - head;
@@ -74,7 +84,10 @@ size_t io_buf::readto(char*& pointer, char terminal)
     if (current < input_files.size() && fill(input_files[current].get()) > 0)  // more bytes are read.
       return readto(pointer, terminal);
     else if (++current < input_files.size())  // no more bytes, so go to next file.
+    {
+      _file_bytes = 0;
       return readto(pointer, terminal);
+    }
     else  // no more bytes to read, return everything we have.
     {
       size_t n = pointer - head;
@@ -85,6 +98,31 @@ size_t io_buf::readto(char*& pointer, char terminal)
   }
 }
 
+void io_buf::begin_view(const char* data, size_t len)
+{
+  assert(!_viewing && head == space.end());
+  _parked_space = space;
+  // The memory is only ever read through the view.
+  space.begin() = const_cast<char*>(data);
+  space.end() = space.end_array = space.begin() + len;
+  head = space.begin();
+  _viewing = true;
+}
+
+void io_buf::end_view()
+{
+  // Bytes of the view that have not been read yet move to the owned buffer.
+  const size_t left = space.end() - head;
+  const char* unread = head;
+  space = _parked_space;
+  _viewing = false;
+  if (left > static_cast<size_t>(space.end_array - space.begin()))
+    space.resize(left);
+  memcpy(space.begin(), unread, left);
+  space.end() = space.begin() + left;
+  head = space.begin();
+}
+
 void io_buf::buf_write(char*& pointer, size_t n)
 {
   // return a pointer to the next n bytes to write into.
@@ -116,9 +154,30 @@ size_t io_buf::copy_to(void *dst, size_t max_size)
 
 void io_buf::replace_buffer(char *buff, size_t capacity)
 {
+  if (_viewing)
+  {
+    space = _parked_space;
+    _viewing = false;
+  }
   // TODO the following should be moved to v_array
   space.delete_v();
   space.begin() = buff;
   space.end_array = space.end() = buff + capacity;
   head = buff;
 }
+
+void* io_buf::map_private(size_t len)
+{
+  // Checksums need the bytes read.
+  if (current >= input_files.size() || _verify_hash)
+    return nullptr;
+  const uint64_t offset = file_position();
+  void* data = input_files[current]->map_private(offset, len);
+  if (data == nullptr)
+    return nullptr;
+
+  // The file continues after the mapped bytes, so whatever was buffered is stale.
+  reset_buffer();
+  _file_bytes = offset + len;
+  return data;
+}
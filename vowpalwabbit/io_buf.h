@@ -33,6 +33,10 @@
 ** The interval [space.head, space.end] may be shifted down to space.begin
 ** if the requested number of bytes to be read is larger than the interval size.
 ** This is done to avoid reallocating arrays as much as possible.
+**
+** Readers that already hold their contents in memory (see VW::io::reader::take_remaining) are not copied into the
+** buffer at all. Instead space temporarily views the reader's memory, so that buf_read() hands out pointers straight
+** into it, and the owned buffer is parked until the view is used up.
 */
 
 class io_buf
@@ -45,6 +49,12 @@ class io_buf
 
   v_array<char> space;  // space.begin = beginning of loaded values.  space.end = end of read or written values from/to
                         // the buffer.
+  v_array<char> _parked_space;  // the owned buffer while space views a reader's memory
+  bool _viewing;
+  uint64_t _file_bytes;  // bytes moved between the current file and space so far
+
+  void begin_view(const char* data, size_t len);
+  void end_view();
 
 public:
   std::vector<std::unique_ptr<VW::io::reader>> input_files;
@@ -56,7 +66,12 @@ public:
   io_buf(io_buf&& other) = delete;
   io_buf& operator=(io_buf&& other) = delete;
 
-  ~io_buf() { space.delete_v(); }
+  ~io_buf()
+  {
+    if (_viewing)
+      space = _parked_space;
+    space.delete_v();
+  }
 
   void verify_hash(bool verify)
   {
@@ -86,8 +101,14 @@ public:
 
   void reset_buffer()
   {
+    if (_viewing)
+    {
+      space = _parked_space;
+      _viewing = false;
+    }
     space.end() = space.begin();
     head = space.begin();
+    _file_bytes = 0;
   }
 
   void reset_file(VW::io::reader* f)
@@ -96,8 +117,9 @@ public:
     reset_buffer();
   }
 
-  io_buf() : _verify_hash{false}, _hash{0}, current{0}
+  io_buf() : _verify_hash{false}, _hash{0}, _viewing{false}, _file_bytes{0}, current{0}
   {
+    _parked_space = v_init<char>();
     space = v_init<char>();
     space.resize(INITIAL_BUFF_SIZE);
     head = space.begin();
@@ -116,6 +138,21 @@ public:
 
   ssize_t fill(VW::io::reader* f)
   {
+    if (head == space.end())
+    {
+      // nothing left to read in the buffer, so view the reader's memory directly if it allows that
+      const char* data;
+      size_t len;
+      if (f->take_remaining(data, len) && len > 0)
+      {
+        begin_view(data, len);
+        _file_bytes += len;
+        return len;
+      }
+    }
+    if (_viewing)
+      end_view();
+
     // if the loaded values have reached the allocated space
     if (space.end_array - space.end() == 0)
     {  // reallocate to twice as much space
@@ -129,6 +166,7 @@ public:
     {
       // if some bytes were actually loaded, update the end of loaded values
       space.end() = space.end() + num_read;
+      _file_bytes += num_read;
       return num_read;
     }
 
@@ -154,12 +192,24 @@ public:
   //   - Read mode: The offset of the position that has been read up to so far.
   size_t unflushed_bytes_count() { return head - space.begin(); }
 
+  // Offset from the beginning of the current file of what is read or written next.
+  uint64_t file_position()
+  {
+    return output_files.empty() ? _file_bytes - (space.end() - head) : _file_bytes + unflushed_bytes_count();
+  }
+
+  // Maps the next len bytes of the current file copy-on-write instead of reading them, see
+  // VW::io::reader::map_private. file_position() must be a multiple of the page size. Returns nullptr if the file
+  // cannot be mapped, in which case nothing is read.
+  void* map_private(size_t len);
+
   void flush()
   {
     if (!output_files.empty())
     {
       if (write_file(output_files[0].get(), space.begin(), unflushed_bytes_count()) != (int)(unflushed_bytes_count()))
       { std::cerr << "error, failed to write example\n"; }
+      _file_bytes += unflushed_bytes_count();
       head = space.begin();
       output_files[0]->flush();
     }
@@ -169,6 +219,9 @@ public:
   {
     if (!input_files.empty())
     {
+      // the view may point into the file being closed
+      if (_viewing)
+        end_view();
       input_files.pop_back();
       return true;
     }
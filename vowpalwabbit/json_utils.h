@@ -30,7 +30,7 @@ struct Namespace
     feature_count++;
 
     if (audit)
-      ftrs->space_names.push_back(audit_strings_ptr(new audit_strings(name, feature_name)));
+      ftrs->space_names.push_back(std::make_shared<audit_strings>(name, feature_name));
   }
 
   void AddFeature(vw* all, const char* str)
@@ -39,7 +39,7 @@ struct Namespace
     feature_count++;
 
     if (audit)
-      ftrs->space_names.push_back(audit_strings_ptr(new audit_strings(name, str)));
+      ftrs->space_names.push_back(std::make_shared<audit_strings>(name, str));
   }
 
   void AddFeature(vw* all, const char* key, const char* value)
@@ -47,10 +47,8 @@ struct Namespace
     ftrs->push_back(1., VW::chain_hash(*all, key, value, namespace_hash));
     feature_count++;
 
-    std::stringstream ss;
-    ss << key << "^" << value;
     if (audit)
-      ftrs->space_names.push_back(audit_strings_ptr(new audit_strings(name, ss.str())));
+      ftrs->space_names.push_back(std::make_shared<audit_strings>(name, std::string(key) + "^" + value));
   }
 };
 
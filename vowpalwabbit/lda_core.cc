@@ -1370,9 +1370,11 @@ VW::LEARNER::base_learner *lda_setup(options_i &options, vw &all)
   if (minibatch2 > all.p->ring_size)
   {
     bool previous_strict_parse = all.p->strict_parse;
+    size_t previous_num_parse_threads = all.p->num_parse_threads;
     delete all.p;
     all.p = new parser{minibatch2, previous_strict_parse};
     all.p->_shared_data = all.sd;
+    all.p->num_parse_threads = previous_num_parse_threads;
   }
 
   ld->v.resize(all.lda * ld->minibatch);
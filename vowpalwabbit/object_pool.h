@@ -4,9 +4,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
 #include <set>
 #include <queue>
 #include <stack>
+#include <vector>
+
+#include "vw_exception.h"
 
 // Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
 // project.
@@ -215,4 +223,159 @@ struct object_pool
   mutable std::mutex m_lock;
   no_lock_object_pool<T, TInitializer, TCleanup> inner_pool;
 };
+
+/*
+ * Object pool with the interface of object_pool in which getting and returning objects never takes a lock.
+ *
+ * Free objects form a Treiber stack threaded through a per-chunk array of next links. Objects are named by a 32 bit id
+ * (chunk and offset) and the stack head packs the top id with a counter that is bumped on every change, which rules
+ * out ABA when an object is popped and pushed back while another thread is looking at it. Only growing the pool takes
+ * a mutex. Chunks grow geometrically, so a pool has at most a few dozen of them and finding the chunk of an object on
+ * return stays cheap.
+ */
+template <typename T, typename TInitializer = default_initializer<T>, typename TCleanup = default_cleanup<T>>
+struct lock_free_object_pool
+{
+  lock_free_object_pool() = default;
+  lock_free_object_pool(size_t initial_chunk_size, TInitializer initializer = {}, size_t chunk_size = 8)
+      : m_initializer(initializer), m_chunk_size(chunk_size)
+  {
+    std::unique_lock<std::mutex> lock(m_grow_lock);
+    new_chunk(initial_chunk_size);
+  }
+
+  lock_free_object_pool(const lock_free_object_pool&) = delete;
+  lock_free_object_pool& operator=(const lock_free_object_pool&) = delete;
+
+  ~lock_free_object_pool()
+  {
+    const auto num_chunks = m_num_chunks.load();
+    for (size_t c = 0; c < num_chunks; c++)
+      for (size_t i = 0; i < m_chunks[c].size; i++) m_cleanup(&m_chunks[c].objects[i]);
+  }
+
+  void return_object(T* obj)
+  {
+    assert(is_from_pool(obj));
+    const uint32_t id = id_of(obj);
+    auto head = m_head.load(std::memory_order_acquire);
+    do
+    {
+      next_of(id).store(top_of(head), std::memory_order_relaxed);
+    } while (!m_head.compare_exchange_weak(
+        head, make_head(head, id), std::memory_order_release, std::memory_order_acquire));
+  }
+
+  T* get_object()
+  {
+    uint32_t id;
+    while (!try_pop(id))
+    {
+      std::unique_lock<std::mutex> lock(m_grow_lock);
+      // Another thread may have grown the pool or returned objects while this one waited for the lock.
+      if (empty())
+        new_chunk(std::max(m_chunk_size, m_size.load()));
+    }
+    return &m_chunks[chunk_of(id)].objects[offset_of(id)];
+  }
+
+  bool empty() const { return top_of(m_head.load(std::memory_order_acquire)) == EMPTY; }
+
+  // Total number of objects owned by the pool, including the ones currently handed out.
+  size_t size() const { return m_size.load(); }
+
+  bool is_from_pool(T* obj) const { return find_chunk(obj) != NOT_FOUND; }
+
+ private:
+  static constexpr uint32_t OFFSET_BITS = 26;
+  static constexpr uint32_t OFFSET_MASK = (1u << OFFSET_BITS) - 1;
+  static constexpr size_t MAX_CHUNKS = 63;  // chunk 63 would collide with EMPTY
+  static constexpr uint32_t EMPTY = ~0u;
+  static constexpr size_t NOT_FOUND = ~static_cast<size_t>(0);
+
+  struct chunk
+  {
+    std::unique_ptr<T[]> objects;
+    std::unique_ptr<std::atomic<uint32_t>[]> next;
+    size_t size = 0;
+  };
+
+  static uint32_t chunk_of(uint32_t id) { return id >> OFFSET_BITS; }
+  static uint32_t offset_of(uint32_t id) { return id & OFFSET_MASK; }
+  static uint32_t top_of(uint64_t head) { return static_cast<uint32_t>(head); }
+  // The upper half of the head counts modifications. previous is the head being replaced.
+  static uint64_t make_head(uint64_t previous, uint32_t top) { return (((previous >> 32) + 1) << 32) | top; }
+
+  std::atomic<uint32_t>& next_of(uint32_t id) { return m_chunks[chunk_of(id)].next[offset_of(id)]; }
+
+  size_t find_chunk(const T* obj) const
+  {
+    const auto num_chunks = m_num_chunks.load(std::memory_order_acquire);
+    for (size_t c = 0; c < num_chunks; c++)
+    {
+      const auto& ch = m_chunks[c];
+      if (obj >= &ch.objects[0] && obj < &ch.objects[0] + ch.size)
+        return c;
+    }
+    return NOT_FOUND;
+  }
+
+  uint32_t id_of(T* obj) const
+  {
+    const auto c = find_chunk(obj);
+    return static_cast<uint32_t>((c << OFFSET_BITS) | static_cast<size_t>(obj - &m_chunks[c].objects[0]));
+  }
+
+  bool try_pop(uint32_t& id)
+  {
+    auto head = m_head.load(std::memory_order_acquire);
+    while (top_of(head) != EMPTY)
+    {
+      const auto next = next_of(top_of(head)).load(std::memory_order_relaxed);
+      // A stale next is harmless: the head counter has moved on in that case and the exchange fails.
+      if (m_head.compare_exchange_weak(head, make_head(head, next), std::memory_order_acquire))
+      {
+        id = top_of(head);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Must be called with m_grow_lock held.
+  void new_chunk(size_t size)
+  {
+    if (size == 0)
+      return;
+
+    const auto c = m_num_chunks.load();
+    if (c == MAX_CHUNKS || size > OFFSET_MASK)
+      THROW("object pool cannot grow any further");
+
+    auto& ch = m_chunks[c];
+    ch.objects.reset(new T[size]);
+    ch.next.reset(new std::atomic<uint32_t>[size]);
+    ch.size = size;
+    for (size_t i = 0; i < size; i++)
+    {
+      T* obj = m_initializer(&ch.objects[i]);
+      assert(obj == &ch.objects[i]);
+      (void)obj;
+    }
+    m_size += size;
+    m_num_chunks.store(c + 1, std::memory_order_release);
+
+    for (size_t i = 0; i < size; i++) return_object(&ch.objects[i]);
+  }
+
+  TInitializer m_initializer;
+  TCleanup m_cleanup;
+  size_t m_chunk_size = 8;
+
+  chunk m_chunks[MAX_CHUNKS];
+  std::atomic<size_t> m_num_chunks{0};
+  std::atomic<size_t> m_size{0};
+  std::atomic<uint64_t> m_head{EMPTY};
+  std::mutex m_grow_lock;
+};
 }  // namespace VW
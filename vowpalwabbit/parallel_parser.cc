@@ -0,0 +1,324 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#include "parallel_parser.h"
+
+#include "global_data.h"
+#include "parser.h"
+#include "parse_example.h"
+#include "parse_example_json.h"
+#include "cache.h"
+#include "unique_sort.h"
+#include "io/io_adapter.h"
+
+#include <limits>
+
+namespace
+{
+// Lines handed to a worker at once. Large enough to amortize the queue handoff, small enough to keep all workers busy
+// on short inputs.
+constexpr size_t LINES_PER_BLOCK = 64;
+// Blocks in flight per worker before the reading thread waits for the oldest one.
+constexpr size_t BLOCKS_IN_FLIGHT_PER_THREAD = 4;
+}  // namespace
+
+namespace VW
+{
+struct parallel_parser::line_block
+{
+  // Line i is text[line_starts[i], line_starts[i + 1] - 1), followed by a terminating zero for the json parser.
+  std::vector<char> text;
+  std::vector<size_t> line_starts{0};
+
+  // Filled in by the worker. The examples of line i are examples[example_starts[i], example_starts[i + 1]).
+  std::vector<example*> examples;
+  std::vector<size_t> example_starts{0};
+  std::vector<char> is_newline;
+  // Cache encoding of example i is cache_bytes[cache_starts[i], cache_starts[i + 1]) if the cache is being written.
+  std::vector<char> cache_bytes;
+  std::vector<size_t> cache_starts{0};
+  std::exception_ptr exc;
+  bool done = false;
+  // Of the input the lines were read from, which changes to the cache after the first pass.
+  input_format format = input_format::other;
+  // Lines read before the first one of the block, the number parse warnings give the first text example.
+  uint64_t first_line = 0;
+
+  size_t num_lines() const { return line_starts.size() - 1; }
+
+  void clear()
+  {
+    text.clear();
+    line_starts.resize(1);
+    examples.clear();
+    example_starts.resize(1);
+    is_newline.clear();
+    cache_bytes.clear();
+    cache_starts.resize(1);
+    exc = nullptr;
+    done = false;
+  }
+};
+
+struct parallel_parser::worker_state
+{
+  std::vector<VW::string_view> words;
+  // Kept from one line to the next.
+  json_parser<false> json;
+  json_parser<true> json_audit;
+  v_array<example*> line_examples = v_init<example*>();
+  // The n-gram generator keeps scratch state, so each worker gets its own copy.
+  std::unique_ptr<kskip_ngram_transformer> skip_gram_transformer;
+  std::shared_ptr<std::vector<char>> cache_sink = std::make_shared<std::vector<char>>();
+  io_buf cache_buf;
+
+  ~worker_state() { line_examples.delete_v(); }
+};
+
+parallel_parser::parallel_parser(vw& all, size_t num_threads, dispatch_fptr dispatch)
+    : _all(all)
+    , _dispatch(std::move(dispatch))
+    , _max_in_flight(num_threads * BLOCKS_IN_FLIGHT_PER_THREAD)
+    , _current(new line_block)
+    , _work(_max_in_flight)
+{
+  _line_examples = v_init<example*>();
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    _worker_states.emplace_back(new worker_state);
+    auto& state = *_worker_states.back();
+    if (all.skip_gram_transformer != nullptr)
+      state.skip_gram_transformer.reset(new kskip_ngram_transformer(*all.skip_gram_transformer));
+    state.cache_buf.add_file(VW::io::create_vector_writer(state.cache_sink));
+  }
+  for (auto& state : _worker_states) _workers.emplace_back(&parallel_parser::worker_loop, this, std::ref(*state));
+}
+
+parallel_parser::~parallel_parser()
+{
+  shutdown();
+  _line_examples.delete_v();
+}
+
+parallel_parser::input_format parallel_parser::format_of(const vw& all)
+{
+  if (all.p->reader == &read_features_string)
+    return input_format::text;
+
+  // Slates are parsed into a document rather than by the state machine, which is left to the single threaded parser.
+  if (all.max_examples != std::numeric_limits<size_t>::max() ||
+      all.pass_length != std::numeric_limits<size_t>::max() || all.label_type == label_type_t::slates)
+    return input_format::other;
+  if (all.p->reader == &read_features_json<false>)
+    return input_format::json;
+  if (all.p->reader == &read_features_json<true>)
+    return input_format::json_audit;
+  return input_format::other;
+}
+
+bool parallel_parser::handles_input() const { return format_of(_all) != input_format::other; }
+
+bool parallel_parser::read_line()
+{
+  char* line;
+  size_t num_chars;
+  if (read_features(&_all, line, num_chars) < 1)
+    return false;
+
+  if (_current->num_lines() == 0)
+  {
+    _current->format = format_of(_all);
+    _current->first_line = _lines_read;
+  }
+  _lines_read++;
+  _current->text.insert(_current->text.end(), line, line + num_chars);
+  _current->text.push_back('\0');
+  _current->line_starts.push_back(_current->text.size());
+  if (_current->num_lines() == LINES_PER_BLOCK)
+    submit_current_block();
+
+  // Dispatch whatever is ready without waiting, so examples reach the learner while reading continues.
+  while (!_in_flight.empty())
+  {
+    {
+      std::unique_lock<std::mutex> lock(_block_done_lock);
+      if (!_in_flight.front()->done)
+        break;
+    }
+    complete_front_block(true);
+  }
+  return true;
+}
+
+void parallel_parser::drain()
+{
+  if (_current->num_lines() > 0)
+    submit_current_block();
+  while (!_in_flight.empty()) complete_front_block(true);
+}
+
+void parallel_parser::submit_current_block()
+{
+  while (_in_flight.size() >= _max_in_flight) complete_front_block(true);
+
+  line_block* block = _current.get();
+  _in_flight.push_back(std::move(_current));
+  _work.push(block);
+
+  if (_free_blocks.empty())
+    _current.reset(new line_block);
+  else
+  {
+    _current = std::move(_free_blocks.back());
+    _free_blocks.pop_back();
+  }
+}
+
+void parallel_parser::complete_front_block(bool do_dispatch)
+{
+  auto& block = *_in_flight.front();
+  {
+    std::unique_lock<std::mutex> lock(_block_done_lock);
+    _block_done.wait(lock, [&block] { return block.done; });
+  }
+
+  if (do_dispatch)
+  {
+    // On error the block stays in flight so that shutdown() returns its examples to the pool.
+    if (block.exc)
+      std::rethrow_exception(block.exc);
+    dispatch_block(block);
+  }
+  else
+  {
+    for (auto* ex : block.examples) VW::clean_example(_all, *ex, true);
+  }
+
+  block.clear();
+  _free_blocks.push_back(std::move(_in_flight.front()));
+  _in_flight.pop_front();
+}
+
+void parallel_parser::dispatch_block(line_block& block)
+{
+  for (size_t line = 0; line < block.num_lines(); line++)
+  {
+    _line_examples.clear();
+    for (size_t i = block.example_starts[line]; i < block.example_starts[line + 1]; i++)
+    {
+      example* ae = block.examples[i];
+      if (_all.p->write_cache)
+      {
+        _all.p->cache_writer->write_example(
+            block.cache_bytes.data() + block.cache_starts[i], block.cache_starts[i + 1] - block.cache_starts[i]);
+      }
+      VW::setup_example_sequence(_all, ae, block.is_newline[i] != 0);
+      _line_examples.push_back(ae);
+    }
+
+    // Dispatched a line at a time, as the reader would, since the example counter is taken from the number of examples
+    // dispatched so far. Json lines without anything to learn from have no examples.
+    if (!_line_examples.empty())
+      _dispatch(_all, _line_examples);
+  }
+}
+
+void parallel_parser::parse_block(line_block& block, worker_state& state)
+{
+  for (size_t i = 0; i < block.num_lines(); i++)
+  {
+    char* line = block.text.data() + block.line_starts[i];
+    parse_line(block, state, line, block.line_starts[i + 1] - block.line_starts[i] - 1, block.format,
+        block.first_line + i);
+    block.example_starts.push_back(block.examples.size());
+  }
+}
+
+void parallel_parser::parse_line(line_block& block, worker_state& state, char* line, size_t num_chars,
+    input_format format, uint64_t line_number)
+{
+  if (format == input_format::text)
+  {
+    example* ae = &VW::get_unused_example(&_all);
+    block.examples.push_back(ae);
+    substring_to_example(&_all, ae, VW::string_view(line, num_chars), state.words, &_label_lock, line_number);
+    prepare_example(block, state, ae);
+    return;
+  }
+
+  auto& examples = state.line_examples;
+  examples.clear();
+  try
+  {
+    if (format == input_format::json_audit)
+      parse_line_json_threaded<true>(&_all, line, num_chars, examples, state.json_audit, state.words, &_label_lock);
+    else
+      parse_line_json_threaded<false>(&_all, line, num_chars, examples, state.json, state.words, &_label_lock);
+  }
+  catch (...)
+  {
+    VW::return_multiple_example(_all, examples);
+    throw;
+  }
+  for (example* ae : examples)
+  {
+    block.examples.push_back(ae);
+    prepare_example(block, state, ae);
+  }
+}
+
+void parallel_parser::prepare_example(line_block& block, worker_state& state, example* ae)
+{
+  if (_all.p->sort_features && ae->sorted == false)
+    unique_sort_features(_all.parse_mask, ae);
+
+  if (_all.p->write_cache)
+  {
+    _all.p->lp.cache_label(&ae->l, state.cache_buf);
+    cache_features(state.cache_buf, ae, _all.parse_mask);
+    state.cache_buf.flush();
+    block.cache_bytes.insert(block.cache_bytes.end(), state.cache_sink->begin(), state.cache_sink->end());
+    block.cache_starts.push_back(block.cache_bytes.size());
+    state.cache_sink->clear();
+  }
+
+  block.is_newline.push_back(example_is_newline(*ae) ? 1 : 0);
+  VW::setup_example_features(_all, ae, state.skip_gram_transformer.get());
+}
+
+void parallel_parser::worker_loop(worker_state& state)
+{
+  line_block* block;
+  while ((block = _work.pop()) != nullptr)
+  {
+    try
+    {
+      parse_block(*block, state);
+    }
+    catch (...)
+    {
+      block->exc = std::current_exception();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(_block_done_lock);
+      block->done = true;
+    }
+    _block_done.notify_all();
+  }
+}
+
+void parallel_parser::shutdown()
+{
+  if (_shut_down)
+    return;
+  _shut_down = true;
+
+  // Anything still in flight was never dispatched, typically because the learner terminated early or parsing failed.
+  while (!_in_flight.empty()) complete_front_block(false);
+
+  _work.set_done();
+  for (auto& worker : _workers) worker.join();
+}
+}  // namespace VW
@@ -0,0 +1,109 @@
+// Copyright (c) by respective owners including Yahoo!, Microsoft, and
+// individual contributors. All rights reserved. Released under a BSD (revised)
+// license as described in the file LICENSE.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Mutex, CV and thread cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a
+// managed project.
+#ifdef _M_CEE
+#pragma managed(push, off)
+#undef _M_CEE
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#define _M_CEE 001
+#pragma managed(pop)
+#else
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#endif
+
+#include "v_array.h"
+#include "queue.h"
+
+struct vw;
+struct example;
+
+using dispatch_fptr = std::function<void(vw&, const v_array<example*>&)>;
+
+namespace VW
+{
+/*
+ * Parses text and json input on a pool of worker threads.
+ *
+ * The thread driving parse_dispatch() reads lines from the input io_buf and hands them out in blocks. Workers turn each
+ * line into its examples, one for text and several for a multiline json example, and run the order independent part
+ * of setup_example() on them. Finished blocks are dispatched strictly in input order by the driving thread, which also
+ * does everything that depends on the position of the example (cache writing, example counter, holdout), so the
+ * examples seen by the learner are identical to those of the single threaded parser.
+ */
+class parallel_parser
+{
+ public:
+  parallel_parser(vw& all, size_t num_threads, dispatch_fptr dispatch);
+  ~parallel_parser();
+
+  parallel_parser(const parallel_parser&) = delete;
+  parallel_parser& operator=(const parallel_parser&) = delete;
+
+  // Whether the input is read by the text or json reader and can therefore be handled here. Json input is left to the
+  // single threaded parser if the number of examples is limited, as that counts the examples of each line.
+  bool handles_input() const;
+
+  // Reads the next line and queues it for parsing, dispatching blocks that have been parsed in the meantime. Returns
+  // false, without queueing anything, once the input is exhausted.
+  bool read_line();
+
+  // Parses and dispatches every line read so far. Must be called before anything else is dispatched.
+  void drain();
+
+ private:
+  struct line_block;
+  struct worker_state;
+
+  enum class input_format
+  {
+    other,
+    text,
+    json,
+    json_audit
+  };
+  static input_format format_of(const vw& all);
+
+  void submit_current_block();
+  void complete_front_block(bool do_dispatch);
+  void dispatch_block(line_block& block);
+  void parse_block(line_block& block, worker_state& state);
+  void parse_line(line_block& block, worker_state& state, char* line, size_t num_chars, input_format format,
+      uint64_t line_number);
+  void prepare_example(line_block& block, worker_state& state, example* ae);
+  void worker_loop(worker_state& state);
+  void shutdown();
+
+  vw& _all;
+  dispatch_fptr _dispatch;
+  size_t _max_in_flight;
+
+  std::unique_ptr<line_block> _current;
+  std::deque<std::unique_ptr<line_block>> _in_flight;
+  std::vector<std::unique_ptr<line_block>> _free_blocks;
+  ptr_queue<line_block> _work;
+
+  std::mutex _block_done_lock;
+  std::condition_variable _block_done;
+  std::mutex _label_lock;
+
+  std::vector<std::unique_ptr<worker_state>> _worker_states;
+  std::vector<std::thread> _workers;
+  v_array<example*> _line_examples;
+  uint64_t _lines_read = 0;
+  bool _shut_down = false;
+};
+}  // namespace VW
@@ -438,6 +438,16 @@ input_options parse_source(vw& all, options_i& options)
                .help("in persistent daemon mode, do not run in the background"))
       .add(make_option("port", parsed_options.port).help("port to listen on; use 0 to pick unused port"))
       .add(make_option("num_children", all.num_children).help("number of children for persistent daemon mode"))
+      .add(make_option("daemon_threads", parsed_options.daemon_threads)
+               .default_value(0)
+               .help("in persistent daemon mode, serve all connections from one process with this many prediction "
+                     "threads instead of forking children. Requires -t, Linux only"))
+      .add(make_option("daemon_batch_size", parsed_options.daemon_batch_size)
+               .default_value(1)
+               .help("with --daemon_threads, predict examples of different connections in batches of up to this many"))
+      .add(make_option("daemon_batch_wait", parsed_options.daemon_batch_wait)
+               .default_value(0)
+               .help("with --daemon_batch_size, microseconds a batch may wait to fill up before it is predicted"))
       .add(make_option("pid_file", parsed_options.pid_file).help("Write pid file in persistent daemon mode"))
       .add(make_option("port_file", parsed_options.port_file).help("Write port used in persistent daemon mode"))
       .add(make_option("cache", parsed_options.cache).short_name("c").help("Use a cache.  The default is <data>.cache"))
@@ -633,6 +643,7 @@ std::string spoof_hex_encoded_namespaces(const std::string& arg)
 void parse_feature_tweaks(options_i& options, vw& all, std::vector<std::string>& dictionary_nses)
 {
   std::string hash_function("strings");
+  size_t hash_cache_entries = 0;
   uint32_t new_bits;
   std::vector<std::string> spelling_ns;
   std::vector<std::string> quadratics;
@@ -657,6 +668,8 @@ void parse_feature_tweaks(options_i& options, vw& all, std::vector<std::string>&
   feature_options
       .add(make_option("hash", hash_function).keep().help("how to hash the features. Available options: strings, all"))
       .add(make_option("hash_seed", all.hash_seed).keep().default_value(0).help("seed for hash function"))
+      .add(make_option("hash_cache", hash_cache_entries)
+               .help("remember the hashes of up to <arg> recently seen feature and namespace names, 0 to disable"))
       .add(make_option("ignore", ignores).keep().help("ignore namespaces beginning with character <arg>"))
       .add(make_option("ignore_linear", ignore_linears)
                .keep()
@@ -707,6 +720,8 @@ void parse_feature_tweaks(options_i& options, vw& all, std::vector<std::string>&
 
   // feature manipulation
   all.p->hasher = getHasher(hash_function);
+  if (hash_cache_entries > 0)
+    all.p->hash_cache.reset(new VW::hash_cache(hash_cache_entries, all.p->hasher));
 
   if (options.was_supplied("spelling"))
   {
@@ -1230,6 +1245,9 @@ void parse_output_model(options_i& options, vw& all)
       .add(make_option("preserve_performance_counters", all.preserve_performance_counters)
                .help("reset performance counters when warmstarting"))
       .add(make_option("save_per_pass", all.save_per_pass).help("Save the model after every pass over data"))
+      .add(make_option("save_in_background", all.save_in_background)
+               .help("Save the models of --save_per_pass and of save commands from a snapshot of the learner taken by "
+                     "forking, while learning goes on. Not supported on windows"))
       .add(make_option("output_feature_regularizer_binary", all.per_feature_regularizer_output)
                .help("Per feature regularization output file"))
       .add(make_option("output_feature_regularizer_text", all.per_feature_regularizer_text)
@@ -1243,6 +1261,11 @@ void parse_output_model(options_i& options, vw& all)
   if (options.was_supplied("invert_hash"))
     all.hash_inv = true;
 
+#ifdef _WIN32
+  if (all.save_in_background)
+    THROW("--save_in_background is not supported on windows");
+#endif
+
   // Question: This doesn't seem necessary
   // if (options.was_supplied("id") && find(arg.args.begin(), arg.args.end(), "--id") == arg.args.end())
   // {
@@ -1389,9 +1412,13 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
 
     bool strict_parse = false;
     int ring_size_tmp;
+    int parse_threads_tmp;
     option_group_definition vw_args("VW options");
     vw_args.add(make_option("ring_size", ring_size_tmp).default_value(256).help("size of example ring"))
-        .add(make_option("strict_parse", strict_parse).help("throw on malformed examples"));
+        .add(make_option("strict_parse", strict_parse).help("throw on malformed examples"))
+        .add(make_option("parse_threads", parse_threads_tmp)
+                 .default_value(1)
+                 .help("number of threads used to parse text and json input. Examples are still learned in input order"));
     options.add_and_parse(vw_args);
 
     if (ring_size_tmp <= 0)
@@ -1400,8 +1427,14 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
     }
     size_t ring_size = static_cast<size_t>(ring_size_tmp);
 
+    if (parse_threads_tmp <= 0)
+    {
+      THROW("parse_threads should be positive");
+    }
+
     all.p = new parser{ring_size, strict_parse};
     all.p->_shared_data = all.sd;
+    all.p->num_parse_threads = static_cast<size_t>(parse_threads_tmp);
 
     option_group_definition update_args("Update options");
     update_args.add(make_option("learning_rate", all.eta).help("Set learning rate").short_name("l"))
@@ -1414,6 +1447,8 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
                        "given, also used for initial weights."));
     options.add_and_parse(update_args);
 
+    std::string huge_pages;
+    std::string numa_policy;
     option_group_definition weight_args("Weight options");
     weight_args
         .add(make_option("initial_regressor", all.initial_regressors).help("Initial regressor(s)").short_name("i"))
@@ -1422,16 +1457,57 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
         .add(make_option("normal_weights", all.normal_weights).help("make initial weights normal"))
         .add(make_option("truncated_normal_weights", all.tnormal_weights).help("make initial weights truncated normal"))
         .add(make_option("sparse_weights", all.weights.sparse).help("Use a sparse datastructure for weights"))
+        .add(make_option("huge_pages", huge_pages)
+                 .help("Back dense weights with huge pages: thp (transparent), 2m or 1g. Falls back to transparent "
+                       "and then regular pages if the requested ones are not available"))
+        .add(make_option("numa_policy", numa_policy)
+                 .help("Place dense weights on NUMA nodes: interleave (spread pages over the nodes) or bind (only use "
+                       "the nodes)"))
+        .add(make_option("numa_nodes", all.weights.memory_options.numa_nodes)
+                 .help("NUMA nodes for --numa_policy such as 0-1,3. Defaults to all online nodes"))
+        .add(make_option("shared_weights", all.weights.memory_options.shared_weights)
+                 .help("Share dense weights between the processes of a host through a POSIX shared memory segment "
+                       "(/name) or a file. Predicting processes map the weights published there instead of loading "
+                       "their own copy, and publish theirs if there are none yet. Training processes publish their "
+                       "weights whenever they save the model"))
         .add(make_option("input_feature_regularizer", all.per_feature_regularizer_input)
                  .help("Per feature regularization input file"));
     options.add_and_parse(weight_args);
 
+    auto& memory_options = all.weights.memory_options;
+    if (huge_pages == "thp")
+      memory_options.huge_pages = VW::huge_page_mode::transparent;
+    else if (huge_pages == "2m")
+      memory_options.huge_pages = VW::huge_page_mode::explicit_2mb;
+    else if (huge_pages == "1g")
+      memory_options.huge_pages = VW::huge_page_mode::explicit_1gb;
+    else if (!huge_pages.empty())
+      THROW("--huge_pages must be thp, 2m or 1g, not " << huge_pages);
+
+    if (numa_policy == "interleave")
+      memory_options.numa = VW::numa_mode::interleave;
+    else if (numa_policy == "bind")
+      memory_options.numa = VW::numa_mode::bind;
+    else if (!numa_policy.empty())
+      THROW("--numa_policy must be interleave or bind, not " << numa_policy);
+
+    if (options.was_supplied("numa_nodes") &&
+        (numa_policy.empty() ||
+            memory_options.numa_nodes.find_first_not_of("0123456789-,") != std::string::npos))
+      THROW("--numa_nodes requires --numa_policy and takes a list of nodes such as 0-1,3");
+    if (!memory_options.shared_weights.empty() && all.weights.sparse)
+      THROW("--shared_weights requires dense weights, it cannot be used with --sparse_weights");
+
     std::string span_server_arg;
     int span_server_port_arg;
     // bool threads_arg;
     size_t unique_id_arg;
     size_t total_arg;
     size_t node_arg;
+    std::string allreduce_algorithm_arg;
+    bool sparse_sync_arg = false;
+    std::string sync_precision_arg;
+    float sync_top_k_arg;
     option_group_definition parallelization_args("Parallelization options");
     parallelization_args
         .add(make_option("span_server", span_server_arg).help("Location of server for setting up spanning tree"))
@@ -1442,7 +1518,21 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
         .add(make_option("node", node_arg).default_value(0).help("node number in cluster parallel job"))
         .add(make_option("span_server_port", span_server_port_arg)
                  .default_value(26543)
-                 .help("Port of the server for setting up spanning tree"));
+                 .help("Port of the server for setting up spanning tree"))
+        .add(make_option("allreduce_algorithm", allreduce_algorithm_arg)
+                 .default_value("auto")
+                 .help("Algorithm for summing across nodes: tree, ring, halving_doubling, or auto to choose by vector "
+                       "size"))
+        .add(make_option("sparse_sync", sparse_sync_arg)
+                 .help("Ship only nonzero gradients and changed weights between nodes when there are few of them"))
+        .add(make_option("sync_precision", sync_precision_arg)
+                 .default_value("fp32")
+                 .help("Precision of the weight changes shipped by --sparse_sync: fp32, fp16 or bf16. Rounding errors "
+                       "are shipped with the next sync"))
+        .add(make_option("sync_top_k", sync_top_k_arg)
+                 .default_value(1.f)
+                 .help("Fraction of the weights whose changes --sparse_sync ships per sync, largest first. The others "
+                       "are shipped with later syncs"));
     options.add_and_parse(parallelization_args);
 
     // total, unique_id and node must be specified together.
@@ -1455,8 +1545,34 @@ vw& parse_args(options_i& options, trace_message_t trace_listener, void* trace_c
     if (options.was_supplied("span_server"))
     {
       all.all_reduce_type = AllReduceType::Socket;
-      all.all_reduce = new AllReduceSockets(
+      auto sockets = new AllReduceSockets(
           span_server_arg, span_server_port_arg, unique_id_arg, total_arg, node_arg, all.logger.quiet);
+      all.all_reduce = sockets;
+      if (allreduce_algorithm_arg == "tree")
+        sockets->algorithm = AllReduceAlgorithm::Tree;
+      else if (allreduce_algorithm_arg == "ring")
+        sockets->algorithm = AllReduceAlgorithm::Ring;
+      else if (allreduce_algorithm_arg == "halving_doubling")
+        sockets->algorithm = AllReduceAlgorithm::HalvingDoubling;
+      else if (allreduce_algorithm_arg != "auto")
+        THROW("--allreduce_algorithm must be tree, ring, halving_doubling or auto, not " << allreduce_algorithm_arg);
+    }
+
+    if ((options.was_supplied("sync_precision") || options.was_supplied("sync_top_k")) && !sparse_sync_arg)
+      THROW("--sync_precision and --sync_top_k require --sparse_sync");
+    if (sparse_sync_arg)
+    {
+      if (sync_top_k_arg <= 0.f || sync_top_k_arg > 1.f)
+        THROW("--sync_top_k must be in (0, 1], not " << sync_top_k_arg);
+      all.weight_sync = new VW::weight_sync();
+      all.weight_sync->sparse = true;
+      all.weight_sync->top_k = sync_top_k_arg;
+      if (sync_precision_arg == "fp16")
+        all.weight_sync->precision = VW::sync_precision::fp16;
+      else if (sync_precision_arg == "bf16")
+        all.weight_sync->precision = VW::sync_precision::bf16;
+      else if (sync_precision_arg != "fp32")
+        THROW("--sync_precision must be fp32, fp16 or bf16, not " << sync_precision_arg);
     }
 
     parse_diagnostics(options, all);
@@ -1629,6 +1745,25 @@ void parse_sources(options_i& options, vw& all, io_buf& model, bool skipModelLoa
   else
     model.close_file();
 
+  // The first predicting process publishes the weights it loaded for the others, and maps them as they do.
+  const auto& shared_weights = all.weights.memory_options.shared_weights;
+  if (!all.training && !shared_weights.empty() && !all.weights.dense_weights.shared())
+  {
+    if (!VW::shared_weights_published(shared_weights))
+    {
+      publish_shared_weights(all);
+      all.weights.dense_weights.map_shared(shared_weights, all.length());
+    }
+    else if (!all.logger.quiet)
+      all.trace_message << "warning: the weights published as " << shared_weights
+                        << " have another stride, using a copy of the model's" << endl;
+  }
+
+  // Dense weights are allocated while loading the model.
+  if (!all.logger.quiet && !all.weights.sparse &&
+      (all.weights.memory_options.requested() || all.weights.dense_weights.shared()))
+    all.trace_message << "weight memory = " << all.weights.dense_weights.memory_description() << endl;
+
   auto parsed_source_options = parse_source(all, options);
   enable_sources(all, all.logger.quiet, all.numpasses, parsed_source_options);
 
@@ -1939,6 +2074,11 @@ void finish(vw& all, bool delete_all)
     }
 
     all.trace_message << endl << "total feature number = " << all.sd->total_features;
+    if (all.p->hash_cache)
+    {
+      const auto stats = all.p->hash_cache->stats();
+      all.trace_message << endl << "hash cache hits = " << stats.hits << " of " << stats.lookups() << " lookups";
+    }
     if (all.sd->queries > 0)
       all.trace_message << endl << "total queries = " << all.sd->queries;
     all.trace_message << endl;
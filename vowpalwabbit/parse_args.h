@@ -11,6 +11,9 @@ struct input_options
   bool daemon;
   bool foreground;
   size_t port;
+  size_t daemon_threads;
+  size_t daemon_batch_size;
+  size_t daemon_batch_wait;
   std::string pid_file;
   std::string port_file;
 
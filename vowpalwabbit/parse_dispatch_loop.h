@@ -5,21 +5,39 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
-using dispatch_fptr = std::function<void(vw&, const v_array<example*>&)>;
+#include "parallel_parser.h"
 
 inline void parse_dispatch(vw& all, dispatch_fptr dispatch)
 {
   v_array<example*> examples = v_init<example*>();
   size_t example_number = 0;  // for variable-size batch learning algorithms
 
+  // Text input is parsed on a pool of threads if requested with --parse_threads.
+  std::unique_ptr<VW::parallel_parser> parallel;
+  if (all.p->num_parse_threads > 1)
+    parallel.reset(new VW::parallel_parser(all, all.p->num_parse_threads, dispatch));
+
   try
   {
     while (!all.p->done)
     {
+      bool more_input = !all.do_reset_source && example_number != all.pass_length && all.max_examples > example_number;
+      if (parallel != nullptr && parallel->handles_input())
+      {
+        if (more_input && parallel->read_line())
+        {
+          example_number++;
+          continue;
+        }
+        // Every line read so far must reach the learner before the end of pass example.
+        parallel->drain();
+        more_input = false;
+      }
+
       examples.push_back(&VW::get_unused_example(&all));  // need at least 1 example
-      if (!all.do_reset_source && example_number != all.pass_length && all.max_examples > example_number &&
-          all.p->reader(&all, examples) > 0)
+      if (more_input && all.p->reader(&all, examples) > 0)
       {
         VW::setup_examples(all, examples);
         example_number += examples.size();
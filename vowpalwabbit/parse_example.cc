@@ -67,6 +67,8 @@ class TC_parser
   uint32_t _hash_seed;
   uint64_t _parse_mask;
   bool _chain_hash;
+  // Of the example in parse warnings.
+  uint64_t _example_number;
 
   std::array<std::vector<std::shared_ptr<feature_dict>>, NUM_NAMESPACES>* _namespace_dictionaries;
 
@@ -81,7 +83,7 @@ class TC_parser
     // TODO: Find a sane way to handle nulls in the middle of a string (either VW::string_view or substring)
     auto tmp_view = _line.substr(0, _line.find('\0'));
     std::stringstream ss;
-    ss << message << var_msg << message2 << "in Example #" << this->_p->end_parsed_examples.load() << ": \"" << tmp_view << "\""
+    ss << message << var_msg << message2 << "in Example #" << this->_example_number << ": \"" << tmp_view << "\""
        << std::endl;
     if (_p->strict_parse)
     {
@@ -191,13 +193,13 @@ class TC_parser
       if (_chain_hash && !string_feature_value.empty())
       {
         // chain hash is hash(feature_value, hash(feature_name, namespace_hash)) & parse_mask
-        word_hash = (_p->hasher(string_feature_value.begin(), string_feature_value.length(),
-                         _p->hasher(feature_name.begin(), feature_name.length(), _channel_hash)) &
+        word_hash = (_p->hash_token(string_feature_value.begin(), string_feature_value.length(),
+                         _p->hash_token(feature_name.begin(), feature_name.length(), _channel_hash)) &
             _parse_mask);
       }
       else if (!feature_name.empty())
       {
-        word_hash = (_p->hasher(feature_name.begin(), feature_name.length(), _channel_hash) & _parse_mask);
+        word_hash = (_p->hash_token(feature_name.begin(), feature_name.length(), _channel_hash) & _parse_mask);
       }
       else
       {
@@ -386,7 +388,7 @@ class TC_parser
       {
         _base = name;
       }
-      _channel_hash = _p->hasher(name.begin(), name.length(), this->_hash_seed);
+      _channel_hash = _p->hash_token(name.begin(), name.length(), this->_hash_seed);
       nameSpaceInfoValue();
     }
   }
@@ -458,7 +460,8 @@ class TC_parser
     }
   }
 
-  TC_parser(VW::string_view line, vw& all, example* ae) : _line(line)
+  TC_parser(VW::string_view line, vw& all, example* ae, uint64_t example_number)
+      : _line(line), _example_number(example_number)
   {
     _spelling = v_init<char>();
     if (!_line.empty())
@@ -479,13 +482,14 @@ class TC_parser
   }
 };
 
-void substring_to_example(vw* all, example* ae, VW::string_view example)
+void substring_to_example(vw* all, example* ae, VW::string_view example, std::vector<VW::string_view>& words,
+    std::mutex* label_lock, uint64_t example_number)
 {
   all->p->lp.default_label(&ae->l);
 
   size_t bar_idx = example.find('|');
 
-  all->p->words.clear();
+  words.clear();
   if (bar_idx != 0)
   {
     VW::string_view label_space(example);
@@ -501,31 +505,42 @@ void substring_to_example(vw* all, example* ae, VW::string_view example)
       label_space.remove_prefix(tab_idx + 1);
     }
 
-    tokenize(' ', label_space, all->p->words);
-    if (all->p->words.size() > 0 &&
-        (all->p->words.back().end() == label_space.end() ||
-        all->p->words.back().front() == '\''))  // The last field is a tag, so record and strip it off
+    tokenize(' ', label_space, words);
+    if (words.size() > 0 &&
+        (words.back().end() == label_space.end() ||
+        words.back().front() == '\''))  // The last field is a tag, so record and strip it off
     {
-      VW::string_view tag = all->p->words.back();
-      all->p->words.pop_back();
+      VW::string_view tag = words.back();
+      words.pop_back();
       if (tag.front() == '\'')
         tag.remove_prefix(1);
       push_many(ae->tag, tag.begin(), tag.size());
     }
   }
 
-  if (!all->p->words.empty())
-    all->p->lp.parse_label(all->p, all->p->_shared_data, &ae->l, all->p->words);
+  if (!words.empty())
+  {
+    // Label parsers use the scratch space of the shared parser.
+    std::unique_lock<std::mutex> lock;
+    if (label_lock != nullptr)
+      lock = std::unique_lock<std::mutex>(*label_lock);
+    all->p->lp.parse_label(all->p, all->p->_shared_data, &ae->l, words);
+  }
 
   if (bar_idx != VW::string_view::npos)
   {
     if (all->audit || all->hash_inv)
-      TC_parser<true> parser_line(example.substr(bar_idx), *all, ae);
+      TC_parser<true> parser_line(example.substr(bar_idx), *all, ae, example_number);
     else
-      TC_parser<false> parser_line(example.substr(bar_idx), *all, ae);
+      TC_parser<false> parser_line(example.substr(bar_idx), *all, ae, example_number);
   }
 }
 
+void substring_to_example(vw* all, example* ae, VW::string_view example)
+{
+  substring_to_example(all, ae, example, all->p->words, nullptr, all->p->end_parsed_examples.load());
+}
+
 namespace VW
 {
 void read_line(vw& all, example* ex, VW::string_view line)
@@ -3,6 +3,19 @@
 // license as described in the file LICENSE.
 #pragma once
 #include <cstdint>
+#include <vector>
+
+// Mutex cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed project.
+#ifdef _M_CEE
+#pragma managed(push, off)
+#undef _M_CEE
+#include <mutex>
+#define _M_CEE 001
+#pragma managed(pop)
+#else
+#include <mutex>
+#endif
+
 #include "parse_primitives.h"
 #include "example.h"
 #include "vw.h"
@@ -16,6 +29,10 @@ typedef enum
 } FeatureInputType;
 
 void substring_to_example(vw* all, example* ae, VW::string_view example);
+// Variant used by the parse threads: tokens go to the caller's words and label parsing, which uses the scratch space of
+// the shared parser, is serialized on label_lock if it is not null. Warnings refer to the example as example_number.
+void substring_to_example(vw* all, example* ae, VW::string_view example, std::vector<VW::string_view>& words,
+    std::mutex* label_lock, uint64_t example_number);
 
 namespace VW
 {
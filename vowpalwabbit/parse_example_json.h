@@ -37,12 +37,14 @@ VW_WARNING_STATE_POP
 
 #include "best_constant.h"
 #include "json_utils.h"
+#include "parse_example.h"
 #include "parse_slates_example_json.h"
 #include "vw_string_view.h"
 #include <algorithm>
 #include <vector>
 #include <limits>
 #include <sstream>
+#include <type_traits>
 
 // portability fun
 #ifndef _WIN32
@@ -59,68 +61,95 @@ struct BaseState;
 template <bool audit>
 struct Context;
 
+// What a state is. VWReaderHandler switches on it to call the member functions of the current state itself, rather than
+// going through a virtual call for every token.
+enum class StateKind
+{
+  Default,
+  Label,
+  LabelObject,
+  LabelSingleProperty,
+  LabelIndex,
+  Text,
+  Tag,
+  Multi,
+  Ignore,
+  Array,
+  Slots,
+  DecisionService,
+  ArrayFloat,
+  ArrayUint,
+  String,
+  Float,
+  Uint,
+  Bool,
+  SlotOutcomeList
+};
+
+// The tokens a state does not expect. States hide the ones they handle with their own.
 template <bool audit>
 struct BaseState
 {
   const char* name;
+  StateKind kind;
 
-  BaseState(const char* pname) : name(pname) {}
+  BaseState(const char* pname, StateKind pkind) : name(pname), kind(pkind) {}
 
-  virtual BaseState<audit>* Null(Context<audit>& ctx)
+  BaseState<audit>* Null(Context<audit>& ctx)
   {
     // ignore Null by default and stay in the current state
     return ctx.previous_state == nullptr ? this : ctx.previous_state;
   }
 
-  virtual BaseState<audit>* Bool(Context<audit>& ctx, bool b)
+  BaseState<audit>* Bool(Context<audit>& ctx, bool b)
   {
     ctx.error() << "Unexpected token: bool (" << (b ? "true" : "false") << ")";
     return nullptr;
   }
 
-  virtual BaseState<audit>* Float(Context<audit>& ctx, float v)
+  BaseState<audit>* Float(Context<audit>& ctx, float v)
   {
     ctx.error() << "Unexpected token: float (" << v << ")";
     return nullptr;
   }
 
-  virtual BaseState<audit>* Uint(Context<audit>& ctx, unsigned v)
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v)
   {
     ctx.error() << "Unexpected token: uint (" << v << ")";
     return nullptr;
   }
 
-  virtual BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool)
+  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool)
   {
     ctx.error() << "Unexpected token: std::string('" << str << "' len: " << len << ")";
     return nullptr;
   }
 
-  virtual BaseState<audit>* StartObject(Context<audit>& ctx)
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     ctx.error() << "Unexpected token: {";
     return nullptr;
   }
 
-  virtual BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool /* copy */)
+  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool /* copy */)
   {
     ctx.error() << "Unexpected token: key('" << str << "' len: " << len << ")";
     return nullptr;
   }
 
-  virtual BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType)
+  BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType)
   {
     ctx.error() << "Unexpected token: }";
     return nullptr;
   }
 
-  virtual BaseState<audit>* StartArray(Context<audit>& ctx)
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     ctx.error() << "Unexpected token: [";
     return nullptr;
   }
 
-  virtual BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType)
+  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType)
   {
     ctx.error() << "Unexpected token: ]";
     return nullptr;
@@ -143,17 +172,20 @@ class LabelObjectState : public BaseState<audit>
   std::vector<float> probs;
   std::vector<unsigned int> inc;
 
-  LabelObjectState() : BaseState<audit>("LabelObject") {}
+  LabelObjectState() : BaseState<audit>("LabelObject", StateKind::LabelObject) {}
 
   void init(vw* /* all */)
   {
     found = found_cb = found_cb_continuous = false;
+    actions.clear();
+    probs.clear();
+    inc.clear();
 
     cb_label = {0., 0, 0., 0.};
     cont_label_element = {0., 0., 0.};
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     ctx.all->p->lp.default_label(&ctx.ex->l);
 
@@ -170,14 +202,14 @@ class LabelObjectState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool /* copy */) override
+  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool /* copy */)
   {
     ctx.key = str;
     ctx.key_length = len;
     return this;
   }
 
-  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType /* len */, bool) override
+  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType /* len */, bool)
   {
     if (_stricmp(str, "NaN") != 0)
     {
@@ -230,7 +262,7 @@ class LabelObjectState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Float(Context<audit>& ctx, float v) override
+  BaseState<audit>* Float(Context<audit>& ctx, float v)
   {
     // simple
     if (!_stricmp(ctx.key, "Label"))
@@ -286,9 +318,9 @@ class LabelObjectState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v) override { return Float(ctx, (float)v); }
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v) { return Float(ctx, (float)v); }
 
-  BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType) override
+  BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType)
   {
     if (ctx.all->label_type == label_type_t::ccb)
     {
@@ -358,6 +390,7 @@ class LabelObjectState : public BaseState<audit>
     }
     else if (found)
     {
+      auto lock = ctx.lock_labels();
       count_label(ctx.all->sd, ctx.ex->l.simple.label);
 
       found = false;
@@ -371,12 +404,12 @@ class LabelObjectState : public BaseState<audit>
 template <bool audit>
 struct LabelSinglePropertyState : BaseState<audit>
 {
-  LabelSinglePropertyState() : BaseState<audit>("LabelSingleProperty") {}
+  LabelSinglePropertyState() : BaseState<audit>("LabelSingleProperty", StateKind::LabelSingleProperty) {}
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override { return ctx.label_object_state.StartObject(ctx); }
+  BaseState<audit>* StartObject(Context<audit>& ctx) { return ctx.label_object_state.StartObject(ctx); }
 
   // forward _label
-  BaseState<audit>* Float(Context<audit>& ctx, float v) override
+  BaseState<audit>* Float(Context<audit>& ctx, float v)
   {
     // skip "_label_"
     ctx.key += 7;
@@ -388,7 +421,7 @@ struct LabelSinglePropertyState : BaseState<audit>
     return ctx.previous_state;
   }
 
-  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool copy) override
+  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool copy)
   {
     // skip "_label_"
     ctx.key += 7;
@@ -400,7 +433,7 @@ struct LabelSinglePropertyState : BaseState<audit>
     return ctx.previous_state;
   }
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v) override
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v)
   {
     // skip "_label_"
     ctx.key += 7;
@@ -418,9 +451,9 @@ struct LabelIndexState : BaseState<audit>
 {
   int index;
 
-  LabelIndexState() : BaseState<audit>("LabelIndex"), index(-1) {}
+  LabelIndexState() : BaseState<audit>("LabelIndex", StateKind::LabelIndex), index(-1) {}
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned int v) override
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned int v)
   {
     index = v;
     return ctx.previous_state;
@@ -432,24 +465,27 @@ struct LabelIndexState : BaseState<audit>
 template <bool audit>
 struct LabelState : BaseState<audit>
 {
-  LabelState() : BaseState<audit>("Label") {}
+  LabelState() : BaseState<audit>("Label", StateKind::Label) {}
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override { return ctx.label_object_state.StartObject(ctx); }
+  BaseState<audit>* StartObject(Context<audit>& ctx) { return ctx.label_object_state.StartObject(ctx); }
 
-  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType /* len */, bool) override
+  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType len, bool)
   {
-    VW::parse_example_label(*ctx.all, *ctx.ex, str);
+    // Split the label outside the lock, only the label parser itself needs it.
+    tokenize(' ', VW::string_view(str, len), ctx.label_words);
+    auto lock = ctx.lock_labels();
+    ctx.all->p->lp.parse_label(ctx.all->p, ctx.all->p->_shared_data, &ctx.ex->l, ctx.label_words);
     return ctx.previous_state;
   }
 
-  BaseState<audit>* Float(Context<audit>& ctx, float v) override
+  BaseState<audit>* Float(Context<audit>& ctx, float v)
   {
     // TODO: once we introduce label types, check here
     ctx.ex->l.simple.label = v;
     return ctx.previous_state;
   }
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v) override
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned v)
   {
     // TODO: once we introduce label types, check here
     ctx.ex->l.simple.label = (float)v;
@@ -461,7 +497,7 @@ struct LabelState : BaseState<audit>
 template <bool audit>
 struct TextState : BaseState<audit>
 {
-  TextState() : BaseState<audit>("text") {}
+  TextState() : BaseState<audit>("text", StateKind::Text) {}
 
   BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool)
   {
@@ -502,7 +538,7 @@ template <bool audit>
 struct TagState : BaseState<audit>
 {
   // "_tag":"abc"
-  TagState() : BaseState<audit>("tag") {}
+  TagState() : BaseState<audit>("tag", StateKind::Tag) {}
 
   BaseState<audit>* String(Context<audit>& ctx, const char* str, SizeType length, bool)
   {
@@ -515,9 +551,9 @@ struct TagState : BaseState<audit>
 template <bool audit>
 struct MultiState : BaseState<audit>
 {
-  MultiState() : BaseState<audit>("Multi") {}
+  MultiState() : BaseState<audit>("Multi", StateKind::Multi) {}
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     // mark shared example
     if (ctx.all->label_type == label_type_t::cb)
@@ -548,7 +584,7 @@ struct MultiState : BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     // allocate new example
     ctx.ex = &(*ctx.example_factory)(ctx.example_factory_context);
@@ -570,7 +606,7 @@ struct MultiState : BaseState<audit>
     return &ctx.default_state;
   }
 
-  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType) override
+  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType)
   {
     // return to shared example
     ctx.ex = (*ctx.examples)[0];
@@ -583,11 +619,11 @@ struct MultiState : BaseState<audit>
 template <bool audit>
 struct SlotsState : BaseState<audit>
 {
-  SlotsState() : BaseState<audit>("Slots") {}
+  SlotsState() : BaseState<audit>("Slots", StateKind::Slots) {}
   BaseState<audit>* saved;
   BaseState<audit>* saved_root_state;
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     // drain existing added namespace
     // todo check bounds
@@ -597,7 +633,7 @@ struct SlotsState : BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     // allocate new example
     ctx.ex = &(*ctx.example_factory)(ctx.example_factory_context);
@@ -622,7 +658,7 @@ struct SlotsState : BaseState<audit>
     return &ctx.default_state;
   }
 
-  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType) override
+  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType)
   {
     // return to shared example
     ctx.ex = (*ctx.examples)[0];
@@ -639,11 +675,13 @@ template <bool audit>
 class ArrayState : public BaseState<audit>
 {
   feature_index array_hash;
+  // audit name of the current element, reused across elements
+  std::string audit_name;
 
  public:
-  ArrayState() : BaseState<audit>("Array") {}
+  ArrayState() : BaseState<audit>("Array", StateKind::Array) {}
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     if (ctx.previous_state == this)
     {
@@ -658,14 +696,15 @@ class ArrayState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Float(Context<audit>& ctx, float f) override
+  BaseState<audit>* Float(Context<audit>& ctx, float f)
   {
     if (audit)
     {
-      std::stringstream str;
-      str << '[' << (array_hash - ctx.CurrentNamespace().namespace_hash) << ']';
+      audit_name.assign(1, '[');
+      audit_name += std::to_string(array_hash - ctx.CurrentNamespace().namespace_hash);
+      audit_name += ']';
 
-      ctx.CurrentNamespace().AddFeature(f, array_hash, str.str().c_str());
+      ctx.CurrentNamespace().AddFeature(f, array_hash, audit_name.c_str());
     }
     else
       ctx.CurrentNamespace().AddFeature(f, array_hash, nullptr);
@@ -674,15 +713,15 @@ class ArrayState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned f) override { return Float(ctx, (float)f); }
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned f) { return Float(ctx, (float)f); }
 
-  BaseState<audit>* Null(Context<audit>& /* ctx */) override
+  BaseState<audit>* Null(Context<audit>& /* ctx */)
   {
     // ignore null values and stay in current state
     return this;
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     // parse properties
     ctx.PushNamespace(ctx.namespace_path.size() > 0 ? ctx.CurrentNamespace().name : " ", this);
@@ -690,7 +729,7 @@ class ArrayState : public BaseState<audit>
     return &ctx.default_state;
   }
 
-  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType /* elementCount */) override
+  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType /* elementCount */)
   {
     return ctx.PopNamespace();
   }
@@ -700,16 +739,16 @@ class ArrayState : public BaseState<audit>
 template <bool audit>
 struct IgnoreState : BaseState<audit>
 {
-  IgnoreState() : BaseState<audit>("Ignore") {}
+  IgnoreState() : BaseState<audit>("Ignore", StateKind::Ignore) {}
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned) override { return ctx.previous_state; }
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned) { return ctx.previous_state; }
 };
 
 template <bool audit>
 class DefaultState : public BaseState<audit>
 {
  public:
-  DefaultState() : BaseState<audit>("Default") {}
+  DefaultState() : BaseState<audit>("Default", StateKind::Default) {}
 
   BaseState<audit>* Ignore(Context<audit>& ctx, rapidjson::SizeType length)
   {
@@ -797,7 +836,7 @@ class DefaultState : public BaseState<audit>
     return &ctx.ignore_state;
   }
 
-  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool) override
+  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool)
   {
     ctx.key = str;
     ctx.key_length = length;
@@ -878,7 +917,7 @@ class DefaultState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool) override
+  BaseState<audit>* String(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool)
   {
     // string escape
     const char* end = str + length;
@@ -909,7 +948,7 @@ class DefaultState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Bool(Context<audit>& ctx, bool b) override
+  BaseState<audit>* Bool(Context<audit>& ctx, bool b)
   {
     if (b)
       ctx.CurrentNamespace().AddFeature(ctx.all, ctx.key);
@@ -917,13 +956,13 @@ class DefaultState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     ctx.PushNamespace(ctx.key, this);
     return this;
   }
 
-  BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType memberCount) override
+  BaseState<audit>* EndObject(Context<audit>& ctx, rapidjson::SizeType memberCount)
   {
     BaseState<audit>* return_state = ctx.PopNamespace();
 
@@ -978,7 +1017,7 @@ class DefaultState : public BaseState<audit>
     return ctx.namespace_path.empty() ? ctx.root_state : return_state;
   }
 
-  BaseState<audit>* Float(Context<audit>& ctx, float f) override
+  BaseState<audit>* Float(Context<audit>& ctx, float f)
   {
     auto& ns = ctx.CurrentNamespace();
     ns.AddFeature(f, VW::hash_feature_cstr(*ctx.all, const_cast<char*>(ctx.key), ns.namespace_hash), ctx.key);
@@ -986,16 +1025,20 @@ class DefaultState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Uint(Context<audit>& ctx, unsigned f) override { return Float(ctx, (float)f); }
+  BaseState<audit>* Uint(Context<audit>& ctx, unsigned f) { return Float(ctx, (float)f); }
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override { return ctx.array_state.StartArray(ctx); }
+  BaseState<audit>* StartArray(Context<audit>& ctx) { return ctx.array_state.StartArray(ctx); }
 };
 
 template <bool audit, typename T>
 class ArrayToVectorState : public BaseState<audit>
 {
  public:
-  ArrayToVectorState() : BaseState<audit>("ArrayToVectorState") {}
+  ArrayToVectorState()
+      : BaseState<audit>(
+            "ArrayToVectorState", std::is_same<T, float>::value ? StateKind::ArrayFloat : StateKind::ArrayUint)
+  {
+  }
 
   std::vector<T>* output_array;
   BaseState<audit>* return_state;
@@ -1003,7 +1046,7 @@ class ArrayToVectorState : public BaseState<audit>
   // Allows for single value handling.
   bool has_seen_array_start = false;
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     if (ctx.previous_state == this)
     {
@@ -1017,7 +1060,7 @@ class ArrayToVectorState : public BaseState<audit>
   }
 
   BaseState<audit>* String(
-      Context<audit>& ctx, const char* str, rapidjson::SizeType /*length*/, bool /* copy */) override
+      Context<audit>& ctx, const char* str, rapidjson::SizeType /*length*/, bool /* copy */)
   {
     if (_stricmp(str, "NaN") != 0)
     {
@@ -1036,7 +1079,7 @@ class ArrayToVectorState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Uint(Context<audit>& /* ctx */, unsigned f) override
+  BaseState<audit>* Uint(Context<audit>& /* ctx */, unsigned f)
   {
     output_array->push_back(static_cast<T>(f));
 
@@ -1049,7 +1092,7 @@ class ArrayToVectorState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Float(Context<audit>& /* ctx */, float f) override
+  BaseState<audit>* Float(Context<audit>& /* ctx */, float f)
   {
     output_array->push_back(static_cast<T>(f));
 
@@ -1062,7 +1105,7 @@ class ArrayToVectorState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* Null(Context<audit>& /* ctx */) override
+  BaseState<audit>* Null(Context<audit>& /* ctx */)
   {
     if (!has_seen_array_start)
     {
@@ -1074,7 +1117,7 @@ class ArrayToVectorState : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* EndArray(Context<audit>& /*ctx*/, rapidjson::SizeType /*length*/) override
+  BaseState<audit>* EndArray(Context<audit>& /*ctx*/, rapidjson::SizeType /*length*/)
   {
     has_seen_array_start = false;
     return return_state;
@@ -1085,37 +1128,37 @@ template <bool audit>
 class StringToStringState : public BaseState<audit>
 {
  public:
-  StringToStringState() : BaseState<audit>("StringToStringState") {}
+  StringToStringState() : BaseState<audit>("StringToStringState", StateKind::String) {}
 
   std::string* output_string;
   BaseState<audit>* return_state;
 
   BaseState<audit>* String(
-      Context<audit>& /*ctx*/, const char* str, rapidjson::SizeType length, bool /* copy */) override
+      Context<audit>& /*ctx*/, const char* str, rapidjson::SizeType length, bool /* copy */)
   {
     output_string->assign(str, str + length);
     return return_state;
   }
 
-  BaseState<audit>* Null(Context<audit>& /*ctx*/) override { return return_state; }
+  BaseState<audit>* Null(Context<audit>& /*ctx*/) { return return_state; }
 };
 
 template <bool audit>
 class FloatToFloatState : public BaseState<audit>
 {
  public:
-  FloatToFloatState() : BaseState<audit>("FloatToFloatState") {}
+  FloatToFloatState() : BaseState<audit>("FloatToFloatState", StateKind::Float) {}
 
   float* output_float;
   BaseState<audit>* return_state;
 
-  BaseState<audit>* Float(Context<audit>& /*ctx*/, float f) override
+  BaseState<audit>* Float(Context<audit>& /*ctx*/, float f)
   {
     *output_float = f;
     return return_state;
   }
 
-  BaseState<audit>* Null(Context<audit>& /*ctx*/) override
+  BaseState<audit>* Null(Context<audit>& /*ctx*/)
   {
     *output_float = 0.f;
     return return_state;
@@ -1126,12 +1169,12 @@ template <bool audit>
 class UIntToUIntState : public BaseState<audit>
 {
  public:
-  UIntToUIntState() : BaseState<audit>("UIntToUIntState") {}
+  UIntToUIntState() : BaseState<audit>("UIntToUIntState", StateKind::Uint) {}
 
   uint32_t* output_uint;
   BaseState<audit>* return_state;
 
-  BaseState<audit>* Uint(Context<audit>& /*ctx*/, unsigned i) override
+  BaseState<audit>* Uint(Context<audit>& /*ctx*/, unsigned i)
   {
     *output_uint = i;
     return return_state;
@@ -1142,12 +1185,12 @@ template <bool audit>
 class BoolToBoolState : public BaseState<audit>
 {
  public:
-  BoolToBoolState() : BaseState<audit>("BoolToBoolState") {}
+  BoolToBoolState() : BaseState<audit>("BoolToBoolState", StateKind::Bool) {}
 
   bool* output_bool;
   BaseState<audit>* return_state;
 
-  BaseState<audit>* Bool(Context<audit>& /*ctx*/, bool b) override
+  BaseState<audit>* Bool(Context<audit>& /*ctx*/, bool b)
   {
     *output_bool = b;
     return return_state;
@@ -1168,9 +1211,9 @@ class SlotOutcomeList : public BaseState<audit>
  public:
   DecisionServiceInteraction* interactions;
 
-  SlotOutcomeList() : BaseState<audit>("SlotOutcomeList") {}
+  SlotOutcomeList() : BaseState<audit>("SlotOutcomeList", StateKind::SlotOutcomeList) {}
 
-  BaseState<audit>* StartArray(Context<audit>& ctx) override
+  BaseState<audit>* StartArray(Context<audit>& ctx)
   {
     slot_object_index = 0;
 
@@ -1197,7 +1240,7 @@ class SlotOutcomeList : public BaseState<audit>
     return this;
   }
 
-  BaseState<audit>* StartObject(Context<audit>& ctx) override
+  BaseState<audit>* StartObject(Context<audit>& ctx)
   {
     // Set current example so that default state correctly sets the label.
     ctx.ex = (*ctx.examples)[slot_object_index];
@@ -1212,7 +1255,7 @@ class SlotOutcomeList : public BaseState<audit>
     return &ctx.default_state;
   }
 
-  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType) override
+  BaseState<audit>* EndArray(Context<audit>& ctx, rapidjson::SizeType)
   {
     // DSJson requires the interaction object to be filled. After reading all slot outcomes fill out the top actions.
     for (auto ex : *ctx.examples)
@@ -1246,23 +1289,23 @@ template <bool audit>
 class DecisionServiceState : public BaseState<audit>
 {
  public:
-  DecisionServiceState() : BaseState<audit>("DecisionService") {}
+  DecisionServiceState() : BaseState<audit>("DecisionService", StateKind::DecisionService) {}
 
   DecisionServiceInteraction* data;
 
-  BaseState<audit>* StartObject(Context<audit>& /* ctx */) override
+  BaseState<audit>* StartObject(Context<audit>& /* ctx */)
   {
     // TODO: improve validation
     return this;
   }
 
-  BaseState<audit>* EndObject(Context<audit>& /*ctx*/, rapidjson::SizeType /* memberCount */) override
+  BaseState<audit>* EndObject(Context<audit>& /*ctx*/, rapidjson::SizeType /* memberCount */)
   {
     // TODO: improve validation
     return this;
   }
 
-  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool /* copy */) override
+  BaseState<audit>* Key(Context<audit>& ctx, const char* str, rapidjson::SizeType length, bool /* copy */)
   {
     if (length == 1)
     {
@@ -1365,6 +1408,13 @@ struct Context
   VW::example_factory_t example_factory;
   void* example_factory_context;
 
+  // Labels are parsed with the scratch space of the shared parser and counted in the shared data. Parse threads take
+  // turns on them with this lock, see VW::parallel_parser.
+  std::mutex* label_lock = nullptr;
+
+  // The words of the last string label, kept so each parser reuses its own buffer.
+  std::vector<VW::string_view> label_words;
+
   // states
   DefaultState<audit> default_state;
   LabelState<audit> label_state;
@@ -1396,15 +1446,25 @@ struct Context
     root_state = &default_state;
   }
 
+  // Also readies a context that parsed a line before for the next one.
   void init(vw* pall)
   {
     all = pall;
     key = " ";
     key_length = 1;
+    current_state = root_state = &default_state;
     previous_state = nullptr;
+    namespace_path.clear();
+    return_path.clear();
+    error_ptr.reset();
     label_object_state.init(pall);
   }
 
+  std::unique_lock<std::mutex> lock_labels()
+  {
+    return label_lock == nullptr ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(*label_lock);
+  }
+
   std::stringstream& error()
   {
     if (!error_ptr)
@@ -1485,26 +1545,67 @@ struct VWReaderHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
     ctx.example_factory_context = example_factory_context;
   }
 
-  // virtual dispatch to current state
-  bool Bool(bool v) { return ctx.TransitionState(ctx.current_state->Bool(ctx, v)); }
-  bool Int(int v) { return ctx.TransitionState(ctx.current_state->Float(ctx, (float)v)); }
-  bool Uint(unsigned v) { return ctx.TransitionState(ctx.current_state->Uint(ctx, v)); }
-  bool Int64(int64_t v) { return ctx.TransitionState(ctx.current_state->Float(ctx, (float)v)); }
-  bool Uint64(uint64_t v) { return ctx.TransitionState(ctx.current_state->Float(ctx, (float)v)); }
-  bool Double(double v) { return ctx.TransitionState(ctx.current_state->Float(ctx, (float)v)); }
-  bool String(const char* str, SizeType len, bool copy)
-  {
-    return ctx.TransitionState(ctx.current_state->String(ctx, str, len, copy));
-  }
-  bool StartObject() { return ctx.TransitionState(ctx.current_state->StartObject(ctx)); }
-  bool Key(const char* str, SizeType len, bool copy)
-  {
-    return ctx.TransitionState(ctx.current_state->Key(ctx, str, len, copy));
-  }
-  bool EndObject(SizeType count) { return ctx.TransitionState(ctx.current_state->EndObject(ctx, count)); }
-  bool StartArray() { return ctx.TransitionState(ctx.current_state->StartArray(ctx)); }
-  bool EndArray(SizeType count) { return ctx.TransitionState(ctx.current_state->EndArray(ctx, count)); }
-  bool Null() { return ctx.TransitionState(ctx.current_state->Null(ctx)); }
+// Hands a token to the member function of the current state, found through its kind.
+#define VW_JSON_DISPATCH(call)                                                                                  \
+  switch (ctx.current_state->kind)                                                                             \
+  {                                                                                                            \
+    case StateKind::Default:                                                                                   \
+      return ctx.TransitionState(static_cast<DefaultState<audit>*>(ctx.current_state)->call);                  \
+    case StateKind::Label:                                                                                     \
+      return ctx.TransitionState(static_cast<LabelState<audit>*>(ctx.current_state)->call);                    \
+    case StateKind::LabelObject:                                                                               \
+      return ctx.TransitionState(static_cast<LabelObjectState<audit>*>(ctx.current_state)->call);              \
+    case StateKind::LabelSingleProperty:                                                                       \
+      return ctx.TransitionState(static_cast<LabelSinglePropertyState<audit>*>(ctx.current_state)->call);      \
+    case StateKind::LabelIndex:                                                                                \
+      return ctx.TransitionState(static_cast<LabelIndexState<audit>*>(ctx.current_state)->call);               \
+    case StateKind::Text:                                                                                      \
+      return ctx.TransitionState(static_cast<TextState<audit>*>(ctx.current_state)->call);                     \
+    case StateKind::Tag:                                                                                       \
+      return ctx.TransitionState(static_cast<TagState<audit>*>(ctx.current_state)->call);                      \
+    case StateKind::Multi:                                                                                     \
+      return ctx.TransitionState(static_cast<MultiState<audit>*>(ctx.current_state)->call);                    \
+    case StateKind::Ignore:                                                                                    \
+      return ctx.TransitionState(static_cast<IgnoreState<audit>*>(ctx.current_state)->call);                   \
+    case StateKind::Array:                                                                                     \
+      return ctx.TransitionState(static_cast<ArrayState<audit>*>(ctx.current_state)->call);                    \
+    case StateKind::Slots:                                                                                     \
+      return ctx.TransitionState(static_cast<SlotsState<audit>*>(ctx.current_state)->call);                    \
+    case StateKind::DecisionService:                                                                           \
+      return ctx.TransitionState(static_cast<DecisionServiceState<audit>*>(ctx.current_state)->call);          \
+    case StateKind::ArrayFloat:                                                                                \
+      return ctx.TransitionState(static_cast<ArrayToVectorState<audit, float>*>(ctx.current_state)->call);     \
+    case StateKind::ArrayUint:                                                                                 \
+      return ctx.TransitionState(static_cast<ArrayToVectorState<audit, unsigned>*>(ctx.current_state)->call);  \
+    case StateKind::String:                                                                                    \
+      return ctx.TransitionState(static_cast<StringToStringState<audit>*>(ctx.current_state)->call);           \
+    case StateKind::Float:                                                                                     \
+      return ctx.TransitionState(static_cast<FloatToFloatState<audit>*>(ctx.current_state)->call);             \
+    case StateKind::Uint:                                                                                      \
+      return ctx.TransitionState(static_cast<UIntToUIntState<audit>*>(ctx.current_state)->call);               \
+    case StateKind::Bool:                                                                                      \
+      return ctx.TransitionState(static_cast<BoolToBoolState<audit>*>(ctx.current_state)->call);               \
+    case StateKind::SlotOutcomeList:                                                                           \
+      return ctx.TransitionState(static_cast<SlotOutcomeList<audit>*>(ctx.current_state)->call);               \
+  }                                                                                                            \
+  return false
+
+  // dispatch to current state
+  bool Bool(bool v) { VW_JSON_DISPATCH(Bool(ctx, v)); }
+  bool Int(int v) { VW_JSON_DISPATCH(Float(ctx, (float)v)); }
+  bool Uint(unsigned v) { VW_JSON_DISPATCH(Uint(ctx, v)); }
+  bool Int64(int64_t v) { VW_JSON_DISPATCH(Float(ctx, (float)v)); }
+  bool Uint64(uint64_t v) { VW_JSON_DISPATCH(Float(ctx, (float)v)); }
+  bool Double(double v) { VW_JSON_DISPATCH(Float(ctx, (float)v)); }
+  bool String(const char* str, SizeType len, bool copy) { VW_JSON_DISPATCH(String(ctx, str, len, copy)); }
+  bool StartObject() { VW_JSON_DISPATCH(StartObject(ctx)); }
+  bool Key(const char* str, SizeType len, bool copy) { VW_JSON_DISPATCH(Key(ctx, str, len, copy)); }
+  bool EndObject(SizeType count) { VW_JSON_DISPATCH(EndObject(ctx, count)); }
+  bool StartArray() { VW_JSON_DISPATCH(StartArray(ctx)); }
+  bool EndArray(SizeType count) { VW_JSON_DISPATCH(EndArray(ctx, count)); }
+  bool Null() { VW_JSON_DISPATCH(Null(ctx)); }
+
+#undef VW_JSON_DISPATCH
 
   bool VWReaderHandlerNull() { return true; }
   bool VWReaderHandlerDefault() { return false; }
@@ -1526,9 +1627,10 @@ struct json_parser
 
 namespace VW
 {
+// The parser can be kept from one line to the next, which saves setting it up again.
 template <bool audit>
-void read_line_json(
-    vw& all, v_array<example*>& examples, char* line, example_factory_t example_factory, void* ex_factory_context)
+void read_line_json(vw& all, v_array<example*>& examples, char* line, example_factory_t example_factory,
+    void* ex_factory_context, json_parser<audit>& parser)
 {
   if (all.label_type == label_type_t::slates)
   {
@@ -1539,7 +1641,6 @@ void read_line_json(
   // string line_copy(line);
   // destructive parsing
   InsituStringStream ss(line);
-  json_parser<audit> parser;
 
   VWReaderHandler<audit>& handler = parser.handler;
   handler.init(&all, &examples, &ss, line + strlen(line), example_factory, ex_factory_context);
@@ -1559,6 +1660,14 @@ void read_line_json(
   // "Line: '"<< line_copy << "'");
 }
 
+template <bool audit>
+void read_line_json(
+    vw& all, v_array<example*>& examples, char* line, example_factory_t example_factory, void* ex_factory_context)
+{
+  json_parser<audit> parser;
+  read_line_json<audit>(all, examples, line, example_factory, ex_factory_context, parser);
+}
+
 inline void apply_pdrop(vw& all, float pdrop, v_array<example*>& examples)
 {
   if (all.label_type == label_type_t::cb)
@@ -1583,7 +1692,8 @@ inline void apply_pdrop(vw& all, float pdrop, v_array<example*>& examples)
 
 template <bool audit>
 void read_line_decision_service_json(vw& all, v_array<example*>& examples, char* line, size_t length, bool copy_line,
-    example_factory_t example_factory, void* ex_factory_context, DecisionServiceInteraction* data)
+    example_factory_t example_factory, void* ex_factory_context, DecisionServiceInteraction* data,
+    json_parser<audit>& parser)
 {
 
   if(all.label_type == label_type_t::slates)
@@ -1601,7 +1711,6 @@ void read_line_decision_service_json(vw& all, v_array<example*>& examples, char*
   }
 
   InsituStringStream ss(line);
-  json_parser<audit> parser;
 
   VWReaderHandler<audit>& handler = parser.handler;
   handler.init(&all, &examples, &ss, line + length, example_factory, ex_factory_context);
@@ -1622,11 +1731,20 @@ void read_line_decision_service_json(vw& all, v_array<example*>& examples, char*
                                    "Handler: "
                                 << handler.error().str()
                                 << "State: " << (current_state ? current_state->name : "null"));
-}  // namespace VW
+}
+
+template <bool audit>
+void read_line_decision_service_json(vw& all, v_array<example*>& examples, char* line, size_t length, bool copy_line,
+    example_factory_t example_factory, void* ex_factory_context, DecisionServiceInteraction* data)
+{
+  json_parser<audit> parser;
+  read_line_decision_service_json<audit>(
+      all, examples, line, length, copy_line, example_factory, ex_factory_context, data, parser);
+}
 }  // namespace VW
 
 template <bool audit>
-bool parse_line_json(vw* all, char* line, size_t num_chars, v_array<example*>& examples)
+bool parse_line_json(vw* all, char* line, size_t num_chars, v_array<example*>& examples, json_parser<audit>& parser)
 {
   if (all->p->decision_service_json)
   {
@@ -1638,7 +1756,7 @@ bool parse_line_json(vw* all, char* line, size_t num_chars, v_array<example*>& e
 
     DecisionServiceInteraction interaction;
     VW::template read_line_decision_service_json<audit>(*all, examples, line, num_chars, false,
-        reinterpret_cast<VW::example_factory_t>(&VW::get_unused_example), all, &interaction);
+        reinterpret_cast<VW::example_factory_t>(&VW::get_unused_example), all, &interaction, parser);
 
     // TODO: In refactoring the parser to be usable standalone, we need to ensure that we
     // stop suppressing "skipLearn" interactions. Also, not sure if this is the right logic
@@ -1660,12 +1778,20 @@ bool parse_line_json(vw* all, char* line, size_t num_chars, v_array<example*>& e
   }
   else
     VW::template read_line_json<audit>(
-        *all, examples, line, reinterpret_cast<VW::example_factory_t>(&VW::get_unused_example), all);
+        *all, examples, line, reinterpret_cast<VW::example_factory_t>(&VW::get_unused_example), all, parser);
 
   return true;
 }
 
-inline void append_empty_newline_example_for_driver(vw* all, v_array<example*>& examples)
+template <bool audit>
+bool parse_line_json(vw* all, char* line, size_t num_chars, v_array<example*>& examples)
+{
+  json_parser<audit> parser;
+  return parse_line_json<audit>(all, line, num_chars, examples, parser);
+}
+
+inline void append_empty_newline_example_for_driver(
+    vw* all, v_array<example*>& examples, std::vector<VW::string_view>& words, std::mutex* label_lock)
 {
   // note: the json parser does single pass parsing and cannot determine if a shared example is needed.
   // since the communication between the parsing thread the main learner expects examples to be requested in order (as
@@ -1678,12 +1804,18 @@ inline void append_empty_newline_example_for_driver(vw* all, v_array<example*>&
     example& ae = VW::get_unused_example(all);
     static const char empty[] = "";
     VW::string_view example(empty);
-    substring_to_example(all, &ae, example);
+    // without features there is nothing to warn about, so the example number is not used
+    substring_to_example(all, &ae, example, words, label_lock, 0);
 
     examples.push_back(&ae);
   }
 }
 
+inline void append_empty_newline_example_for_driver(vw* all, v_array<example*>& examples)
+{
+  append_empty_newline_example_for_driver(all, examples, all->p->words, nullptr);
+}
+
 // This is used by the python parser
 template <bool audit>
 void line_to_examples_json(vw* all, char* line, size_t num_chars, v_array<example*>& examples)
@@ -1722,3 +1854,19 @@ int read_features_json(vw* all, v_array<example*>& examples)
 
   return 1;
 }
+
+// Parses a line read by VW::parallel_parser on one of its threads, which keeps its parser and words from one line to
+// the next and takes turns on the labels with label_lock. Lines without anything to learn from leave no examples.
+template <bool audit>
+void parse_line_json_threaded(vw* all, char* line, size_t num_chars, v_array<example*>& examples,
+    json_parser<audit>& parser, std::vector<VW::string_view>& words, std::mutex* label_lock)
+{
+  parser.handler.ctx.label_lock = label_lock;
+  examples.push_back(&VW::get_unused_example(all));
+  if (!parse_line_json<audit>(all, line, num_chars, examples, parser))
+  {
+    VW::return_multiple_example(*all, examples);
+    return;
+  }
+  append_empty_newline_example_for_driver(all, examples, words, label_lock);
+}
@@ -7,9 +7,11 @@
 #include "crossplat_compat.h"
 
 #ifndef _WIN32
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
 
+#include <cerrno>
 #include <cstdlib>
 #include <cstdint>
 #include <cmath>
@@ -27,6 +29,7 @@
 #include "vw_validate.h"
 #include "vw_versions.h"
 #include "options_serializer_boost_po.h"
+#include "gd.h"
 
 void initialize_weights_as_random_positive(weight* weights, uint64_t index)
 {
@@ -68,6 +71,34 @@ double calculate_sd(vw& /* all */, T& weights)
   double sq_sum = inner_product(diff.begin(), diff.end(), diff.begin(), 0.0);
   return std::sqrt(sq_sum / my_size);
 }
+void construct_weights(vw& /* all */, sparse_parameters& weights, size_t length, uint32_t stride_shift)
+{
+  new (&weights) sparse_parameters(length, stride_shift);
+}
+
+void construct_weights(vw& all, dense_parameters& weights, size_t length, uint32_t stride_shift)
+{
+  // Predicting processes map the weights already published rather than loading their own copy.
+  const auto& shared_weights = all.weights.memory_options.shared_weights;
+  if (!all.training && !shared_weights.empty())
+  {
+    new (&weights) dense_parameters();
+    weights.stride_shift(stride_shift);
+    if (weights.map_shared(shared_weights, length))
+      return;
+    weights.~dense_parameters();
+  }
+
+  if (all.weights.memory_options.requested())
+    new (&weights) dense_parameters(length, stride_shift, all.weights.memory_options);
+  else
+    new (&weights) dense_parameters(length, stride_shift);
+}
+
+bool shared(const sparse_parameters& /* weights */) { return false; }
+
+bool shared(const dense_parameters& weights) { return weights.shared(); }
+
 template <class T>
 void initialize_regressor(vw& all, T& weights)
 {
@@ -80,7 +111,7 @@ void initialize_regressor(vw& all, T& weights)
   {
     uint32_t ss = weights.stride_shift();
     weights.~T();  // dealloc so that we can realloc, now with a known size
-    new (&weights) T(length, ss);
+    construct_weights(all, weights, length, ss);
   }
   catch (const VW::vw_exception&)
   {
@@ -90,6 +121,8 @@ void initialize_regressor(vw& all, T& weights)
   {
     THROW(" Failed to allocate weight array with " << all.num_bits << " bits: try decreasing -b <bits>");
   }
+  else if (shared(weights))
+    return;
   else if (all.initial_weight != 0.)
   {
     auto initial_weight = all.initial_weight;
@@ -524,17 +557,98 @@ void dump_regressor(vw& all, std::string reg_name, bool as_text)
         << start_name.c_str() << " to " << reg_name.c_str());
 }
 
+void wait_for_background_save(vw& all)
+{
+#ifndef _WIN32
+  if (all.background_save_pid == 0)
+    return;
+  int status;
+  pid_t pid;
+  do
+    pid = waitpid(all.background_save_pid, &status, 0);
+  while (pid < 0 && errno == EINTR);
+  all.background_save_pid = 0;
+  if (pid < 0)
+    THROWERRNO("waitpid");
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    THROW("saving the model in the background failed");
+#else
+  (void)all;
+#endif
+}
+
+// The forked process holds a copy-on-write snapshot of the learner as it is now, which it writes while learning goes
+// on. One model is written at a time.
+//
+// The parser threads may hold locks when the learner forks, and only the forking thread goes on in the child. Writing a
+// model takes none of the parser's or any other lock of vw, so the child does not wait on them: it writes the model
+// on its own thread, as in_background_save keeps the weight encoder from starting more, and reports a failure with
+// write(2) rather than through a stream. It does allocate, which glibc and the macOS libc keep usable in the child of a
+// threaded process by holding the malloc locks across fork.
+void dump_regressor_in_background(vw& all, std::string reg_name)
+{
+#ifndef _WIN32
+  wait_for_background_save(all);
+  pid_t pid = fork();
+  if (pid < 0)
+    THROWERRNO("fork");
+  if (pid == 0)
+  {
+    all.in_background_save = true;
+    int status = 0;
+    try
+    {
+      dump_regressor(all, reg_name, false);
+    }
+    catch (const std::exception& e)
+    {
+      const std::string message = std::string(e.what()) + "\n";
+      const ssize_t written = write(STDERR_FILENO, message.data(), message.size());
+      (void)written;  // the exit status reports the failure anyway
+      status = 1;
+    }
+    // Leave the learner to the parent, nothing of it is torn down here.
+    _exit(status);
+  }
+  all.background_save_pid = pid;
+#else
+  dump_regressor(all, reg_name, false);
+#endif
+}
+
 void save_predictor(vw& all, std::string reg_name, size_t current_pass)
 {
   std::stringstream filename;
   filename << reg_name;
   if (all.save_per_pass)
     filename << "." << current_pass;
-  dump_regressor(all, filename.str(), false);
+  if (all.save_in_background)
+    dump_regressor_in_background(all, filename.str());
+  else
+    dump_regressor(all, filename.str(), false);
+  if (all.training)
+    publish_shared_weights(all);
+}
+
+void publish_shared_weights(vw& all)
+{
+  const auto& name = all.weights.memory_options.shared_weights;
+  if (name.empty())
+    return;
+
+  // Predicting processes use the weights as they are, so pending regularization goes in first. Like the model, what
+  // training publishes is the first float of each weight, which is all that a gd based prediction reads.
+  GD::sync_weights(all);
+  auto& weights = all.weights.dense_weights;
+  const uint64_t generation = VW::publish_shared_weights(
+      name, weights.first(), all.length(), weights.stride_shift(), all.training ? 0 : weights.stride_shift());
+  if (!all.logger.quiet)
+    all.trace_message << "published shared weights " << name << " generation " << generation << std::endl;
 }
 
 void finalize_regressor(vw& all, std::string reg_name)
 {
+  wait_for_background_save(all);
   if (!all.early_terminate)
   {
     if (all.per_feature_regularizer_output.length() > 0)
@@ -550,6 +664,8 @@ void finalize_regressor(vw& all, std::string reg_name)
       dump_regressor(all, all.inv_hash_regressor_name, true);
       all.print_invert = false;
     }
+    if (all.training)
+      publish_shared_weights(all);
   }
 }
 
@@ -12,6 +12,8 @@ void finalize_regressor(vw& all, std::string reg_name);
 void initialize_regressor(vw& all);
 
 void save_predictor(vw& all, std::string reg_name, size_t current_pass);
+// Publishes the weights as --shared_weights for predicting processes to map.
+void publish_shared_weights(vw& all);
 void save_load_header(
     vw& all, io_buf& model_file, bool read, bool text, std::string& file_options, VW::config::options_i& options);
 
@@ -58,7 +58,9 @@ int getpid() { return (int)::GetCurrentProcessId(); }
 #include "parse_example_json.h"
 #include "parse_dispatch_loop.h"
 #include "parse_args.h"
+#include "daemon_server.h"
 #include "io/io_adapter.h"
+#include "memory.h"
 
 // OSX doesn't expects you to use IPPROTO_TCP instead of SOL_TCP
 #if !defined(SOL_TCP) && defined(IPPROTO_TCP)
@@ -69,8 +71,14 @@ using std::endl;
 
 // This should not? matter in a library mode.
 bool got_sigterm;
+VW::daemon_server* running_daemon_server = nullptr;
 
-void handle_sigterm(int) { got_sigterm = true; }
+void handle_sigterm(int)
+{
+  got_sigterm = true;
+  if (running_daemon_server != nullptr)
+    running_daemon_server->stop();
+}
 
 bool is_test_only(uint32_t counter, uint32_t period, uint32_t after, bool holdout_off,
     uint32_t target_modulus)  // target should be 0 in the normal case, or period-1 in the case that emptylines separate
@@ -86,7 +94,7 @@ bool is_test_only(uint32_t counter, uint32_t period, uint32_t after, bool holdou
 
 void set_compressed(parser* /*par*/) {}
 
-uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
+uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer, bool* is_block_cache = nullptr)
 {
   size_t v_length;
   buf->read_file(filepointer, (char*)&v_length, sizeof(v_length));
@@ -109,8 +117,10 @@ uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
   if (buf->read_file(filepointer, &temp, 1) < 1)
     THROW("failed to read");
 
-  if (temp != 'c')
+  if (temp != VW::LEGACY_CACHE_MARKER && temp != VW::BLOCK_CACHE_MARKER)
     THROW("data file is not a cache file");
+  if (is_block_cache != nullptr)
+    *is_block_cache = temp == VW::BLOCK_CACHE_MARKER;
 
   uint32_t cache_numbits;
   if (buf->read_file(filepointer, &cache_numbits, sizeof(cache_numbits)) < (int)sizeof(cache_numbits))
@@ -121,9 +131,17 @@ uint32_t cache_numbits(io_buf* buf, VW::io::reader* filepointer)
   return cache_numbits;
 }
 
-void set_cache_reader(vw& all)
+void set_cache_reader(vw& all, bool block_cache)
 {
-  all.p->reader = read_cached_features;
+  if (block_cache)
+  {
+    all.p->reader = read_cached_block_features;
+    if (all.p->cache_reader == nullptr)
+      all.p->cache_reader = VW::make_unique<VW::cache_block_reader>();
+    all.p->cache_reader->reset();
+  }
+  else
+    all.p->reader = read_cached_features;
 }
 
 void set_string_reader(vw& all)
@@ -185,6 +203,8 @@ void reset_source(vw& all, size_t numbits)
   // If in write cache mode then close all of the input files then open the written cache as the new input.
   if (all.p->write_cache)
   {
+    all.p->cache_writer->finish();
+    all.p->cache_writer.reset();
     all.p->output->flush();
     // Turn off write_cache as we are now reading it instead of writing!
     all.p->write_cache = false;
@@ -199,8 +219,8 @@ void reset_source(vw& all, size_t numbits)
                                                                           << all.p->finalname);
     input->close_files();
     // Now open the written cache as the new input file.
-    input->add_file(VW::io::open_file_reader(all.p->finalname));
-    set_cache_reader(all);
+    input->add_file(VW::io::open_mmap_file_reader(all.p->finalname));
+    set_cache_reader(all, true);
   }
 
   if (all.p->resettable == true)
@@ -210,7 +230,9 @@ void reset_source(vw& all, size_t numbits)
       // wait for all predictions to be sent back to client
       {
         std::unique_lock<std::mutex> lock(all.p->output_lock);
+        ++all.p->output_waiters;
         all.p->output_done.wait(lock, [&] { return all.p->finished_examples == all.p->end_parsed_examples && all.p->ready_parsed_examples.size() == 0; });
+        --all.p->output_waiters;
       }
 
       all.final_prediction_sink.clear();
@@ -242,13 +264,15 @@ void reset_source(vw& all, size_t numbits)
         if (cache_numbits(input, file.get()) < numbits)
           THROW("argh, a bug in caching of some sort!");
       }
+      if (all.p->cache_reader != nullptr)
+        all.p->cache_reader->reset();
     }
   }
 }
 
 void finalize_source(parser*) {}
 
-void make_write_cache(vw& all, std::string& newname, bool quiet)
+void make_write_cache(vw& all, std::string& newname, bool quiet, bool compressed)
 {
   io_buf* output = all.p->output;
   if (output->num_files() != 0)
@@ -272,9 +296,11 @@ void make_write_cache(vw& all, std::string& newname, bool quiet)
 
   output->bin_write_fixed(reinterpret_cast<const char*>(&v_length), sizeof(v_length));
   output->bin_write_fixed(VW::version.to_string().c_str(), v_length);
-  output->bin_write_fixed("c", 1);
+  output->bin_write_fixed(&VW::BLOCK_CACHE_MARKER, 1);
   output->bin_write_fixed(reinterpret_cast<const char*>(&all.num_bits), sizeof(all.num_bits));
   output->flush();
+  const uint64_t header_size = sizeof(v_length) + v_length + 1 + sizeof(all.num_bits);
+  all.p->cache_writer = VW::make_unique<VW::cache_block_writer>(*output, header_size, compressed);
 
   all.p->finalname = newname;
   all.p->write_cache = true;
@@ -282,9 +308,11 @@ void make_write_cache(vw& all, std::string& newname, bool quiet)
     all.trace_message << "creating cache_file = " << newname << endl;
 }
 
-void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache, bool quiet)
+void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache, bool quiet, bool compressed)
 {
   all.p->write_cache = false;
+  // Format of the cache files read so far, they must all agree.
+  int block_cache = -1;
 
   for (auto& file : cache_files)
   {
@@ -292,7 +320,7 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
     if (!kill_cache)
       try
       {
-        all.p->input->add_file(VW::io::open_file_reader(file));
+        all.p->input->add_file(VW::io::open_mmap_file_reader(file));
         cache_file_opened = true;
       }
       catch (const std::exception&)
@@ -300,23 +328,27 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
         cache_file_opened = false;
       }
     if (cache_file_opened == false)
-      make_write_cache(all, file, quiet);
+      make_write_cache(all, file, quiet, compressed);
     else
     {
-      uint64_t c = cache_numbits(all.p->input, all.p->input->input_files.back().get());
+      bool is_block_cache;
+      uint64_t c = cache_numbits(all.p->input, all.p->input->input_files.back().get(), &is_block_cache);
       if (c < all.num_bits)
       {
         if (!quiet)
           all.trace_message << "WARNING: cache file is ignored as it's made with less bit precision than required!"
                             << endl;
         all.p->input->close_file();
-        make_write_cache(all, file, quiet);
+        make_write_cache(all, file, quiet, compressed);
       }
       else
       {
+        if (block_cache != -1 && block_cache != static_cast<int>(is_block_cache))
+          THROW("cache file " << file << " has a different format than the previous cache files, delete it to recreate it");
+        block_cache = static_cast<int>(is_block_cache);
         if (!quiet)
           all.trace_message << "using cache_file = " << file.c_str() << endl;
-        set_cache_reader(all);
+        set_cache_reader(all, is_block_cache);
         if (c == all.num_bits)
           all.p->sorted_cache = true;
         else
@@ -342,7 +374,7 @@ void parse_cache(vw& all, std::vector<std::string> cache_files, bool kill_cache,
 void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_options)
 {
   all.p->input->current = 0;
-  parse_cache(all, input_options.cache_files, input_options.kill_cache, quiet);
+  parse_cache(all, input_options.cache_files, input_options.kill_cache, quiet, input_options.compressed);
 
   // default text reader
   all.p->text_reader = VW::read_lines;
@@ -441,6 +473,28 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
       THROW("not supported on windows");
 #else
       fclose(stdin);
+      if (input_options.daemon_threads > 0)
+      {
+        if (input_options.json || input_options.dsjson)
+          THROW("--daemon_threads only supports the text format");
+        {
+          VW::daemon_server server(all, all.p->bound_sock, input_options.daemon_threads,
+              input_options.daemon_batch_size, input_options.daemon_batch_wait);
+          running_daemon_server = &server;
+          struct sigaction sa;
+          memset(&sa, 0, sizeof(sa));
+          sa.sa_handler = handle_sigterm;
+          sigaction(SIGTERM, &sa, nullptr);
+          if (!all.logger.quiet)
+            all.trace_message << "serving port " << port << " with " << input_options.daemon_threads
+                              << " prediction threads" << endl;
+          server.run();
+          running_daemon_server = nullptr;
+        }
+        VW::finish(all);
+        exit(0);
+      }
+
       // weights will be shared across processes, accessible to children
       all.weights.share(all.length());
 
@@ -611,6 +665,14 @@ void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_opt
   if (passes > 1 && !all.p->resettable)
     THROW("need a cache file for multiple passes : try using --cache_file");
 
+  // Daemon clients expect an answer per line, which the block wise parallel parser would hold back.
+  if (all.p->num_parse_threads > 1 && !all.no_daemon && (all.daemon || all.active))
+  {
+    if (!quiet)
+      all.trace_message << "parse_threads is not supported in daemon mode, parsing on a single thread" << endl;
+    all.p->num_parse_threads = 1;
+  }
+
   if (!quiet && !all.daemon)
     all.trace_message << "num sources = " << all.p->input->num_files() << endl;
 }
@@ -672,15 +734,18 @@ void setup_example(vw& all, example* ae)
 
   if (all.p->write_cache)
   {
-    all.p->lp.cache_label(&ae->l, *(all.p->output));
-    cache_features(*(all.p->output), ae, all.parse_mask);
+    io_buf& cache = all.p->cache_writer->example_buf();
+    all.p->lp.cache_label(&ae->l, cache);
+    cache_features(cache, ae, all.parse_mask);
+    all.p->cache_writer->end_example();
   }
 
-  ae->partial_prediction = 0.;
-  ae->num_features = 0;
-  ae->total_sum_feat_sq = 0;
-  ae->loss = 0.;
+  setup_example_sequence(all, ae, example_is_newline(*ae));
+  setup_example_features(all, ae, all.skip_gram_transformer.get());
+}
 
+void setup_example_sequence(vw& all, example* ae, bool is_newline)
+{
   ae->example_counter = (size_t)(all.p->end_parsed_examples.load());
   if (!all.p->emptylines_separate_examples)
     all.p->in_pass_counter++;
@@ -691,8 +756,16 @@ void setup_example(vw& all, example* ae)
   // If this example has a test only label then it is true regardless.
   ae->test_only |= all.p->lp.test_label(&ae->l);
 
-  if (all.p->emptylines_separate_examples && example_is_newline(*ae))
+  if (all.p->emptylines_separate_examples && is_newline)
     all.p->in_pass_counter++;
+}
+
+void setup_example_features(vw& all, example* ae, VW::kskip_ngram_transformer* skip_gram_transformer)
+{
+  ae->partial_prediction = 0.;
+  ae->num_features = 0;
+  ae->total_sum_feat_sq = 0;
+  ae->loss = 0.;
 
   ae->weight = all.p->lp.get_weight(&ae->l);
 
@@ -707,9 +780,9 @@ void setup_example(vw& all, example* ae)
         i--;
       }
 
-  if(all.skip_gram_transformer != nullptr)
+  if(skip_gram_transformer != nullptr)
   {
-    all.skip_gram_transformer->generate_grams(ae);
+    skip_gram_transformer->generate_grams(ae);
   }
 
   if (all.add_constant)  // add constant feature
@@ -878,9 +951,12 @@ void finish_example(vw& all, example& ec)
 
   clean_example(all, ec, false);
 
+  // The counter is seq_cst as is the waiter count, so either the waiter sees the new count when it checks its predicate
+  // or it is registered by the time it is read here. The lock is only taken if someone is waiting.
+  ++all.p->finished_examples;
+  if (all.p->output_waiters.load() > 0)
   {
     std::lock_guard<std::mutex> lock(all.p->output_lock);
-    ++all.p->finished_examples;
     all.p->output_done.notify_one();
   }
 }
@@ -889,10 +965,7 @@ void finish_example(vw& all, example& ec)
 void thread_dispatch(vw& all, const v_array<example*>& examples)
 {
   all.p->end_parsed_examples += examples.size();
-  for (auto example : examples)
-  {
-    all.p->ready_parsed_examples.push(example);
-  }
+  all.p->ready_parsed_examples.push(examples.begin(), examples.size());
 }
 
 void main_parse_loop(vw* all) { parse_dispatch(*all, thread_dispatch); }
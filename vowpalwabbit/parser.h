@@ -26,6 +26,8 @@
 #include "vw_string_view.h"
 #include "queue.h"
 #include "object_pool.h"
+#include "cache.h"
+#include "hash_cache.h"
 
 struct vw;
 struct input_options;
@@ -64,8 +66,8 @@ struct parser
   // helper(s) for text parsing
   std::vector<VW::string_view> words;
 
-  VW::object_pool<example> example_pool;
-  VW::ptr_queue<example> ready_parsed_examples;
+  VW::lock_free_object_pool<example> example_pool;
+  VW::lock_free_ptr_queue<example> ready_parsed_examples;
 
   io_buf* input = nullptr;  // Input source(s)
   /// reader consumes the input io_buf in the vw object and is generally for file based parsing
@@ -76,8 +78,11 @@ struct parser
   shared_data* _shared_data = nullptr;
 
   hash_func_t hasher;
+  std::unique_ptr<VW::hash_cache> hash_cache;  // Memoizes hasher for repeated names, if enabled.
   bool resettable;           // Whether or not the input can be reset.
   io_buf* output = nullptr;  // Where to output the cache.
+  std::unique_ptr<VW::cache_block_writer> cache_writer;  // Encodes the cache written to output.
+  std::unique_ptr<VW::cache_block_reader> cache_reader;  // State of read_cached_block_features().
   std::string currentname;
   std::string finalname;
 
@@ -86,6 +91,7 @@ struct parser
   bool sorted_cache = false;
 
   const size_t ring_size;
+  size_t num_parse_threads = 1;  // text and json input is parsed on this many threads when greater than one
   std::atomic<uint64_t> begin_parsed_examples;  // The index of the beginning parsed example.
   std::atomic<uint64_t> end_parsed_examples;      // The index of the fully parsed example.
   std::atomic<uint64_t> finished_examples;      // The count of finished examples.
@@ -95,6 +101,7 @@ struct parser
 
   std::mutex output_lock;
   std::condition_variable output_done;
+  std::atomic<int> output_waiters{0};  // threads waiting on output_done, finish_example() only notifies if nonzero
 
   bool done = false;
 
@@ -112,6 +119,12 @@ struct parser
 
   bool strict_parse;
   std::exception_ptr exc_ptr;
+
+  // Hashes a feature or namespace name, going through hash_cache if there is one.
+  uint64_t hash_token(const char* s, size_t len, uint64_t seed)
+  {
+    return hash_cache ? hash_cache->hash(s, len, seed) : hasher(s, len, seed);
+  }
 };
 
 void enable_sources(vw& all, bool quiet, size_t passes, input_options& input_options);
@@ -130,3 +143,17 @@ void finalize_source(parser* source);
 VW_DEPRECATED("Function is no longer used")
 void set_compressed(parser* par);
 void free_parser(vw& all);
+
+namespace VW
+{
+struct kskip_ngram_transformer;
+
+// The two halves of setup_example(). setup_example_features() does not depend on the position of the example in the
+// input and may be run concurrently for different examples, setup_example_sequence() assigns the example counter and
+// holdout state and must be called in input order. is_newline is example_is_newline() evaluated on the parsed example.
+void setup_example_features(vw& all, example* ae, kskip_ngram_transformer* skip_gram_transformer);
+void setup_example_sequence(vw& all, example* ae, bool is_newline);
+
+// Returns an example obtained with get_unused_example() to the pool without dispatching it.
+void clean_example(vw& all, example& ec, bool rewind);
+}  // namespace VW
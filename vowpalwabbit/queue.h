@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <queue>
 
 // Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
@@ -13,11 +16,13 @@
 #undef _M_CEE
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 #define _M_CEE 001
 #pragma managed(pop)
 #else
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 #endif
 
 namespace VW
@@ -86,4 +91,196 @@ class ptr_queue
   std::condition_variable is_not_full;
   std::condition_variable is_not_empty;
 };
+
+/*
+ * Bounded lock-free queue of pointers with the same interface as ptr_queue. Any number of threads may push and pop.
+ *
+ * Items live in a ring of max_size cells, each tagged with a sequence number telling whether it is ready to be written
+ * or read for a given position, so a push or pop is a compare-exchange on the position plus a store, and never takes a
+ * lock. A thread which finds the queue full (push) or empty (pop) spins for a while and then parks on a condition
+ * variable. Parking is tracked in a counter, so the mutex is only touched by the other side while somebody is actually
+ * waiting.
+ */
+template <typename T>
+class lock_free_ptr_queue
+{
+ public:
+  lock_free_ptr_queue(size_t max_size) : _capacity(max_size), _cells(new cell[max_size])
+  {
+    for (size_t i = 0; i < _capacity; i++) _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  lock_free_ptr_queue(const lock_free_ptr_queue&) = delete;
+  lock_free_ptr_queue& operator=(const lock_free_ptr_queue&) = delete;
+
+  T* pop()
+  {
+    T* item = nullptr;
+    pop(&item, 1);
+    return item;
+  }
+
+  // Pops up to max_count items into items, waiting until at least one is available. Returns the number of items
+  // popped, which is only 0 once the queue is done and empty.
+  size_t pop(T** items, size_t max_count)
+  {
+    size_t count = 0;
+    while (count < max_count && try_pop(items[count])) count++;
+
+    if (count == 0)
+    {
+      if (!wait_until([&] { return try_pop(items[0]); }, _waiting_consumers, _is_not_empty))
+        return 0;
+      count = 1;
+    }
+
+    wake(_waiting_producers, _is_not_full);
+    return count;
+  }
+
+  void push(T* item) { push(&item, 1); }
+
+  // Pushes count items in order, waking waiting consumers once for the whole batch. Items which do not fit once the
+  // queue has been marked done are dropped, as nobody will pop them.
+  void push(T* const* items, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!try_push(items[i]))
+      {
+        // Let consumers drain what has been pushed so far before waiting for room.
+        wake(_waiting_consumers, _is_not_empty);
+        T* item = items[i];
+        wait_until([&] { return try_push(item); }, _waiting_producers, _is_not_full);
+      }
+    }
+    wake(_waiting_consumers, _is_not_empty);
+  }
+
+  void set_done()
+  {
+    {
+      std::unique_lock<std::mutex> lock(_park_lock);
+      _done.store(true);
+    }
+    _is_not_empty.notify_all();
+    _is_not_full.notify_all();
+  }
+
+  size_t size() const
+  {
+    const auto dequeue_pos = _dequeue_pos.load(std::memory_order_acquire);
+    const auto enqueue_pos = _enqueue_pos.load(std::memory_order_acquire);
+    return enqueue_pos > dequeue_pos ? static_cast<size_t>(enqueue_pos - dequeue_pos) : 0;
+  }
+
+ private:
+  // Number of failed attempts before a thread parks.
+  static constexpr int SPIN_COUNT = 128;
+
+  struct cell
+  {
+    std::atomic<uint64_t> sequence;
+    T* data;
+  };
+
+  bool try_push(T* item)
+  {
+    auto pos = _enqueue_pos.load(std::memory_order_relaxed);
+    cell* c;
+    while (true)
+    {
+      c = &_cells[pos % _capacity];
+      const auto seq = c->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<int64_t>(seq - pos);
+      if (diff == 0)
+      {
+        if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+        return false;  // full
+      else
+        pos = _enqueue_pos.load(std::memory_order_relaxed);
+    }
+    c->data = item;
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(T*& item)
+  {
+    auto pos = _dequeue_pos.load(std::memory_order_relaxed);
+    cell* c;
+    while (true)
+    {
+      c = &_cells[pos % _capacity];
+      const auto seq = c->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<int64_t>(seq - (pos + 1));
+      if (diff == 0)
+      {
+        if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+        return false;  // empty
+      else
+        pos = _dequeue_pos.load(std::memory_order_relaxed);
+    }
+    item = c->data;
+    c->sequence.store(pos + _capacity, std::memory_order_release);
+    return true;
+  }
+
+  // Spins on attempt, then parks on cv until attempt succeeds. Returns false if the queue was marked done first.
+  template <typename TAttempt>
+  bool wait_until(TAttempt attempt, std::atomic<int>& waiting, std::condition_variable& cv)
+  {
+    for (int i = 0; i < SPIN_COUNT; i++)
+    {
+      if (attempt())
+        return true;
+      if (_done.load())
+        return attempt();
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(_park_lock);
+    waiting++;
+    // Pairs with the fence in wake(): either the other side sees this waiter or the attempt below sees its update.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool success;
+    while (!(success = attempt()) && !_done.load()) cv.wait(lock);
+    waiting--;
+    return success || attempt();
+  }
+
+  void wake(std::atomic<int>& waiting, std::condition_variable& cv)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) > 0)
+    {
+      // Taking the lock guarantees the waiter is blocked in wait() and will not miss the notification.
+      std::unique_lock<std::mutex> lock(_park_lock);
+      cv.notify_all();
+    }
+  }
+
+  const size_t _capacity;
+  std::unique_ptr<cell[]> _cells;
+
+  // Keep the two positions on separate cache lines as they are written by different threads.
+  char _pad0[64];
+  std::atomic<uint64_t> _enqueue_pos{0};
+  char _pad1[64];
+  std::atomic<uint64_t> _dequeue_pos{0};
+  char _pad2[64];
+
+  std::atomic<bool> _done{false};
+  std::atomic<int> _waiting_consumers{0};
+  std::atomic<int> _waiting_producers{0};
+  std::mutex _park_lock;
+  std::condition_variable _is_not_empty;
+  std::condition_variable _is_not_full;
+};
 }  // namespace VW
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+#include "vw_slim_return_codes.h"
+
+namespace vw_slim
+{
+/**
+ * @brief A file mapped read only into memory, whose pages are loaded on first access and shared with every other
+ * mapping of the same file.
+ */
+class mapped_file
+{
+  const char* _data;
+  size_t _size;
+#ifdef _WIN32
+  void* _mapping;
+#endif
+
+ public:
+  mapped_file();
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  /**
+   * @brief Maps the file, an empty file maps to no data.
+   *
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise E_VW_PREDICT_ERR_MODEL_FILE.
+   */
+  int open(const char* filename);
+
+  const char* data() const { return _data; }
+  size_t size() const { return _size; }
+};
+}  // namespace vw_slim
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <cctype>
+#include <cstring>
 #include <string>
 
 #include "vw_slim_return_codes.h"
@@ -143,5 +144,60 @@ class model_parser
 
     return S_VW_PREDICT_OK;
   }
+
+  // gd.cc: save_load_dense_image. Without the online state the image holds the weights one after the other, from an
+  // offset within the model aligned to DENSE_IMAGE_ALIGNMENT.
+  int read_dense_image(uint64_t weight_length, const float** image)
+  {
+    uint64_t length;
+    uint32_t stride_shift;
+    RETURN_ON_FAIL((read<uint64_t, false>("gd.image.length", length)));
+    RETURN_ON_FAIL((read<uint32_t, false>("gd.image.stride_shift", stride_shift)));
+    RETURN_ON_FAIL(skip_unchecked(sizeof(uint32_t)));  // "gd.image.reserved"
+    if (length != weight_length || stride_shift != 0)
+      return E_VW_PREDICT_ERR_INVALID_MODEL;
+
+    const size_t offset = _model - _model_begin;
+    RETURN_ON_FAIL(skip_unchecked((DENSE_IMAGE_ALIGNMENT - offset % DENSE_IMAGE_ALIGNMENT) % DENSE_IMAGE_ALIGNMENT));
+
+    const char* data;
+    RETURN_ON_FAIL(read("gd.image.weights", length * sizeof(float), &data));
+    *image = reinterpret_cast<const float*>(data);
+
+    return S_VW_PREDICT_OK;
+  }
+
+  // Copies the weights of a dense image, which need not be aligned.
+  template <typename W>
+  int read_weights(std::unique_ptr<W>& weights, const float* image, uint32_t num_bits, uint32_t stride_shift)
+  {
+    uint64_t weight_length = (uint64_t)1 << num_bits;
+
+    weights = std::unique_ptr<W>(new W(weight_length));
+    weights->stride_shift(stride_shift);
+
+    const char* data = reinterpret_cast<const char*>(image);
+    for (uint64_t i = 0; i < weight_length; i++)
+    {
+      float w;
+      memcpy(&w, data + i * sizeof(float), sizeof(float));
+      // sparse weights only hold those that are not zero
+      if (w != 0.f)
+        (*weights)[i] = w;
+    }
+
+    return S_VW_PREDICT_OK;
+  }
+
+ private:
+  // A multiple of every page size, see gd.cc.
+  static constexpr size_t DENSE_IMAGE_ALIGNMENT = 1 << 16;
+
+  // Skips bytes excluded from the checksum.
+  int skip_unchecked(size_t bytes)
+  {
+    const char* data;
+    return read("skip", bytes, &data);
+  }
 };
 }  // namespace vw_slim
@@ -0,0 +1,239 @@
+#pragma once
+
+// avoid mmap dependency
+#ifndef DISABLE_SHARED_WEIGHTS
+#define DISABLE_SHARED_WEIGHTS
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "array_parameters.h"
+#include "array_parameters_dense.h"
+#include "constant.h"
+#include "example_predict.h"
+
+namespace vw_slim
+{
+// Feature i of a span has the value values[i] and the index indices[i] << shift.
+struct feature_span
+{
+  const float* values;
+  const uint64_t* indices;
+  size_t size;
+  uint32_t shift;
+};
+
+namespace internal
+{
+/**
+ * @brief Implementations of the innermost loops, picked once for the CPU. On x86-64 CPUs with AVX2 and FMA they
+ * process several features at a time, which adds up the products in a different order than one at a time.
+ */
+struct simd_functions
+{
+  // Adds weights[(((indices[i] << shift) ^ hash) + offset) & mask] * (x * values[i]) for the features [begin, end) of
+  // fs to sum.
+  float (*dot)(const float* weights, uint64_t mask, const feature_span& fs, size_t begin, size_t end, uint64_t hash,
+      float x, uint64_t offset, float sum);
+  // Sets out[i - begin] to FNV_prime * (hash ^ (indices[i] << shift)) for the features [begin, end) of fs.
+  void (*hash)(const feature_span& fs, size_t begin, size_t end, uint64_t hash, uint64_t* out);
+};
+
+const simd_functions& scalar_functions();
+// nullptr if the CPU does not support them.
+const simd_functions* avx2_functions();
+const simd_functions& fastest_functions();
+
+// Reads weights without modifying them, operator[] of sparse_parameters would insert the weights it does not find.
+template <typename W>
+class weight_reader;
+
+template <>
+class weight_reader<dense_parameters>
+{
+  const float* _weights;
+  uint64_t _mask;
+  const simd_functions& _functions;
+
+ public:
+  weight_reader(dense_parameters& weights, const simd_functions& functions)
+      : _weights(weights.first()), _mask(weights.mask()), _functions(functions)
+  {
+  }
+
+  float dot(const feature_span& fs, size_t begin, size_t end, uint64_t hash, float x, uint64_t offset, float sum) const
+  {
+    return _functions.dot(_weights, _mask, fs, begin, end, hash, x, offset, sum);
+  }
+};
+
+template <>
+class weight_reader<sparse_parameters>
+{
+  const sparse_parameters& _weights;
+
+ public:
+  weight_reader(sparse_parameters& weights, const simd_functions&) : _weights(weights) {}
+
+  float dot(const feature_span& fs, size_t begin, size_t end, uint64_t hash, float x, uint64_t offset, float sum) const
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      const weight* w = _weights.find(((fs.indices[i] << fs.shift) ^ hash) + offset);
+      if (w != nullptr)
+        sum += *w * (x * fs.values[i]);
+    }
+    return sum;
+  }
+};
+}  // namespace internal
+
+/**
+ * @brief Computes the linear terms and interactions of an example, without modifying it or allocating memory.
+ *
+ * The features of a namespace of the example can be followed by those of the same namespace of a shared example, which
+ * gives the same result as copying the shared features into the example. The constant feature is added the same way.
+ * Interactions are simple combinations, as without --permutations.
+ */
+template <typename W>
+class predict_kernel
+{
+  // Features handed to an interaction at a time by the second to last namespace, whose hashes are computed together.
+  static constexpr size_t HASH_BLOCK = 8;
+
+  internal::weight_reader<W> _weights;
+  const internal::simd_functions& _functions;
+  example_predict& _ex;
+  example_predict* _shared;
+  const bool* _shared_namespaces;
+  uint64_t _offset;
+  uint32_t _shift;
+  bool _has_constant;
+  uint64_t _constant_index;
+  float _constant_value;
+
+  // The features of namespace ns of the example followed by the second part.
+  struct namespace_view
+  {
+    feature_span first;
+    feature_span second;
+
+    size_t size() const { return first.size + second.size; }
+  };
+
+  feature_span span_of(example_predict& ex, namespace_index ns) const
+  {
+    features& fs = ex.feature_space[ns];
+    return {fs.values.begin(), fs.indicies.begin(), fs.size(), _shift};
+  }
+
+  namespace_view view_of(namespace_index ns) const
+  {
+    if (_has_constant && ns == constant_namespace)
+      return {span_of(_ex, ns), {&_constant_value, &_constant_index, 1, 0}};
+    if (_shared != nullptr && _shared_namespaces[ns])
+      return {span_of(_ex, ns), span_of(*_shared, ns)};
+    return {span_of(_ex, ns), {nullptr, nullptr, 0, 0}};
+  }
+
+  // Adds the terms of the features from start onwards of the last namespace.
+  float interact_last(const namespace_view& view, size_t start, uint64_t hash, float x, float sum) const
+  {
+    if (start < view.first.size)
+      sum = _weights.dot(view.first, start, view.first.size, hash, x, _offset, sum);
+    const size_t second_start = start > view.first.size ? start - view.first.size : 0;
+    return _weights.dot(view.second, second_start, view.second.size, hash, x, _offset, sum);
+  }
+
+  // The second to last namespace hashes the indices of a block of features at once.
+  float interact_block(const namespace_index* ns, const feature_span& fs, size_t position, size_t begin, size_t end,
+      uint64_t hash, float x, float sum) const
+  {
+    const namespace_view last = view_of(ns[1]);
+    const bool same_namespace = ns[0] == ns[1];
+
+    uint64_t hashes[HASH_BLOCK];
+    for (size_t block = begin; block < end; block += HASH_BLOCK)
+    {
+      const size_t block_end = block + HASH_BLOCK < end ? block + HASH_BLOCK : end;
+      _functions.hash(fs, block, block_end, hash, hashes);
+      for (size_t i = block; i < block_end; i++)
+        sum = interact_last(last, same_namespace ? position + i : 0, hashes[i - block], fs.values[i] * x, sum);
+    }
+    return sum;
+  }
+
+  float interact(const namespace_index* ns, size_t remaining, size_t start, uint64_t hash, float x, float sum) const
+  {
+    const namespace_view view = view_of(ns[0]);
+    if (remaining == 1)
+      return interact_last(view, start, hash, x, sum);
+
+    if (remaining == 2)
+    {
+      if (start < view.first.size)
+        sum = interact_block(ns, view.first, 0, start, view.first.size, hash, x, sum);
+      const size_t second_start = start > view.first.size ? start - view.first.size : 0;
+      return interact_block(ns, view.second, view.first.size, second_start, view.second.size, hash, x, sum);
+    }
+
+    // Simple combinations: a namespace repeated in the interaction starts at the feature of its previous occurrence.
+    const bool same_namespace = ns[0] == ns[1];
+    for (size_t i = start; i < view.size(); i++)
+    {
+      const feature_span& fs = i < view.first.size ? view.first : view.second;
+      const size_t j = i < view.first.size ? i : i - view.first.size;
+      const uint64_t next_hash = FNV_prime * (hash ^ (fs.indices[j] << fs.shift));
+      sum = interact(ns + 1, remaining - 1, same_namespace ? i : 0, next_hash, fs.values[j] * x, sum);
+    }
+    return sum;
+  }
+
+ public:
+  /**
+   * @param ex The example, or action.
+   * @param shared The shared example whose namespaces follow those of ex in interactions, or nullptr.
+   * @param shared_namespaces Which namespaces of shared to use, indexed by namespace.
+   * @param offset The feature offset, ft_offset of ex unless the model picks one.
+   * @param shift Applied to the feature indices of ex and shared, the stride shift of bag models.
+   * @param constant_index Index of the constant feature, which is not added if add_constant is false.
+   */
+  predict_kernel(W& weights, const internal::simd_functions& functions, example_predict& ex, example_predict* shared,
+      const bool* shared_namespaces, uint64_t offset, uint32_t shift, bool add_constant, uint64_t constant_index)
+      : _weights(weights, functions)
+      , _functions(functions)
+      , _ex(ex)
+      , _shared(shared)
+      , _shared_namespaces(shared_namespaces)
+      , _offset(offset)
+      , _shift(shift)
+      , _has_constant(add_constant)
+      , _constant_index(constant_index)
+      , _constant_value(1.f)
+  {
+  }
+
+  // Adds the linear terms of the namespaces listed in the indices of the example, then the constant feature.
+  float linear(float sum) const
+  {
+    for (namespace_index ns : _ex.indices)
+    {
+      const feature_span fs = span_of(_ex, ns);
+      sum = _weights.dot(fs, 0, fs.size, 0, 1.f, _offset, sum);
+    }
+    if (_has_constant)
+      sum = _weights.dot({&_constant_value, &_constant_index, 1, 0}, 0, 1, 0, 1.f, _offset, sum);
+    return sum;
+  }
+
+  // Adds the terms of an interaction, whose namespaces are sorted.
+  float interaction(const std::vector<namespace_index>& interaction, float sum) const
+  {
+    if (interaction.empty())
+      return sum;
+    return interact(interaction.data(), interaction.size(), 0, 0, 1.f, sum);
+  }
+};
+}  // namespace vw_slim
@@ -10,9 +10,10 @@
 
 #include "example_predict.h"
 #include "explore.h"
-#include "gd_predict.h"
+#include "mapped_file.h"
 #include "model_parser.h"
 #include "opts.h"
+#include "predict_kernel.h"
 
 namespace vw_slim
 {
@@ -162,6 +163,25 @@ class collection_pair_iterator
     return *this;
   }
 };
+
+// Weights using a dense image where it lies, nullptr if W cannot.
+template <typename W>
+struct image_weights
+{
+  static W* borrow(const float*, uint64_t) { return nullptr; }
+};
+
+template <>
+struct image_weights<dense_parameters>
+{
+  // The predictor never writes to the weights, so they can be read only.
+  static dense_parameters* borrow(const float* image, uint64_t length)
+  {
+    dense_parameters* weights = new dense_parameters();
+    weights->borrow(const_cast<float*>(image), length);
+    return weights;
+  }
+};
 }  // namespace internal
 }  // namespace vw_slim
 
@@ -214,18 +234,42 @@ class stride_shift_guard
   ~stride_shift_guard();
 };
 
+/**
+ * @brief Scratch space of the contextual bandit predict. Passing the same scratch to every predict lets them run
+ * without allocating memory once it holds enough actions. A scratch must only be used by one predict at a time.
+ */
+class cb_predict_scratch
+{
+ public:
+  /**
+   * @brief Sizes the scratch space for up to num_actions actions.
+   */
+  void reserve(size_t num_actions)
+  {
+    scores.reserve(num_actions);
+    top_actions.reserve(num_actions);
+  }
+
+  std::vector<float> scores;
+  std::vector<uint32_t> top_actions;
+};
+
 /**
  * @brief Vowpal Wabbit slim predictor. Supports: regression, multi-class classification and contextual bandits.
+ *
+ * Predictions neither modify the examples nor allocate memory, except for the contextual bandit predict which needs
+ * a cb_predict_scratch to avoid it. Predictions do not modify the instance either, so it can predict on several
+ * threads at once.
  */
 template <typename W>
 class vw_predict
 {
-  std::unique_ptr<W> _weights;
+  // Shared by the instances using the same model, which only read them.
+  std::shared_ptr<W> _weights;
   std::string _id;
   std::string _version;
   std::string _command_line_arguments;
   std::vector<std::vector<namespace_index>> _interactions;
-  std::array<bool, NUM_NAMESPACES> _ignore_linear;
   bool _no_constant;
 
   vw_predict_exploration _exploration;
@@ -238,8 +282,10 @@ class vw_predict
   uint32_t _stride_shift;
   bool _model_loaded;
 
+  const internal::simd_functions& _functions;
+
  public:
-  vw_predict() : _model_loaded(false) {}
+  vw_predict() : _model_loaded(false), _functions(internal::fastest_functions()) {}
 
   /**
    * @brief Reads the Vowpal Wabbit model from the supplied buffer (produced using vw -f <modelname>)
@@ -248,132 +294,53 @@ class vw_predict
    * @param length The length of the binary model.
    * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
    */
-  int load(const char* model, size_t length)
-  {
-    if (!model || length == 0)
-      return E_VW_PREDICT_ERR_INVALID_MODEL;
-
-    _model_loaded = false;
-
-    // required for inline_predict
-    _ignore_linear.fill(false);
-
-    model_parser mp(model, length);
-
-    // parser_regressor.cc: save_load_header
-    RETURN_ON_FAIL(mp.read_string<false>("version", _version));
-
-    // read model id
-    RETURN_ON_FAIL(mp.read_string<true>("model_id", _id));
-
-    RETURN_ON_FAIL(mp.skip(sizeof(char)));   // "model character"
-    RETURN_ON_FAIL(mp.skip(sizeof(float)));  // "min_label"
-    RETURN_ON_FAIL(mp.skip(sizeof(float)));  // "max_label"
-
-    RETURN_ON_FAIL(mp.read("num_bits", _num_bits));
-
-    RETURN_ON_FAIL(mp.skip(sizeof(uint32_t)));  // "lda"
+  int load(const char* model, size_t length) { return load(model, length, nullptr); }
 
-    uint32_t ngram_len;
-    RETURN_ON_FAIL(mp.read("ngram_len", ngram_len));
-    mp.skip(3 * ngram_len);
-
-    uint32_t skips_len;
-    RETURN_ON_FAIL(mp.read("skips_len", skips_len));
-    mp.skip(3 * skips_len);
-
-    RETURN_ON_FAIL(mp.read_string<true>("file_options", _command_line_arguments));
-
-    // command line arg parsing
-    _no_constant = _command_line_arguments.find("--noconstant") != std::string::npos;
-
-    // only 0-valued hash_seed supported
-    int hash_seed;
-    if (find_opt_int(_command_line_arguments, "--hash_seed", hash_seed) && hash_seed)
-      return E_VW_PREDICT_ERR_HASH_SEED_NOT_SUPPORTED;
-
-    _interactions.clear();
-    find_opt(_command_line_arguments, "-q", _interactions);
-    find_opt(_command_line_arguments, "--quadratic", _interactions);
-    find_opt(_command_line_arguments, "--cubic", _interactions);
-    find_opt(_command_line_arguments, "--interactions", _interactions);
-
-    // VW performs the following transformation as a side-effect of looking for duplicates.
-    // This affects how interaction hashes are generated.
-    std::vector<std::vector<namespace_index>> vec_sorted;
-    for (auto &interaction : _interactions)
-    {
-      std::vector<namespace_index> sorted_i(interaction);
-      std::sort(std::begin(sorted_i), std::end(sorted_i));
-      vec_sorted.push_back(sorted_i);
-    }
-    _interactions = vec_sorted;
-
-    // TODO: take --cb_type dr into account
-    uint64_t num_weights = 0;
-
-    if (_command_line_arguments.find("--cb_explore_adf") != std::string::npos)
-    {
-      // parse exploration options
-      if (find_opt_int(_command_line_arguments, "--bag", _bag_size))
-      {
-        _exploration = vw_predict_exploration::bag;
-        num_weights = _bag_size;
-
-        // check for additional minimum epsilon greedy
-        _minimum_epsilon = 0.f;
-        find_opt_float(_command_line_arguments, "--epsilon", _minimum_epsilon);
-      }
-      else if (_command_line_arguments.find("--softmax") != std::string::npos)
-      {
-        if (find_opt_float(_command_line_arguments, "--lambda", _lambda))
-        {
-          if (_lambda > 0)  // Lambda should always be negative because we are using a cost basis.
-            _lambda = -_lambda;
-          _exploration = vw_predict_exploration::softmax;
-        }
-      }
-      else if (find_opt_float(_command_line_arguments, "--epsilon", _epsilon))
-        _exploration = vw_predict_exploration::epsilon_greedy;
-      else
-        return E_VW_PREDICT_ERR_CB_EXPLORATION_MISSING;
-    }
-
-    // VW style check_sum validation
-    uint32_t check_sum_computed = mp.checksum();
-
-    // perform check sum check
-    uint32_t check_sum_len;
-    RETURN_ON_FAIL((mp.read<uint32_t, false>("check_sum_len", check_sum_len)));
-    if (check_sum_len != sizeof(uint32_t))
-      return E_VW_PREDICT_ERR_INVALID_MODEL;
-
-    uint32_t check_sum;
-    RETURN_ON_FAIL((mp.read<uint32_t, false>("check_sum", check_sum)));
-
-    if (check_sum_computed != check_sum)
-      return E_VW_PREDICT_ERR_INVALID_MODEL_CHECK_SUM;
-
-    if (_command_line_arguments.find("--cb_adf") != std::string::npos)
-    {
-      RETURN_ON_FAIL(mp.skip(sizeof(uint64_t)));  // cb_adf.cc: event_sum
-      RETURN_ON_FAIL(mp.skip(sizeof(uint64_t)));  // cb_adf.cc: action_sum
-    }
-
-    // gd.cc: save_load
-    bool gd_resume;
-    RETURN_ON_FAIL(mp.read("resume", gd_resume));
-    if (gd_resume)
-      return E_VW_PREDICT_ERR_GD_RESUME_NOT_SUPPORTED;
-
-    // read sparse weights into dense
-    uint64_t weight_length = (uint64_t)1 << _num_bits;
-    _stride_shift = (uint32_t)ceil_log_2(num_weights);
-
-    RETURN_ON_FAIL(mp.read_weights<W>(_weights, _num_bits, _stride_shift));
-
-    // TODO: check that permutations is not enabled (or parse it)
+  /**
+   * @brief Maps the Vowpal Wabbit model file into memory and reads it.
+   *
+   * The weights of models saved with --dense_image are used where they lie in the file when W is dense_parameters,
+   * so they are loaded from disk as needed and shared with every process mapping the same file. Otherwise they are
+   * copied as load(model, length) does.
+   *
+   * @param filename The model file.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int load_file(const char* filename)
+  {
+    std::shared_ptr<mapped_file> file = std::make_shared<mapped_file>();
+    RETURN_ON_FAIL(file->open(filename));
+    return load(file->data(), file->size(), file);
+  }
 
+  /**
+   * @brief Uses the model loaded by another instance, whose weights are shared rather than copied.
+   *
+   * The weights are released with the last instance using them.
+   *
+   * @param other The instance which loaded the model.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int load(const vw_predict<W>& other)
+  {
+    if (!other._model_loaded)
+      return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
+    if (&other == this)
+      return S_VW_PREDICT_OK;
+
+    _weights = other._weights;
+    _id = other._id;
+    _version = other._version;
+    _command_line_arguments = other._command_line_arguments;
+    _interactions = other._interactions;
+    _no_constant = other._no_constant;
+    _exploration = other._exploration;
+    _minimum_epsilon = other._minimum_epsilon;
+    _epsilon = other._epsilon;
+    _lambda = other._lambda;
+    _bag_size = other._bag_size;
+    _num_bits = other._num_bits;
+    _stride_shift = other._stride_shift;
     _model_loaded = true;
 
     return S_VW_PREDICT_OK;
@@ -410,22 +377,48 @@ class vw_predict
     if (!_model_loaded)
       return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
 
-    std::unique_ptr<namespace_copy_guard> ns_copy_guard;
+    const predict_kernel<W> kernel = make_kernel(ex, nullptr, nullptr, ex.ft_offset, 0);
+    score = kernel.linear(0.f);
+    for (auto& interaction : _interactions) score = kernel.interaction(interaction, score);
 
-    if (!_no_constant)
-    {
-      // add constant feature
-      ns_copy_guard = std::unique_ptr<namespace_copy_guard>(new namespace_copy_guard(ex, constant_namespace));
-      ns_copy_guard->feature_push_back(1.f, (constant << _stride_shift) + ex.ft_offset);
-    }
+    return S_VW_PREDICT_OK;
+  }
 
-    score = GD::inline_predict<W>(*_weights, false, _ignore_linear, _interactions, /* permutations */ false, ex);
+  /**
+   * @brief Predicts scores (as in regression) for many examples.
+   *
+   * @param examples The examples to get the predictions for.
+   * @param num_examples The number of examples.
+   * @param out_scores Receives the score of example i at index i, must hold num_examples scores.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int predict_batch(example_predict* examples, size_t num_examples, float* out_scores)
+  {
+    if (!_model_loaded)
+      return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
+
+    for (size_t i = 0; i < num_examples; i++) RETURN_ON_FAIL(predict(examples[i], out_scores[i]));
 
     return S_VW_PREDICT_OK;
   }
 
   // multiclass classification
   int predict(example_predict& shared, example_predict* actions, size_t num_actions, std::vector<float>& out_scores)
+  {
+    out_scores.resize(num_actions);
+    return predict(shared, actions, num_actions, out_scores.data());
+  }
+
+  /**
+   * @brief Scores the actions of a context, as predict(shared, actions, num_actions, out_scores) does, into a buffer.
+   *
+   * The part of the score which only depends on the shared features is computed once and reused for all actions. The
+   * shared features are not copied into the actions.
+   *
+   * @param out_scores Receives the score of action i at index i, must hold num_actions scores.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int predict(example_predict& shared, example_predict* actions, size_t num_actions, float* out_scores)
   {
     if (!_model_loaded)
       return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
@@ -433,27 +426,28 @@ class vw_predict
     if (!is_csoaa_ldf())
       return E_VW_PREDICT_ERR_NO_A_CSOAA_MODEL;
 
-    out_scores.resize(num_actions);
+    score_actions(shared, actions, num_actions, false, 0, 0, out_scores);
+    return S_VW_PREDICT_OK;
+  }
 
-    example_predict* action = actions;
-    for (size_t i = 0; i < num_actions; i++, action++)
+  /**
+   * @brief Scores the actions of many contexts.
+   *
+   * @param shared The shared examples of the contexts.
+   * @param num_contexts The number of contexts.
+   * @param actions The actions of all contexts, those of context c follow the ones of context c - 1.
+   * @param num_actions The number of actions of each context.
+   * @param out_scores Receives the scores in the same order as the actions, must hold one score per action.
+   * @return int Returns 0 (S_VW_PREDICT_OK) if succesful, otherwise one of the error codes (see E_VW_PREDICT_ERR_*).
+   */
+  int predict_batch(example_predict* shared, size_t num_contexts, example_predict* actions, const size_t* num_actions,
+      float* out_scores)
+  {
+    for (size_t c = 0; c < num_contexts; c++)
     {
-      std::vector<std::unique_ptr<namespace_copy_guard>> ns_copy_guards;
-
-      // shared feature copying
-      for (auto ns : shared.indices)
-      {
-        // insert namespace
-        auto ns_copy_guard = std::unique_ptr<namespace_copy_guard>(new namespace_copy_guard(*action, ns));
-
-        // copy features
-        for (auto fs : shared.feature_space[ns]) ns_copy_guard->feature_push_back(fs.value(), fs.index());
-
-        // keep guard around
-        ns_copy_guards.push_back(std::move(ns_copy_guard));
-      }
-
-      RETURN_ON_FAIL(predict(*action, out_scores[i]));
+      RETURN_ON_FAIL(predict(shared[c], actions, num_actions[c], out_scores));
+      actions += num_actions[c];
+      out_scores += num_actions[c];
     }
 
     return S_VW_PREDICT_OK;
@@ -461,6 +455,17 @@ class vw_predict
 
   int predict(const char* event_id, example_predict& shared, example_predict* actions, size_t num_actions,
       std::vector<float>& pdf, std::vector<int>& ranking)
+  {
+    cb_predict_scratch scratch;
+    return predict(event_id, shared, actions, num_actions, pdf, ranking, scratch);
+  }
+
+  /**
+   * @brief Predicts as predict(event_id, shared, actions, num_actions, pdf, ranking) does, in caller provided scratch
+   * space. No memory is allocated once the scratch space, pdf and ranking hold num_actions actions.
+   */
+  int predict(const char* event_id, example_predict& shared, example_predict* actions, size_t num_actions,
+      std::vector<float>& pdf, std::vector<int>& ranking, cb_predict_scratch& scratch)
   {
     if (!_model_loaded)
       return E_VW_PREDICT_ERR_NO_MODEL_LOADED;
@@ -468,7 +473,8 @@ class vw_predict
     if (!is_cb_explore_adf())
       return E_VW_PREDICT_ERR_NOT_A_CB_MODEL;
 
-    std::vector<float> scores;
+    std::vector<float>& scores = scratch.scores;
+    scores.resize(num_actions);
 
     // add exploration
     pdf.resize(num_actions);
@@ -479,7 +485,7 @@ class vw_predict
       case vw_predict_exploration::epsilon_greedy:
       {
         // get the prediction
-        RETURN_ON_FAIL(predict(shared, actions, num_actions, scores));
+        RETURN_ON_FAIL(predict(shared, actions, num_actions, scores.data()));
 
         // generate exploration distribution
         // model is trained against cost -> minimum is better
@@ -493,7 +499,7 @@ class vw_predict
       case vw_predict_exploration::softmax:
       {
         // get the prediction
-        RETURN_ON_FAIL(predict(shared, actions, num_actions, scores));
+        RETURN_ON_FAIL(predict(shared, actions, num_actions, scores.data()));
 
         // generate exploration distribution
         RETURN_EXPLORATION_ON_FAIL(exploration::generate_softmax(
@@ -502,25 +508,13 @@ class vw_predict
       }
       case vw_predict_exploration::bag:
       {
-        std::vector<uint32_t> top_actions(num_actions);
-
-        // apply stride shifts
-        std::vector<std::unique_ptr<stride_shift_guard>> stride_shift_guards;
-        stride_shift_guards.push_back(
-            std::unique_ptr<stride_shift_guard>(new stride_shift_guard(shared, _stride_shift)));
-        example_predict* actions_end = actions + num_actions;
-        for (example_predict* action = actions; action != actions_end; ++action)
-          stride_shift_guards.push_back(
-              std::unique_ptr<stride_shift_guard>(new stride_shift_guard(*action, _stride_shift)));
+        std::vector<uint32_t>& top_actions = scratch.top_actions;
+        top_actions.assign(num_actions, 0);
 
+        // each bag uses its own weights: the feature indices are strided and offset by the bag
         for (size_t i = 0; i < _bag_size; i++)
         {
-          std::vector<std::unique_ptr<feature_offset_guard>> feature_offset_guards;
-          for (example_predict* action = actions; action != actions_end; ++action)
-            feature_offset_guards.push_back(
-                std::unique_ptr<feature_offset_guard>(new feature_offset_guard(*action, i)));
-
-          RETURN_ON_FAIL(predict(shared, actions, num_actions, scores));
+          score_actions(shared, actions, num_actions, true, i, _stride_shift, scores.data());
 
           auto top_action_iterator = std::min_element(std::begin(scores), std::end(scores));
           uint32_t top_action = (uint32_t)(top_action_iterator - std::begin(scores));
@@ -587,5 +581,222 @@ class vw_predict
   }
 
   uint32_t feature_index_num_bits() { return _num_bits; }
+
+ private:
+  static constexpr uint8_t GD_SAVED_RESUME = 1;
+  static constexpr uint8_t GD_SAVED_DENSE_IMAGE = 2;
+
+  // Reads the model, whose weights can be used where they lie if it is mapped from file.
+  int load(const char* model, size_t length, std::shared_ptr<mapped_file> file)
+  {
+    if (!model || length == 0)
+      return E_VW_PREDICT_ERR_INVALID_MODEL;
+
+    _model_loaded = false;
+
+    model_parser mp(model, length);
+
+    // parser_regressor.cc: save_load_header
+    RETURN_ON_FAIL(mp.read_string<false>("version", _version));
+
+    // read model id
+    RETURN_ON_FAIL(mp.read_string<true>("model_id", _id));
+
+    RETURN_ON_FAIL(mp.skip(sizeof(char)));   // "model character"
+    RETURN_ON_FAIL(mp.skip(sizeof(float)));  // "min_label"
+    RETURN_ON_FAIL(mp.skip(sizeof(float)));  // "max_label"
+
+    RETURN_ON_FAIL(mp.read("num_bits", _num_bits));
+
+    RETURN_ON_FAIL(mp.skip(sizeof(uint32_t)));  // "lda"
+
+    uint32_t ngram_len;
+    RETURN_ON_FAIL(mp.read("ngram_len", ngram_len));
+    mp.skip(3 * ngram_len);
+
+    uint32_t skips_len;
+    RETURN_ON_FAIL(mp.read("skips_len", skips_len));
+    mp.skip(3 * skips_len);
+
+    RETURN_ON_FAIL(mp.read_string<true>("file_options", _command_line_arguments));
+
+    // command line arg parsing
+    _no_constant = _command_line_arguments.find("--noconstant") != std::string::npos;
+
+    // only 0-valued hash_seed supported
+    int hash_seed;
+    if (find_opt_int(_command_line_arguments, "--hash_seed", hash_seed) && hash_seed)
+      return E_VW_PREDICT_ERR_HASH_SEED_NOT_SUPPORTED;
+
+    _interactions.clear();
+    find_opt(_command_line_arguments, "-q", _interactions);
+    find_opt(_command_line_arguments, "--quadratic", _interactions);
+    find_opt(_command_line_arguments, "--cubic", _interactions);
+    find_opt(_command_line_arguments, "--interactions", _interactions);
+
+    // VW performs the following transformation as a side-effect of looking for duplicates.
+    // This affects how interaction hashes are generated.
+    std::vector<std::vector<namespace_index>> vec_sorted;
+    for (auto &interaction : _interactions)
+    {
+      std::vector<namespace_index> sorted_i(interaction);
+      std::sort(std::begin(sorted_i), std::end(sorted_i));
+      vec_sorted.push_back(sorted_i);
+    }
+    _interactions = vec_sorted;
+
+    // TODO: take --cb_type dr into account
+    uint64_t num_weights = 0;
+
+    if (_command_line_arguments.find("--cb_explore_adf") != std::string::npos)
+    {
+      // parse exploration options
+      if (find_opt_int(_command_line_arguments, "--bag", _bag_size))
+      {
+        _exploration = vw_predict_exploration::bag;
+        num_weights = _bag_size;
+
+        // check for additional minimum epsilon greedy
+        _minimum_epsilon = 0.f;
+        find_opt_float(_command_line_arguments, "--epsilon", _minimum_epsilon);
+      }
+      else if (_command_line_arguments.find("--softmax") != std::string::npos)
+      {
+        if (find_opt_float(_command_line_arguments, "--lambda", _lambda))
+        {
+          if (_lambda > 0)  // Lambda should always be negative because we are using a cost basis.
+            _lambda = -_lambda;
+          _exploration = vw_predict_exploration::softmax;
+        }
+      }
+      else if (find_opt_float(_command_line_arguments, "--epsilon", _epsilon))
+        _exploration = vw_predict_exploration::epsilon_greedy;
+      else
+        return E_VW_PREDICT_ERR_CB_EXPLORATION_MISSING;
+    }
+
+    // VW style check_sum validation
+    uint32_t check_sum_computed = mp.checksum();
+
+    // perform check sum check
+    uint32_t check_sum_len;
+    RETURN_ON_FAIL((mp.read<uint32_t, false>("check_sum_len", check_sum_len)));
+    if (check_sum_len != sizeof(uint32_t))
+      return E_VW_PREDICT_ERR_INVALID_MODEL;
+
+    uint32_t check_sum;
+    RETURN_ON_FAIL((mp.read<uint32_t, false>("check_sum", check_sum)));
+
+    if (check_sum_computed != check_sum)
+      return E_VW_PREDICT_ERR_INVALID_MODEL_CHECK_SUM;
+
+    if (_command_line_arguments.find("--cb_adf") != std::string::npos)
+    {
+      RETURN_ON_FAIL(mp.skip(sizeof(uint64_t)));  // cb_adf.cc: event_sum
+      RETURN_ON_FAIL(mp.skip(sizeof(uint64_t)));  // cb_adf.cc: action_sum
+    }
+
+    // gd.cc: save_load, whether the online state was saved and whether the weights are a dense image
+    uint8_t gd_saved;
+    RETURN_ON_FAIL(mp.read("resume", gd_saved));
+    if (gd_saved & GD_SAVED_RESUME)
+      return E_VW_PREDICT_ERR_GD_RESUME_NOT_SUPPORTED;
+
+    _stride_shift = (uint32_t)ceil_log_2(num_weights);
+
+    std::unique_ptr<W> weights;
+    if (gd_saved & GD_SAVED_DENSE_IMAGE)
+    {
+      const float* image;
+      RETURN_ON_FAIL(mp.read_dense_image((uint64_t)1 << _num_bits, &image));
+
+      // a mapped image is used where it lies, as long as the weights keep the file mapped
+      W* image_weights = nullptr;
+      if (file != nullptr && reinterpret_cast<uintptr_t>(image) % alignof(float) == 0)
+        image_weights = internal::image_weights<W>::borrow(image, (uint64_t)1 << _num_bits);
+      if (image_weights != nullptr)
+      {
+        image_weights->stride_shift(_stride_shift);
+        _weights = std::shared_ptr<W>(image_weights, [file](W* w) { delete w; });
+      }
+      else
+        RETURN_ON_FAIL(mp.read_weights<W>(weights, image, _num_bits, _stride_shift));
+    }
+    else
+      // read sparse weights into dense
+      RETURN_ON_FAIL(mp.read_weights<W>(weights, _num_bits, _stride_shift));
+
+    if (weights)
+      _weights = std::move(weights);
+
+    // TODO: check that permutations is not enabled (or parse it)
+
+    _model_loaded = true;
+
+    return S_VW_PREDICT_OK;
+  }
+
+  predict_kernel<W> make_kernel(
+      example_predict& ex, example_predict* shared, const bool* shared_namespaces, uint64_t offset, uint32_t shift)
+  {
+    return predict_kernel<W>(*_weights, _functions, ex, shared, shared_namespaces, offset, shift, !_no_constant,
+        (constant << _stride_shift) + offset);
+  }
+
+  // Scores the actions as if the shared features were copied into each of them. The feature offset is the one of each
+  // action unless fixed_offset is set.
+  void score_actions(example_predict& shared, example_predict* actions, size_t num_actions, bool fixed_offset,
+      uint64_t offset, uint32_t shift, float* out_scores)
+  {
+    bool shared_namespaces[NUM_NAMESPACES] = {};
+    for (namespace_index ns : shared.indices) shared_namespaces[ns] = true;
+
+    // The linear terms of the shared features and the interactions among shared namespaces only, which are the same
+    // for all actions of the same offset.
+    bool shared_computed = false;
+    uint64_t shared_offset = 0;
+    float shared_linear = 0.f;
+    float shared_interactions = 0.f;
+
+    for (size_t a = 0; a < num_actions; a++)
+    {
+      example_predict& action = actions[a];
+      const uint64_t action_offset = fixed_offset ? offset : action.ft_offset;
+
+      if (!shared_computed || shared_offset != action_offset)
+      {
+        // The kernel of the shared example alone, whose linear terms do not include the constant.
+        const predict_kernel<W> shared_kernel(
+            *_weights, _functions, shared, nullptr, nullptr, action_offset, shift, false, 0);
+        shared_linear = shared_kernel.linear(0.f);
+        shared_interactions = 0.f;
+        for (auto& interaction : _interactions)
+          if (is_shared_only(interaction, shared_namespaces))
+            shared_interactions = shared_kernel.interaction(interaction, shared_interactions);
+        shared_computed = true;
+        shared_offset = action_offset;
+      }
+
+      // An action with features in a shared namespace combines them with the shared ones in shared only interactions.
+      bool overlap = false;
+      for (namespace_index ns : shared.indices) overlap |= action.feature_space[ns].nonempty();
+
+      const predict_kernel<W> kernel = make_kernel(action, &shared, shared_namespaces, action_offset, shift);
+      float score = kernel.linear(overlap ? shared_linear : shared_linear + shared_interactions);
+      for (auto& interaction : _interactions)
+        if (overlap || !is_shared_only(interaction, shared_namespaces))
+          score = kernel.interaction(interaction, score);
+
+      out_scores[a] = score;
+    }
+  }
+
+  static bool is_shared_only(const std::vector<namespace_index>& interaction, const bool* shared_namespaces)
+  {
+    for (namespace_index ns : interaction)
+      if (!shared_namespaces[ns])
+        return false;
+    return true;
+  }
 };
 }  // namespace vw_slim
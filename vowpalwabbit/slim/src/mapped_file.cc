@@ -0,0 +1,98 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vw_slim
+{
+#ifdef _WIN32
+mapped_file::mapped_file() : _data(nullptr), _size(0), _mapping(nullptr) {}
+
+mapped_file::~mapped_file()
+{
+  if (_data != nullptr)
+    UnmapViewOfFile(_data);
+  if (_mapping != nullptr)
+    CloseHandle(_mapping);
+}
+
+int mapped_file::open(const char* filename)
+{
+  HANDLE file = CreateFileA(
+      filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+  {
+    CloseHandle(file);
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+  }
+  if (size.QuadPart == 0)
+  {
+    CloseHandle(file);
+    return S_VW_PREDICT_OK;
+  }
+
+  // the mapping keeps the file open
+  _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (_mapping == nullptr)
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+
+  _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (_data == nullptr)
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+  _size = static_cast<size_t>(size.QuadPart);
+
+  return S_VW_PREDICT_OK;
+}
+#else
+mapped_file::mapped_file() : _data(nullptr), _size(0) {}
+
+mapped_file::~mapped_file()
+{
+  if (_data != nullptr)
+    munmap(const_cast<char*>(_data), _size);
+}
+
+int mapped_file::open(const char* filename)
+{
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+  }
+  if (st.st_size == 0)
+  {
+    close(fd);
+    return S_VW_PREDICT_OK;
+  }
+
+  // the mapping keeps the file open
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return E_VW_PREDICT_ERR_MODEL_FILE;
+
+  _data = static_cast<const char*>(data);
+  _size = static_cast<size_t>(st.st_size);
+
+  return S_VW_PREDICT_OK;
+}
+#endif
+}  // namespace vw_slim
@@ -0,0 +1,161 @@
+#include "predict_kernel.h"
+
+#if !defined(VW_NO_INLINE_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define VW_SLIM_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC allows AVX2 intrinsics in any function.
+#define VW_SLIM_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define VW_SLIM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace vw_slim
+{
+namespace internal
+{
+namespace
+{
+float dot_scalar(const float* weights, uint64_t mask, const feature_span& fs, size_t begin, size_t end, uint64_t hash,
+    float x, uint64_t offset, float sum)
+{
+  for (size_t i = begin; i < end; i++)
+    sum += weights[(((fs.indices[i] << fs.shift) ^ hash) + offset) & mask] * (x * fs.values[i]);
+  return sum;
+}
+
+void hash_scalar(const feature_span& fs, size_t begin, size_t end, uint64_t hash, uint64_t* out)
+{
+  for (size_t i = begin; i < end; i++) out[i - begin] = FNV_prime * (hash ^ (fs.indices[i] << fs.shift));
+}
+
+#ifdef VW_SLIM_SIMD
+VW_SLIM_TARGET_AVX2 inline float horizontal_sum(__m256 sum)
+{
+  __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_add_ss(half, _mm_movehdup_ps(half));
+  return _mm_cvtss_f32(half);
+}
+
+// The weight indices of 4 features.
+VW_SLIM_TARGET_AVX2 inline __m256i weight_indices(
+    const uint64_t* indices, __m128i shift, __m256i hash, __m256i offset, __m256i mask)
+{
+  const __m256i shifted = _mm256_sll_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), shift);
+  return _mm256_and_si256(_mm256_add_epi64(_mm256_xor_si256(shifted, hash), offset), mask);
+}
+
+VW_SLIM_TARGET_AVX2 float dot_avx2(const float* weights, uint64_t mask, const feature_span& fs, size_t begin,
+    size_t end, uint64_t hash, float x, uint64_t offset, float sum)
+{
+  const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(fs.shift));
+  const __m256i hashes = _mm256_set1_epi64x(static_cast<long long>(hash));
+  const __m256i offsets = _mm256_set1_epi64x(static_cast<long long>(offset));
+  const __m256i masks = _mm256_set1_epi64x(static_cast<long long>(mask));
+  const __m256 xs = _mm256_set1_ps(x);
+  __m256 lanes = _mm256_setzero_ps();
+
+  size_t i = begin;
+  for (; i + 8 <= end; i += 8)
+  {
+    // Indices are 64 bits, so a gather fetches 4 weights.
+    const __m256i low = weight_indices(fs.indices + i, shift, hashes, offsets, masks);
+    const __m256i high = weight_indices(fs.indices + i + 4, shift, hashes, offsets, masks);
+    const __m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_i64gather_ps(weights, low, sizeof(float))),
+        _mm256_i64gather_ps(weights, high, sizeof(float)), 1);
+    lanes = _mm256_fmadd_ps(w, _mm256_mul_ps(xs, _mm256_loadu_ps(fs.values + i)), lanes);
+  }
+
+  if (i != begin)
+    sum += horizontal_sum(lanes);
+  return dot_scalar(weights, mask, fs, i, end, hash, x, offset, sum);
+}
+
+VW_SLIM_TARGET_AVX2 void hash_avx2(const feature_span& fs, size_t begin, size_t end, uint64_t hash, uint64_t* out)
+{
+  const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(fs.shift));
+  const __m256i hashes = _mm256_set1_epi64x(static_cast<long long>(hash));
+  const __m256i prime = _mm256_set1_epi64x(FNV_prime);
+
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4)
+  {
+    const __m256i h = _mm256_xor_si256(
+        _mm256_sll_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(fs.indices + i)), shift), hashes);
+    // There is no 64 bit multiply, the prime fits in 32 bits so it is the sum of the products of both halves.
+    const __m256i low = _mm256_mul_epu32(h, prime);
+    const __m256i high = _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(h, 32), prime), 32);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i - begin), _mm256_add_epi64(low, high));
+  }
+  hash_scalar(fs, i, end, hash, out + i - begin);
+}
+
+void cpuid(unsigned leaf, unsigned regs[4])
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuidex(info, leaf, 0);
+  for (int r = 0; r < 4; r++) regs[r] = static_cast<unsigned>(info[r]);
+#else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+bool avx2_supported()
+{
+  unsigned regs[4];
+  cpuid(0, regs);
+  if (regs[0] < 7)
+    return false;
+
+  cpuid(1, regs);
+  const bool fma = (regs[2] & (1u << 12)) != 0;
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+  if (!fma || !osxsave)
+    return false;
+
+  // The operating system must save the AVX registers on context switches.
+#ifdef _MSC_VER
+  const uint64_t state = _xgetbv(0);
+#else
+  unsigned low, high;
+  __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+  const uint64_t state = (static_cast<uint64_t>(high) << 32) | low;
+#endif
+  if ((state & 0x6) != 0x6)
+    return false;
+
+  cpuid(7, regs);
+  return (regs[1] & (1u << 5)) != 0;
+}
+#endif
+}  // namespace
+
+const simd_functions& scalar_functions()
+{
+  static const simd_functions functions = {dot_scalar, hash_scalar};
+  return functions;
+}
+
+const simd_functions* avx2_functions()
+{
+#ifdef VW_SLIM_SIMD
+  static const simd_functions functions = {dot_avx2, hash_avx2};
+  static const bool supported = avx2_supported();
+  return supported ? &functions : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+const simd_functions& fastest_functions()
+{
+  const simd_functions* avx2 = avx2_functions();
+  return avx2 != nullptr ? *avx2 : scalar_functions();
+}
+}  // namespace internal
+}  // namespace vw_slim
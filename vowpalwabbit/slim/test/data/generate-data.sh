@@ -63,6 +63,10 @@ $VW --quiet -d regression_data_7.txt -i regression_data_7.model -t -p regression
 xxd -i regression_data_7.model >> $DATA_H
 xxd -i regression_data_7.pred  >> $DATA_H
 
+# testing models mapped from file, which are not embedded
+$VW --quiet -d regression_data_3.txt -f regression_data_3_dense_image.model -c -k --passes 100 --holdout_off -q ab -b 10 --dense_image
+$VW --quiet -d regression_data_3.txt -i regression_data_3_dense_image.model -t -p regression_data_3_dense_image.pred
+
 # multi-class classification
 $VW --quiet -d multiclass_data_4.txt --csoaa_ldf m --csoaa_rank -q ab -k -c --holdout_off --passes 100 -f multiclass_data_4.model
 $VW --quiet -d multiclass_data_4.txt -i multiclass_data_4.model -t -p multiclass_data_4.pred
@@ -10,6 +10,10 @@
 #include <array>
 
 #include <fstream>
+#include <atomic>
+#include <new>
+#include <random>
+#include <thread>
 #include "example_predict_builder.h"
 #include "array_parameters.h"
 #include "data.h"
@@ -206,6 +210,10 @@ void run_predict_in_memory(
       ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(e, score));
       preds.push_back(score);
     }
+
+    std::vector<float> batch_preds(2);
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(ex, 2, batch_preds.data()));
+    EXPECT_THAT(batch_preds, Pointwise(FloatNearPointwise(1e-6f), preds));
   }
   else
     FAIL() << "Unknown data file: " << data_filename;
@@ -379,6 +387,64 @@ TEST(VowpalWabbitSlim, multiclass_data_4)
   EXPECT_THAT(out_scores, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
 }
 
+TEST(VowpalWabbitSlim, multiclass_data_4_batch)
+{
+  vw_predict<sparse_parameters> vw;
+  test_data td = get_test_data("multiclass_data_4");
+  ASSERT_EQ(0, vw.load((const char*)td.model, td.model_len));
+
+  safe_example_predict shared[2];
+  safe_example_predict actions[5];
+
+  // shared |a 0:1 5:12
+  example_predict_builder bs0(&shared[0], (char*)"a");
+  bs0.push_feature(0, 1.f);
+  bs0.push_feature(5, 12.f);
+  // |b 0:1, |b 0:2, |b 0:3
+  for (int i = 0; i < 3; i++)
+  {
+    example_predict_builder b(&actions[i], (char*)"b");
+    b.push_feature(0, (float)(i + 1));
+  }
+
+  // shared |a 1:2 |b 4:1, so that the interaction is computed on the shared features alone
+  example_predict_builder bs1a(&shared[1], (char*)"a");
+  bs1a.push_feature(1, 2.f);
+  example_predict_builder bs1b(&shared[1], (char*)"b");
+  bs1b.push_feature(4, 1.f);
+  // |c 2:1
+  example_predict_builder b3(&actions[3], (char*)"c");
+  b3.push_feature(2, 1.f);
+  // |a 3:1, which is merged with the shared namespace
+  example_predict_builder b4(&actions[4], (char*)"a");
+  b4.push_feature(3, 1.f);
+
+  size_t num_actions[] = {3, 2};
+  std::vector<float> out_scores(5);
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(shared, 2, actions, num_actions, out_scores.data()));
+
+  // the actions of the second context with the shared features written into them
+  safe_example_predict no_shared;
+  safe_example_predict merged[2];
+  example_predict_builder m0c(&merged[0], (char*)"c");
+  m0c.push_feature(2, 1.f);
+  example_predict_builder m0a(&merged[0], (char*)"a");
+  m0a.push_feature(1, 2.f);
+  example_predict_builder m0b(&merged[0], (char*)"b");
+  m0b.push_feature(4, 1.f);
+  example_predict_builder m1a(&merged[1], (char*)"a");
+  m1a.push_feature(3, 1.f);
+  m1a.push_feature(1, 2.f);
+  example_predict_builder m1b(&merged[1], (char*)"b");
+  m1b.push_feature(4, 1.f);
+
+  std::vector<float> merged_scores;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(no_shared, merged, 2, merged_scores));
+
+  std::vector<float> preds_expected = {0.901038f, 0.46983f, 0.0386223f, merged_scores[0], merged_scores[1]};
+  EXPECT_THAT(out_scores, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
+}
+
 void cb_data_epsilon_0_skype_jb_test_runner(int call_type, int modality, int network_type, int platform,
     std::vector<int> ranking_expected, std::vector<float> pdf_expected)
 {
@@ -641,6 +707,135 @@ CBPredictParam cb_predict_params[] = {
 
 INSTANTIATE_TEST_SUITE_P(VowpalWabbitSlim, CBPredictTest, ::testing::ValuesIn(cb_predict_params));
 
+// Counts the allocations of the test binary while enabled.
+static std::atomic<bool> count_allocations(false);
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+  if (count_allocations)
+    allocations++;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+struct allocation_counter
+{
+  allocation_counter()
+  {
+    allocations = 0;
+    count_allocations = true;
+  }
+  ~allocation_counter() { count_allocations = false; }
+
+  size_t count() const { return allocations; }
+};
+
+TEST(VowpalWabbitSlim, predict_does_not_allocate)
+{
+  float score;
+  {
+    vw_predict<sparse_parameters> vw;
+    test_data td = get_test_data("regression_data_3");
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.load((const char*)td.model, td.model_len));
+
+    // |a 0:1 1:2 |b 0:3 1:4
+    safe_example_predict ex;
+    example_predict_builder ba(&ex, (char*)"a");
+    ba.push_feature(0, 1.f);
+    ba.push_feature(1, 2.f);
+    example_predict_builder bb(&ex, (char*)"b");
+    bb.push_feature(0, 3.f);
+    bb.push_feature(1, 4.f);
+
+    allocation_counter counter;
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(ex, score));
+    EXPECT_EQ(0, counter.count());
+  }
+
+  safe_example_predict shared;
+  safe_example_predict actions[3];
+  generate_cb_data_5(shared, actions);
+  std::vector<float> scores(3);
+  std::vector<float> pdf;
+  std::vector<int> ranking;
+  const std::string seed = generate_string_seed(0);
+
+  for (const char* model : {"multiclass_data_4", "cb_data_5", "cb_data_7"})
+  {
+    vw_predict<sparse_parameters> vw;
+    test_data td = get_test_data(model);
+    ASSERT_EQ(S_VW_PREDICT_OK, vw.load((const char*)td.model, td.model_len));
+
+    if (vw.is_cb_explore_adf())
+    {
+      std::vector<float> pdf_expected;
+      std::vector<int> ranking_expected;
+      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(seed.c_str(), shared, actions, 3, pdf_expected, ranking_expected));
+
+      // the first predict sizes the outputs
+      cb_predict_scratch scratch;
+      scratch.reserve(3);
+      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(seed.c_str(), shared, actions, 3, pdf, ranking, scratch));
+      allocation_counter counter;
+      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(seed.c_str(), shared, actions, 3, pdf, ranking, scratch));
+      EXPECT_EQ(0, counter.count()) << model;
+      EXPECT_EQ(pdf_expected, pdf) << model;
+      EXPECT_EQ(ranking_expected, ranking) << model;
+    }
+    else
+    {
+      allocation_counter counter;
+      ASSERT_EQ(S_VW_PREDICT_OK, vw.predict(shared, actions, 3, scores.data()));
+      EXPECT_EQ(0, counter.count()) << model;
+    }
+  }
+}
+
+TEST(VowpalWabbitSlim, simd_functions_match_scalar)
+{
+  const vw_slim::internal::simd_functions* avx2 = vw_slim::internal::avx2_functions();
+  if (avx2 == nullptr)
+    return;
+  const vw_slim::internal::simd_functions& scalar = vw_slim::internal::scalar_functions();
+
+  std::mt19937_64 rng(42);
+  const uint64_t mask = (1 << 12) - 1;
+  std::vector<float> weights(mask + 1);
+  for (auto& w : weights) w = (float)(rng() % 1000) / 1000.f - 0.5f;
+
+  // lengths around the vector widths, with a tail
+  for (size_t size = 0; size < 21; size++)
+  {
+    std::vector<uint64_t> indices(size);
+    std::vector<float> values(size);
+    for (size_t i = 0; i < size; i++)
+    {
+      indices[i] = rng();
+      values[i] = (float)(rng() % 100) / 10.f;
+    }
+
+    for (uint32_t shift : {0u, 2u})
+    {
+      const feature_span fs = {values.data(), indices.data(), size, shift};
+      const uint64_t hash = rng();
+      const size_t begin = size / 3;
+
+      EXPECT_NEAR(scalar.dot(weights.data(), mask, fs, begin, size, hash, 0.5f, 3, 1.f),
+          avx2->dot(weights.data(), mask, fs, begin, size, hash, 0.5f, 3, 1.f), 1e-4f);
+
+      std::vector<uint64_t> expected(size), actual(size);
+      scalar.hash(fs, begin, size, hash, expected.data());
+      avx2->hash(fs, begin, size, hash, actual.data());
+      EXPECT_EQ(expected, actual);
+    }
+  }
+}
+
 // Test fixture to allow for both sparse and dense parameters
 template <typename W>
 class VwSlimTest : public ::testing::Test
@@ -661,6 +856,7 @@ TYPED_TEST_P(VwSlimTest, model_not_loaded)
   float score;
 
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict(ex, score));
+  EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict_batch(&ex, 1, &score));
 
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict(ex, actions, 0, scores));
   EXPECT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, vw.predict("abc", ex, actions, 0, scores, ranking));
@@ -706,7 +902,73 @@ TYPED_TEST_P(VwSlimTest, model_corrupted)
   }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(VwSlimTest, model_not_loaded, model_reduction_mismatch, model_corrupted);
+// |a 0:1 |b 2:2 and |a 0:1 |b 2:4, see regression_data_3.txt
+template <typename W>
+void predict_regression_data_3(vw_predict<W>& vw, std::vector<float>& preds)
+{
+  safe_example_predict ex[2];
+  for (int i = 0; i < 2; i++)
+  {
+    example_predict_builder ba(&ex[i], (char*)"a", vw.feature_index_num_bits());
+    ba.push_feature(0, 1.f);
+    example_predict_builder bb(&ex[i], (char*)"b", vw.feature_index_num_bits());
+    bb.push_feature(2, 2.f * (i + 1));
+  }
+
+  preds.resize(2);
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.predict_batch(ex, 2, preds.data()));
+}
+
+TYPED_TEST_P(VwSlimTest, model_mapped_from_file)
+{
+  std::vector<float> preds_expected = read_floats("data/regression_data_3_dense_image.pred");
+
+  vw_predict<TypeParam> vw;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw.load_file("data/regression_data_3_dense_image.model"));
+  std::vector<float> preds;
+  predict_regression_data_3(vw, preds);
+  EXPECT_THAT(preds, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
+
+  // the same model read from memory, whose weights are copied
+  std::ifstream input("data/regression_data_3_dense_image.model", std::ios::in | std::ios::binary);
+  std::vector<char> model((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  vw_predict<TypeParam> vw_copy;
+  ASSERT_EQ(S_VW_PREDICT_OK, vw_copy.load(model.data(), model.size()));
+  predict_regression_data_3(vw_copy, preds);
+  EXPECT_THAT(preds, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
+
+  // a truncated image
+  EXPECT_EQ(E_VW_PREDICT_ERR_INVALID_MODEL, vw_copy.load(model.data(), model.size() - sizeof(float)));
+
+  EXPECT_EQ(E_VW_PREDICT_ERR_MODEL_FILE, vw.load_file("data/does_not_exist.model"));
+}
+
+TYPED_TEST_P(VwSlimTest, model_shared_by_threads)
+{
+  std::vector<float> preds_expected = read_floats("data/regression_data_3_dense_image.pred");
+
+  std::vector<vw_predict<TypeParam>> predictors(4);
+  ASSERT_EQ(E_VW_PREDICT_ERR_NO_MODEL_LOADED, predictors[1].load(predictors[0]));
+  {
+    vw_predict<TypeParam> loader;
+    ASSERT_EQ(S_VW_PREDICT_OK, loader.load_file("data/regression_data_3_dense_image.model"));
+    for (auto& vw : predictors) ASSERT_EQ(S_VW_PREDICT_OK, vw.load(loader));
+  }
+
+  // the weights outlive the instance which loaded them
+  std::vector<std::vector<float>> preds(predictors.size());
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < predictors.size(); t++)
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 100; i++) predict_regression_data_3(predictors[t], preds[t]);
+    });
+  for (auto& thread : threads) thread.join();
+
+  for (auto& p : preds) EXPECT_THAT(p, Pointwise(FloatNearPointwise(1e-5f), preds_expected));
+}
+
+REGISTER_TYPED_TEST_SUITE_P(VwSlimTest, model_not_loaded, model_reduction_mismatch, model_corrupted,
+    model_mapped_from_file, model_shared_by_threads);
 INSTANTIATE_TYPED_TEST_SUITE_P(VowpalWabbitSlim, VwSlimTest, WeightParameters);
 
 TEST(ColdStartModel, action_set_not_reordered)
@@ -7,6 +7,28 @@
 #include "vw.h"
 #include "allreduce.h"
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+// Mutex and CV cannot be used in managed C++, tell the compiler that this is unmanaged even if included in a managed
+// project.
+#ifdef _M_CEE
+#pragma managed(push, off)
+#undef _M_CEE
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#define _M_CEE 001
+#pragma managed(pop)
+#else
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#endif
+
 template <class T, void (*f)(T&, const T&)>
 void all_reduce(vw& all, T* buffer, const size_t n)
 {
@@ -21,3 +43,108 @@ void all_reduce(vw& all, T* buffer, const size_t n)
       break;
   }
 }
+
+namespace VW
+{
+// Runs all_reduce on consecutive chunks of a buffer, in order, on a single thread of its own, so that the caller can
+// fill the next chunk and use the sums of the previous one meanwhile. A chunk is reduced once the caller has marked it
+// loaded and must be left alone until it is reduced.
+template <class T, void (*f)(T&, const T&)>
+class chunked_all_reduce
+{
+ public:
+  chunked_all_reduce(vw& all, T* buffer, size_t length, size_t chunk)
+      : _all(all), _buffer(buffer), _length(length), _chunk(chunk), _worker(&chunked_all_reduce::reduce_all, this)
+  {
+  }
+
+  chunked_all_reduce(const chunked_all_reduce&) = delete;
+  chunked_all_reduce& operator=(const chunked_all_reduce&) = delete;
+
+  ~chunked_all_reduce()
+  {
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _abort = true;
+    }
+    _changed.notify_all();
+    _worker.join();
+  }
+
+  // The buffer up to end is ready to be reduced.
+  void loaded(size_t end)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _loaded = end;
+    }
+    _changed.notify_all();
+  }
+
+  // Waits until the buffer up to end holds the sums, and rethrows what all_reduce threw if it failed.
+  void wait_reduced(size_t end)
+  {
+    std::unique_lock<std::mutex> lock(_lock);
+    _changed.wait(lock, [&] { return _reduced >= end || _error; });
+    if (_error)
+      std::rethrow_exception(_error);
+  }
+
+ private:
+  void reduce_all()
+  {
+    for (size_t begin = 0; begin < _length; begin += _chunk)
+    {
+      const size_t end = std::min(begin + _chunk, _length);
+      {
+        std::unique_lock<std::mutex> lock(_lock);
+        _changed.wait(lock, [&] { return _loaded >= end || _abort; });
+        if (_loaded < end)
+          return;
+      }
+
+      try
+      {
+        all_reduce<T, f>(_all, _buffer + begin, end - begin);
+      }
+      catch (...)
+      {
+        std::unique_lock<std::mutex> lock(_lock);
+        _error = std::current_exception();
+        _changed.notify_all();
+        return;
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(_lock);
+        _reduced = end;
+      }
+      _changed.notify_all();
+    }
+  }
+
+  vw& _all;
+  T* _buffer;
+  const size_t _length;
+  const size_t _chunk;
+
+  std::mutex _lock;
+  std::condition_variable _changed;
+  size_t _loaded = 0;
+  size_t _reduced = 0;
+  bool _abort = false;
+  std::exception_ptr _error;
+
+  std::thread _worker;
+};
+
+// Starts reducing the whole buffer on a thread of its own and returns at once. The buffer must be left alone until
+// get() or wait() on the future returns; get() rethrows what all_reduce threw.
+template <class T, void (*f)(T&, const T&)>
+std::future<void> all_reduce_async(vw& all, T* buffer, const size_t n)
+{
+  auto reduce = std::make_shared<chunked_all_reduce<T, f>>(all, buffer, n, std::max<size_t>(n, 1));
+  reduce->loaded(n);
+  return std::async(std::launch::deferred, [reduce, n] { reduce->wait_reduced(n); });
+}
+}  // namespace VW